@@ -127,16 +127,22 @@ namespace Hermes
       ///
       /// Functions used for evaluating the actual error estimator forms for an active element or edge segment.
       ///
+      /// The solutions are passed in slns (per-thread copies of sln).
+      ///
       double eval_volumetric_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
-                                       RefMap* rm);
+                                       RefMap* rm,
+                                       Solution<Scalar>** slns);
       double eval_boundary_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
                                      RefMap* rm,
-                                     SurfPos* surf_pos);
+                                     SurfPos* surf_pos,
+                                     Solution<Scalar>** slns);
       double eval_interface_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
                                       RefMap *rm,
                                       SurfPos* surf_pos,
                                       LightArray<NeighborSearch<Scalar>*>& neighbor_searches,
-                                      int neighbor_index);
+                                      int neighbor_index,
+                                      unsigned int min_dg_mesh_seq,
+                                      Solution<Scalar>** slns);
       double eval_solution_norm(typename Adapt<Scalar>::MatrixFormVolError* form,
                                 RefMap* rm,
                                 MeshFunction<Scalar>* sln);
@@ -177,6 +183,13 @@ namespace Hermes
                                        Hermes::vector<double>* component_errors,
                                        unsigned int error_flags);
 
+      /// Evaluates all the estimators (and the norms if calc_norm) in one union mesh state.
+      /// The estimates are added to errors (and norms), one entry per component. The interface estimates belonging
+      /// to the elements on the other side of the evaluated segments (with ignore_visited_segments) are appended
+      /// to neighbor_errors as pairs (element id, estimate).
+      void calc_err_state(Traverse::State* ee, Solution<Scalar>** slns, Transformable** fns, unsigned int min_dg_mesh_seq,
+                          bool calc_norm, double* errors, double* norms, Hermes::vector<std::pair<int, double> >* neighbor_errors);
+
     public:
 
       /// Constructor.
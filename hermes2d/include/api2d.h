@@ -39,9 +39,24 @@ namespace Hermes
     {
       numThreads,
 			xmlSchemasDirPath,
-			precalculatedFormsDirPath
+			precalculatedFormsDirPath,
+			/// Store the precalculated data (CurvMap projection matrices) to precalculatedFormsDirPath (1),
+			/// or only read them from there (0, default).
+			storePrecalculatedForms,
+			/// Ordering of DOFs produced by Space::assign_dofs(), one of DofOrdering.
+			dofOrdering
     };
 
+		/// Orderings of the DOFs within one Space.
+		enum DofOrdering
+		{
+			/// Vertex, edge and bubble DOFs, each group in the order of the element table (default).
+			HERMES_DOF_ORDERING_NATIVE,
+			/// Reverse Cuthill-McKee ordering of the DOF blocks (the DOFs of one node, or of the interior of one element).
+			/// Reduces the bandwidth of the matrices and improves the locality of accesses to coefficient vectors.
+			HERMES_DOF_ORDERING_RCM
+		};
+
     /// API Class containing settings for the whole Hermes2D.
     class HERMES_API Api2D
     {
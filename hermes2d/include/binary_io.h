@@ -0,0 +1,148 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_BINARY_IO_H
+#define __H2D_BINARY_IO_H
+
+#include "hermes_common.h"
+#include <cstdio>
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// \brief Memory mapping of a binary file, kept alive by the owner of the arrays mapped from it.
+    class HERMES_API BinaryMapping
+    {
+    public:
+      ~BinaryMapping();
+
+    protected:
+      BinaryMapping(void* data, size_t size);
+
+      void* data;
+      size_t size;
+
+      friend class BinaryReader;
+    };
+
+    /// \brief Writer of the versioned binary format used by Solution::save_binary(), Space::save_binary() and MeshReaderBinary.
+    ///
+    /// The file starts with a 32 byte header (8 byte magic, byte order mark, format version, flags), followed by sections.
+    /// Each section is an array of items of one size, stored after a 32 byte descriptor (item size, encoding, item count, stored size).
+    /// The data of every section starts at a 16 byte aligned offset, so that raw sections can be used in place from a memory-mapped file.
+    ///
+    /// With compression (needs WITH_ZLIB), the bytes of the items are shuffled (all first bytes, then all second bytes, ...)
+    /// and deflated, which works much better on floating point coefficients than deflating them directly.
+    /// Sections that do not get smaller are stored raw.
+    class HERMES_API BinaryWriter
+    {
+    public:
+      /// Opens the file and writes the header.
+      /// \param[in] magic Identification of the contents, exactly 8 characters.
+      BinaryWriter(const char* filename, const char* magic, unsigned int version, bool compress = false);
+      ~BinaryWriter();
+
+      /// Writes an array of count items of item_size bytes.
+      void write_section(const void* data, unsigned int item_size, unsigned long long count);
+
+      /// Writes an array of ints.
+      void write_ints(const int* data, unsigned long long count);
+
+      /// Flushes and closes the file, reporting write errors.
+      void close();
+
+    protected:
+      void write(const void* data, size_t size);
+      void write_padding(size_t size);
+
+      FILE* file;
+      std::string filename;
+      bool compress;
+    };
+
+    /// \brief Reader of files written by BinaryWriter.
+    /// Sections have to be read in the order they were written.
+    class HERMES_API BinaryReader
+    {
+    public:
+      /// Opens the file and checks the header.
+      /// \param[in] magic Expected identification of the contents.
+      /// \param[in] max_version The newest format version the caller understands.
+      /// \param[in] memory_map Map the file into memory (POSIX systems), so that raw sections can be used in place,
+      /// see map_section().
+      BinaryReader(const char* filename, const char* magic, unsigned int max_version, bool memory_map = false);
+      ~BinaryReader();
+
+      /// Returns true if the file exists and starts with the given magic.
+      static bool is_binary_file(const char* filename, const char* magic);
+
+      /// Format version of the file.
+      unsigned int get_version() const;
+
+      /// True if the file was written with compression, i.e. some of its sections may be compressed.
+      bool is_compressed() const;
+
+      /// True if the file is memory-mapped (until release_mapping()).
+      bool is_mapped() const;
+
+      /// Number of items in the next section, checks that the items have item_size bytes.
+      unsigned long long next_section_count(unsigned int item_size);
+
+      /// Reads the next section into data, which has to hold next_section_count() items.
+      void read_section(void* data);
+
+      /// Reads the next section of ints, which has to have exactly count items.
+      void read_ints(int* data, unsigned long long count);
+
+      /// Returns a pointer to the data of the next section inside the memory-mapped file and skips the section,
+      /// NULL if the file is not mapped or the section is compressed (use read_section() then).
+      /// The pointer is writable (private copy-on-write mapping) and stays valid as long as the mapping returned
+      /// by release_mapping() exists.
+      void* map_section();
+
+      /// Hands over the ownership of the mapping to the caller, NULL if the file is not mapped.
+      /// No sections can be read afterwards.
+      BinaryMapping* release_mapping();
+
+    protected:
+      struct SectionDescriptor
+      {
+        unsigned int item_size;
+        unsigned int encoding;
+        unsigned long long count;
+        unsigned long long stored_size;
+        unsigned long long reserved;
+      };
+
+      void read(void* data, size_t size);
+      void skip(size_t size);
+      void read_descriptor();
+
+      FILE* file;
+      std::string filename;
+      unsigned int version;
+      unsigned int flags;
+
+      /// Memory-mapped contents and the current position in them.
+      BinaryMapping* mapping;
+      size_t position;
+
+      SectionDescriptor descriptor;
+      bool have_descriptor;
+    };
+  }
+}
+#endif
@@ -74,6 +74,16 @@ namespace Hermes
         onlyNumber
       };
 
+      /// Choose the format of the stored meshes, spaces and solutions.
+      /// The binary formats (see MeshReaderBinary, Space::save_binary(), Solution::save_binary()) are much faster and smaller than XML,
+      /// the compressed one needs Hermes built with WITH_ZLIB. Loading recognizes the format automatically.
+      enum StorageFormat
+      {
+        storageXML,
+        storageBinary,
+        storageBinaryCompressed
+      };
+
       CalculationContinuity(IdentificationMethod identification_method);
 
       /// One record of the calculation. Stores every information to resume a calculation from this one point.
@@ -185,6 +195,15 @@ namespace Hermes
       static void set_time_step_file_name(std::string time_step_file_nameToSet);
       static void set_error_file_name(std::string error_file_nameToSet);
 
+      /// Setting of the format of the stored meshes, spaces and solutions.
+      /// Default: storageXML.
+      static void set_storage_format(StorageFormat storage_formatToSet);
+
+      /// Solutions stored in the binary format are loaded memory-mapped, i.e. their coefficient arrays
+      /// are used directly from the file (see Solution::load_binary()).
+      /// Default: false.
+      static void set_memory_mapped_loading(bool memory_mapped_loadingToSet);
+
     private:
       /// Names for the file stored.
       static std::string mesh_file_name;
@@ -194,6 +213,16 @@ namespace Hermes
       static std::string time_stepNMinusOne_file_name;
       static std::string error_file_name;
 
+      /// Storage settings.
+      static StorageFormat storage_format;
+      static bool memory_mapped_loading;
+
+      /// Save / load of one mesh, space or solution according to the storage settings.
+      static void save_mesh_file(Mesh* mesh, const char* filename);
+      static void save_space_file(Space<Scalar>* space, const char* filename);
+      static void save_solution_file(Solution<Scalar>* solution, const char* filename);
+      static void load_solution_file(Solution<Scalar>* solution, Space<Scalar>* space, const char* filename);
+
       /// For time dependent adaptive problems.
       std::map<std::pair<double, unsigned int>, Record*> records;
 
@@ -89,6 +89,25 @@ namespace Hermes
       /// If the cache should not be used for any reason.
       inline void set_do_not_use_cache() { this->do_not_use_cache = true; }
 
+      /// Limit of the (estimated) memory held by the cache, in bytes, 0 (default) means no limit.
+      /// When exceeded after assembling, the least recently used cache records are evicted.
+      inline void set_cache_memory_budget(size_t bytes) { this->cache_memory_budget = bytes; }
+
+      /// Cache statistics, accumulated over all assemblings since the last reset.
+      /// A hit is a state whose cached data (shape functions, geometry, ...) could be reused.
+      inline unsigned int get_cache_hits() const { return this->cache_hits; }
+      inline unsigned int get_cache_misses() const { return this->cache_misses; }
+      /// Resets the cache statistics.
+      inline void reset_cache_statistics() { this->cache_hits = this->cache_misses = 0; }
+
+      /// Assemble into H2D_THREAD_LOCAL_BUFFERS copies of the matrix / vector values that are summed up in a fixed order
+      /// at the end, instead of adding into the shared arrays with atomics / critical sections.
+      /// The states are split into chunks of H2D_ASSEMBLING_CHUNK_SIZE states, the chunk i goes to the buffer
+      /// i % H2D_THREAD_LOCAL_BUFFERS, independently of the number of threads, so the result is bitwise the same
+      /// for any number of threads. Only used by algebraic structures that support it (CSCMatrix, UMFPackVector),
+      /// costs H2D_THREAD_LOCAL_BUFFERS copies of the values.
+      inline void set_thread_local_assembling(bool to_set = true) { this->thread_local_assembling = to_set; }
+
       /// Get the weak forms.
       const WeakForm<Scalar>* get_weak_formulation() const;
 
@@ -170,6 +189,10 @@ namespace Hermes
       void create_sparse_structure();
       void create_sparse_structure(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs = NULL);
 
+      /// Fills the pattern from the element assembly lists, the states are processed in parallel.
+      /// Used by create_sparse_structure() for problems without DG forms.
+      void create_sparsity_pattern(SparsityPattern* pattern);
+
       /// Set the special handling of external functions of Runge-Kutta methods, including information how many spaces were there in the original problem.
       inline void set_RK(int original_spaces_count) { this->RungeKutta = true; RK_original_spaces_count = original_spaces_count; }
 
@@ -195,6 +218,38 @@ namespace Hermes
       virtual void assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
       AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights);
 
+      /// Per thread memory of the assembling of the matrix forms, reused for all the elements and forms.
+      class LocalMatrixBuffer
+      {
+      public:
+        LocalMatrixBuffer();
+        ~LocalMatrixBuffer();
+        void free();
+        /// Makes room for size x size local matrices.
+        void ensure_size(unsigned int size);
+        /// The local stiffness matrix, the first size x size entries set to zero.
+        Scalar** get_local_stiffness_matrix(unsigned int size);
+        unsigned int size;
+        Scalar** local_stiffness_matrix;
+        /// See calc_local_matrix_values().
+        Scalar** form_values;
+        Scalar** compressed_values;
+        int* test_indices;
+        int* basis_indices;
+        Func<double>** used_test_fns;
+        Func<double>** used_base_fns;
+      };
+
+      /// Per thread buffers, allocated in init_assembling().
+      LocalMatrixBuffer* local_matrix_buffers;
+
+      /// Matrix forms - evaluate the form on all (basis, test) pairs of the element in one call, see MatrixForm::value_local_matrix().
+      /// For symmetric forms only the upper triangle is evaluated and mirrored.
+      /// \param[in] dirichlet_basis_fns Evaluate also the pairs with basis functions with negative dofs (Dirichlet lift).
+      /// \return NULL if the form does not provide the batched evaluation, otherwise the (not scaled) local matrix values, held by buffer.
+      Scalar** calc_local_matrix_values(MatrixForm<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext, Func<double>** base_fns, Func<double>** test_fns,
+        Geom<double>* geometry, Func<Scalar>** ext, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, bool dirichlet_basis_fns, LocalMatrixBuffer* buffer);
+
       /// Vector volumetric forms - calculate the integration order.
       int calc_order_vector_form(VectorForm<Scalar>* mfv, RefMap** current_refmaps, Solution<Scalar>** current_u_ext, Traverse::State* current_state);
 
@@ -272,12 +327,25 @@ namespace Hermes
         void clear();
         int* asmlistIdx;
         int asmlistCnt;
+        /// Geometry of the element the record was calculated for, the id may be taken by another element later.
+        void set_geometry(Element* e);
+        bool same_geometry(Element* e) const;
+        int nvert;
+        double vertices[H2D_MAX_NUMBER_VERTICES][2];
       };
 
       class CacheRecordPerSubIdx
       {
       public:
-        CacheRecordPerSubIdx();
+        CacheRecordPerSubIdx(uint64_t sub_idx);
+        /// Key within the element.
+        uint64_t sub_idx;
+        /// Next record of the same element.
+        CacheRecordPerSubIdx* next;
+        /// Assembling in which this record was used the last time (LRU eviction).
+        unsigned int last_used;
+        /// Estimated memory held by this record (bytes).
+        size_t get_memory() const;
         int nvert;
         int order;
         void clear();
@@ -292,14 +360,70 @@ namespace Hermes
         int* n_quadrature_pointsSurface;
         int* orderSurface;
         int* asmlistSurfaceCnt;
+        /// Values of the matrix forms on all the (basis, test) pairs, without any scaling,
+        /// see DiscreteProblemLinear::set_reuse_local_matrices().
+        /// Volumetric forms first, then the surface forms edge by edge, NULL if not stored.
+        Scalar*** local_matrices;
+        int local_matrices_count;
+        size_t local_matrices_memory;
       };
 
-      std::map<uint64_t, CacheRecordPerSubIdx*>*** cache_records_sub_idx;
+      /// Per space, per element id: list of the records of the sub-elements (sub_idx) of the element.
+      /// Lookups are lock-free, a new record is prepended to the list (only on a cache miss, inside
+      /// a critical section), records are removed only outside of the parallel assembling.
+      CacheRecordPerSubIdx*** cache_records_sub_idx;
       CacheRecordPerElement*** cache_records_element;
       bool** cache_element_stored;
       int cache_size;
       bool do_not_use_cache;
 
+      /// Lock-free lookup of the record of the (sub-)element of the state on the space space_i, NULL if not present.
+      CacheRecordPerSubIdx* find_cache_record(unsigned int space_i, Traverse::State* current_state) const;
+      /// Inserts a new (empty) record of the (sub-)element of the state on the space space_i, or returns the existing one.
+      CacheRecordPerSubIdx* insert_cache_record(unsigned int space_i, Traverse::State* current_state);
+      /// Deletes all records of the element element_id on the space space_i.
+      void delete_cache_records(unsigned int space_i, unsigned int element_id);
+      /// Evicts the least recently used records if the memory budget is exceeded.
+      void evict_cache_records();
+
+      /// See set_cache_memory_budget().
+      size_t cache_memory_budget;
+      /// Number of assemblings done, stamps CacheRecordPerSubIdx::last_used.
+      unsigned int cache_assembling_stamp;
+      /// See get_cache_hits().
+      unsigned int cache_hits;
+      unsigned int cache_misses;
+
+      /// See set_thread_local_assembling().
+      bool thread_local_assembling;
+      /// The matrix / vector accepted the thread-local assembling in this assembling.
+      bool thread_local_buffers_used;
+      void begin_thread_local_assembling(int num_threads);
+      /// Selects the buffer of the calling thread, see SparseMatrix::set_thread_local_buffer().
+      void set_thread_local_buffer(int buffer);
+
+      /// Graph coloring of the union mesh states.
+      /// Collects all states of the traversal of meshes and sorts them by colors so that no two states of one color
+      /// share a DOF, the states of one color can then be assembled in parallel without any two threads
+      /// adding to the same matrix / vector entry. The states and the coloring are reused as long as the meshes (their seq and elements
+      /// seq numbers, see Mesh::get_elements_seq()) and the spaces (their seq numbers) do not change. With DG forms (that add also to the neighbors' DOFs) all states get one color.
+      void init_state_coloring(Hermes::vector<const Mesh*>& meshes);
+      void free_state_coloring();
+
+      /// Tells the matrix / vector that the assembling is (or is no longer) conflict-free, see init_state_coloring().
+      void set_conflict_free_assembling(bool to_set);
+
+      /// Union mesh states (see Traverse::get_states()).
+      Traverse::State* states;
+      /// Union mesh states sorted by colors (pointers to states).
+      Traverse::State** colored_states;
+      int colored_states_count;
+      /// The states with the color c are colored_states[color_offsets[c]], ..., colored_states[color_offsets[c + 1] - 1].
+      Hermes::vector<int> color_offsets;
+      /// Meshes and seq numbers (seq and elements seq of the meshes, then seq of the spaces) the states and the coloring were calculated for.
+      Hermes::vector<const Mesh*> coloring_meshes;
+      Hermes::vector<int> coloring_seqs;
+
       /// Exception caught in a parallel region.
       Hermes::Exceptions::Exception* caughtException;
     
@@ -314,9 +438,18 @@ namespace Hermes
       void assemble_DG_one_neighbor(bool edge_processed, unsigned int neighbor_i,
         PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, AsmList<Scalar>** current_als,
         Traverse::State* current_state, Hermes::vector<MatrixFormDG<Scalar>*> current_mfDG, Hermes::vector<VectorFormDG<Scalar>*> current_vfDG, Transformable** fn,
-        std::map<unsigned int, PrecalcShapeset *> npss, std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap,
+        PrecalcShapeset** npss, PrecalcShapeset** nspss, RefMap** nrefmap,
         LightArray<NeighborSearch<Scalar>*>& neighbor_searches, unsigned int min_dg_mesh_seq, WeakForm<Scalar>* current_wf);
 
+      /// True if the matrix DG forms on the segment neighbor_i are assembled when the neighbor's state is assembled.
+      /// Decided by the element ids, so that every segment is assembled exactly once regardless of the order of the states.
+      bool DG_segment_assembled_from_neighbor(LightArray<NeighborSearch<Scalar>*>& neighbor_searches, unsigned int neighbor_i) const;
+
+      /// Per thread neighbor precalc shapesets and refmaps for the matrix DG forms, allocated in init_assembling().
+      PrecalcShapeset*** neighbor_pss;
+      PrecalcShapeset*** neighbor_spss;
+      RefMap*** neighbor_refmaps;
+
       /// Assemble DG matrix forms.
       void assemble_DG_matrix_forms(PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, AsmList<Scalar>** current_als,
         Traverse::State* current_state, MatrixFormDG<Scalar>** current_mfDG, std::map<unsigned int, PrecalcShapeset*> npss,
@@ -48,12 +48,26 @@ namespace Hermes
       virtual void assemble(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs = NULL, bool force_diagonal_blocks = false,
         Table* block_weights = NULL);
 
+      /// Keep the values of the matrix forms on every element in the cache and reuse them in the following assemblings
+      /// for the elements that were not changed (e.g. the unrefined part of the mesh in adaptivity).
+      /// Only valid if the matrix forms stay the same between the assemblings, forms with external functions are always evaluated.
+      /// Default: false.
+      void set_reuse_local_matrices(bool to_set);
+
     protected:
       /// Methods different to those of the parent class.
       /// Matrix forms.
       virtual void assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns, Func<Scalar>** ext, Func<Scalar>** u_ext,
       AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights);
 
+      /// Returns the values of the form on all the (basis, test) pairs stored in the cache record of the current state, calculates and stores them first if needed.
+      /// NULL if the values of the form can not be reused.
+      Scalar** get_local_matrix_values(MatrixForm<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext, Func<double>** base_fns, Func<double>** test_fns,
+        Geom<double>* geometry, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state);
+
+      /// See set_reuse_local_matrices().
+      bool reuse_local_matrices;
+
       template<typename T> friend class KellyTypeAdapt;
       template<typename T> friend class NewtonSolver;
       template<typename T> friend class PicardSolver;
@@ -62,6 +62,11 @@ namespace Hermes
       /// Return the value at the coordinates x,y.
       virtual Func<Scalar>* get_pt_value(double x, double y, Element* e = NULL) = 0;
 
+      /// Return the values at the coordinates (x[i], y[i]), i = 0, ..., n - 1.
+      /// The returned array and its items (NULL for points outside of the mesh) are to be deleted by the caller.
+      /// Ordering the points so that nearby points are consecutive makes this faster than repeated get_pt_value().
+      virtual Func<Scalar>** get_pt_values(double* x, double* y, int n);
+
       /// Cloning function - for parallel OpenMP blocks.
       /// Designed to return an identical clone of this instance.
       virtual MeshFunction<Scalar>* clone() const
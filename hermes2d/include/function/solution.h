@@ -30,6 +30,7 @@ namespace Hermes
     /// the solution on an element as a linear combination of monomials.
     ///
     class Quad2DCheb;
+    class BinaryMapping;
 
     enum SolutionType {
       HERMES_UNDEF = -1,
@@ -97,10 +98,23 @@ namespace Hermes
       /// element orders) to an XML file.
       virtual void save(const char* filename) const;
 
-      /// Loads the solution from a file previously created by Solution::save(). This completely
-      /// restores the solution in the memory.
+      /// Loads the solution from a file previously created by Solution::save() or Solution::save_binary().
+      /// This completely restores the solution in the memory.
       void load(const char* filename, Space<Scalar>* space);
 
+      /// Saves the solution (coefficient arrays, element orders) to a compact binary file, see BinaryWriter.
+      /// Much faster and smaller than save(), intended for checkpoints.
+      /// \param[in] compress Compress the arrays (needs Hermes built with WITH_ZLIB).
+      virtual void save_binary(const char* filename, bool compress = false) const;
+
+      /// Loads the solution from a file previously created by Solution::save_binary().
+      /// \param[in] memory_map Use the coefficient arrays directly from the memory-mapped file instead of reading them,
+      /// the file is then only read on demand by the operating system. Ignored for compressed files and on systems without mmap().
+      void load_binary(const char* filename, Space<Scalar>* space, bool memory_map = false);
+
+      /// Returns true if the file was created by Solution::save_binary().
+      static bool is_binary_file(const char* filename);
+
       /// Returns solution value or derivatives at element e, in its reference domain point (xi1, xi2).
       /// 'item' controls the returned value: 0 = value, 1 = dx, 2 = dy, 3 = dxx, 4 = dyy, 5 = dxy.
       /// NOTE: This function should be used for postprocessing only, it is not effective
@@ -127,6 +141,14 @@ namespace Hermes
       /// slow. Prefer Solution::get_ref_value if possible.
       virtual Func<Scalar>* get_pt_value(double x, double y, Element* e = NULL);
 
+      /// Returns solution values and derivatives at the physical domain points (x[i], y[i]), see MeshFunction::get_pt_values().
+      /// The element found for one point is tried first for the next one, so that points in one element
+      /// share the element search and the reference mapping.
+      virtual Func<Scalar>** get_pt_values(double* x, double* y, int n);
+
+      /// Returns solution values and derivatives at the point (xi1, xi2) of the reference domain of the element e.
+      Func<Scalar>* get_ref_pt_value(Element* e, double xi1, double xi2);
+
       /// Multiplies the function represented by this class by the given coefficient.
       void multiply(Scalar coef);
 
@@ -222,6 +244,8 @@ namespace Hermes
       /// Stored element orders in the mathematical sense. The polynomial degree of the highest basis function + increments due to the element shape, etc.  .
       int* elem_orders;
       int num_coeffs, num_elems;
+      /// If not NULL, mono_coeffs, elem_coeffs and elem_orders point into this memory-mapped file (see load_binary()).
+      BinaryMapping* mapping;
       int num_dofs;
 
       void transform_values(int order, struct Function<Scalar>::Node* node, int newmask, int oldmask, int np);
@@ -234,6 +258,10 @@ namespace Hermes
 
       double** calc_mono_matrix(int o, int*& perm);
 
+      /// Inverse of the monomial matrix of the order o (and the current mode), shared by all Solutions.
+      /// Not thread-safe, set_coeff_vector() prepares all the orders it needs before the parallel part.
+      double** get_mono_inverse(int o);
+
       void init_dxdy_buffer();
 
       void free_tables();
@@ -36,6 +36,8 @@
 #define H2D_SOLUTION_ELEMENT_CACHE_SIZE 2 ///< A maximum number of vertices of an element.
 #define H2D_MAX_NODE_ID 10000000
 #define H2D_MAX_SOLUTION_COMPONENTS 2
+#define H2D_THREAD_LOCAL_BUFFERS 8 ///< A number of copies of the matrix / vector values in the thread-local assembling, see DiscreteProblem::set_thread_local_assembling().
+#define H2D_ASSEMBLING_CHUNK_SIZE 16 ///< A number of states assembled as one task of the parallel assembling, see DiscreteProblem::set_thread_local_assembling().
 
 #define HERMES_ONE NULL
 #define HERMES_DEFAULT_FUNCTION NULL
@@ -145,6 +147,21 @@ namespace Hermes
       static double norm_fn_hdiv(MeshFunction<Scalar>* sln, RefMap* ru);
 
       static double get_l2_norm(Vector<Scalar>* vec);
+
+      /// Makes per-thread copies of functions for parallel traversals, the first thread gets the originals.
+      /// If one of the functions can not be cloned (e.g. a user ExactSolution not overriding clone()),
+      /// num_threads is set to 1 and only the originals are returned.
+      /// \return Array of num_threads arrays of num_fns functions, free it with free_thread_clones().
+      static MeshFunction<Scalar>*** clone_for_threads(MeshFunction<Scalar>** fns, int num_fns, int& num_threads);
+
+      /// Frees the copies made by clone_for_threads().
+      static void free_thread_clones(MeshFunction<Scalar>*** clones, int num_fns, int num_threads);
+
+    protected:
+      /// Sums the squared error (sln2 != NULL) or the squared norm (sln2 == NULL) over the union mesh states.
+      /// The states are processed in parallel, the contributions are summed in the order of the states,
+      /// so that the result does not depend on the number of threads.
+      static double calc_squared_integral(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, int norm_type);
     };
 
     /// Projection norms.
@@ -137,6 +137,14 @@ namespace Hermes
 
       static void calc_ref_map(Element* e, Nurbs** nurbs, double xi_1, double xi_2, double2& f);
 
+      /// Loads a Cholesky-factorized projection matrix (and its diagonal) stored by save_cholesky_projection_matrix()
+      /// from the directory given by the precalculatedFormsDirPath parameter of Hermes2DApi.
+      /// Returns false if the file does not exist, or if it was stored for a different version, shapeset, order or size.
+      static bool load_cholesky_projection_matrix(const char* name, int shapeset_id, int order, int n, double** mat, double* p);
+      /// Stores a Cholesky-factorized projection matrix, so that other processes do not need to calculate it again.
+      /// Does nothing unless the storePrecalculatedForms parameter of Hermes2DApi is set. Failures (e.g. a read-only directory) are silently ignored.
+      static void save_cholesky_projection_matrix(const char* name, int shapeset_id, int order, int n, double** mat, double* p);
+
       static void precalculate_cholesky_projection_matrix_edge(H1ShapesetJacobi* ref_map_shapeset, PrecalcShapeset* ref_map_pss);
       static double** calculate_bubble_projection_matrix(int nb, int* indices, H1ShapesetJacobi* ref_map_shapeset, PrecalcShapeset* ref_map_pss, ElementMode2D mode);
       static void precalculate_cholesky_projection_matrices_bubble(H1ShapesetJacobi* ref_map_shapeset, PrecalcShapeset* ref_map_pss);
@@ -164,6 +172,7 @@ namespace Hermes
       friend class MeshReader;
       friend class MeshReaderH2D;
       friend class MeshReaderH2DXML;
+      friend class MeshReaderBinary;
       friend CurvMap* create_son_curv_map(Element* e, int son);
     };
   }
@@ -0,0 +1,72 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_ELEMENT_INDEX_H
+#define __H2D_ELEMENT_INDEX_H
+
+#include "../global.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    class Element;
+    class Mesh;
+
+    /// \brief Spatial index of the active elements of a mesh.
+    ///
+    /// A uniform grid over the bounding box of the mesh, with roughly one cell per element. Every cell
+    /// lists the elements whose bounding boxes intersect it, so that locating the element containing
+    /// a point only tests a few elements instead of all of them.
+    /// Bounding boxes of curved elements are enlarged to contain the curved edges.
+    /// Built by Mesh::get_element_index(), which rebuilds it when the mesh changes (according to Mesh::get_seq()).
+    class HERMES_API ElementIndex
+    {
+    public:
+      ElementIndex(const Mesh* mesh);
+      ~ElementIndex();
+
+      /// Elements that may contain the point (x, y).
+      /// \param[out] count Number of the elements.
+      /// \return The elements, NULL (count 0) if the point is outside the bounding box of the mesh.
+      Element** get_candidates(double x, double y, int& count) const;
+
+      /// Sequence number of the mesh the index was built for.
+      unsigned get_mesh_seq() const { return this->mesh_seq; }
+
+      /// Whether the mesh contains curved elements (the enlarged bounding boxes are then only a heuristic).
+      bool has_curved_elements() const { return this->curved_elements; }
+
+    protected:
+      unsigned mesh_seq;
+      bool curved_elements;
+
+      /// Bounding box of the mesh.
+      double x_min, y_min, x_max, y_max;
+
+      /// Grid dimensions and inverse cell sizes.
+      int nx, ny;
+      double inv_cell_width, inv_cell_height;
+
+      /// Elements of the cell (i, j) are cell_elements[cell_starts[j * nx + i] ... cell_starts[j * nx + i + 1] - 1].
+      int* cell_starts;
+      Element** cell_elements;
+
+      /// Cell range covering the interval [min, max] in one direction.
+      void get_cell_range(double min, double max, double origin, double inv_size, int n, int& first, int& last) const;
+    };
+  }
+}
+#endif
@@ -37,6 +37,8 @@ namespace Hermes
     ///
     /// HashTable is a base class for Mesh. It serves as a container for all nodes
     /// of a mesh. Moreover, it has node searching functions based on hash tables.
+    /// The hash tables double their size whenever they hold more nodes than buckets,
+    /// so that the lists of hash synonyms stay short also after many refinements.
     ///
     class HERMES_API HashTable : public Hermes::Mixins::Loggable
     {
@@ -49,6 +51,27 @@ namespace Hermes
 
       static const int H2D_DEFAULT_HASH_SIZE = 0x8000; // 32K entries
 
+      /// Load statistics of one of the hash tables.
+      struct HashTableStatistics
+      {
+        /// Number of buckets.
+        int size;
+        /// Number of nodes in the table.
+        int num_nodes;
+        /// Average number of nodes per bucket.
+        double load_factor;
+        /// Length of the longest list of hash synonyms.
+        int max_chain_length;
+        /// Number of times the tables have been enlarged since init().
+        int num_resizes;
+      };
+
+      /// Returns the load statistics of the vertex node hash table.
+      HashTableStatistics get_vertex_statistics() const;
+
+      /// Returns the load statistics of the edge node hash table.
+      HashTableStatistics get_edge_statistics() const;
+
 
     protected:
       HashTable();
@@ -102,8 +125,22 @@ namespace Hermes
 
       int mask;
 
+      /// Numbers of nodes in v_table and e_table.
+      int v_count, e_count;
+
+      /// See HashTableStatistics::num_resizes.
+      int num_resizes;
+
       inline int hash(int p1, int p2) const { return (984120265*p1 + 125965121*p2) & mask; }
 
+      /// Doubles the size of both hash tables and redistributes the nodes.
+      void grow();
+
+      /// Moves all nodes of table (of the old size) to new_table, using the current mask.
+      void rehash_table(Node** table, int old_size, Node** new_table);
+
+      HashTableStatistics get_statistics(Node** table, int count) const;
+
       /// Searches a list of hash synonyms given the first list item.
       /// Returns the node matching the parent ids p1 and p2.
       Node* search_list(Node* node, int p1, int p2) const;
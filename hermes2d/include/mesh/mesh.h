@@ -33,6 +33,7 @@ namespace Hermes
 
     class Element;
     class HashTable;
+    class ElementIndex;
 
     template<typename Scalar> class Space;
     template<typename Scalar> class KellyTypeAdapt;
@@ -125,7 +126,9 @@ namespace Hermes
       bool active;   ///< 0 = active, no sons; 1 = inactive (refined), has sons
       bool used;     ///< array item usage flag
       Element* parent;     ///< pointer to the parent element for the current son
-      bool visited;        ///< true if the element has been visited during assembling
+      /// Deprecated: no longer set or read by Hermes (KellyTypeAdapt decides the visited segments by the element ids),
+      /// kept only for source compatibility and to be removed in the next release.
+      bool visited;
       
       /// Calculates the area of the element. For curved elements, this is only
       /// an approximation: the curvature is not accounted for.
@@ -198,6 +201,7 @@ namespace Hermes
       friend class MeshReaderH2D;
       friend class MeshReaderH1DXML;
       friend class MeshReaderH2DXML;
+      friend class MeshReaderBinary;
       friend class PrecalcShapeset;
       template<typename Scalar> friend class Space;
       template<typename Scalar> friend class Adapt;
@@ -370,6 +374,15 @@ namespace Hermes
       /// For internal use.
       void set_seq(unsigned seq);
 
+      /// Changes whenever the elements are freed (e.g. by copy(), which keeps the seq number), i.e. when pointers to
+      /// the elements of the mesh become invalid.
+      /// For internal use.
+      unsigned get_elements_seq() const;
+
+      /// Spatial index of the active elements, (re)built on the first call after the mesh changed.
+      /// For internal use.
+      const ElementIndex* get_element_index() const;
+
       /// Class for creating reference mesh.
       class HERMES_API ReferenceMeshCreator
       {
@@ -382,14 +395,59 @@ namespace Hermes
         /// refine vertically.
         ReferenceMeshCreator(Mesh* coarse_mesh, int refinement = 0);
 
+        virtual ~ReferenceMeshCreator();
+
         /// Method that does the creation.
         /// THIS IS THE METHOD TO OVERLOAD FOR CUSTOM CREATING OF A REFERENCE MESH.
         virtual Mesh* create_ref_mesh();
 
+        /// Brings the reference mesh owned by this creator up to date with the coarse mesh and returns it.
+        /// The first call builds the same mesh as the default create_ref_mesh(), the later ones only redo the parts
+        /// under the coarse elements that were refined or unrefined since the previous call (e.g. by Adapt).
+        /// The coarse elements keep their ids in the reference mesh, as with create_ref_mesh().
+        /// The returned mesh is always the same instance, it is deleted with the creator, and it is changed in place,
+        /// i.e. the solutions defined on its previous state must not be used afterwards.
+        /// The mesh is rebuilt from scratch if the base mesh changed, if the coarse element ids outgrew the reserved range,
+        /// or if the coarse mesh contains refinements of triangles to quads or vice versa.
+        /// Note: overloads of create_ref_mesh() are not taken into account here.
+        Mesh* update_ref_mesh();
+
       private:
+        /// Full construction of ref_mesh.
+        void build_ref_mesh();
+
+        /// True if the base elements of ref_mesh are those of the coarse mesh.
+        bool base_unchanged();
+
+        /// Unrefines the elements of ref_mesh under ref_e that do not correspond to the coarse mesh under coarse_e.
+        /// Returns false for refinements that can not be updated.
+        bool collapse_changed(Element* coarse_e, Element* ref_e);
+
+        /// Refines the elements of ref_mesh under ref_e to correspond to the coarse mesh under coarse_e.
+        void refine_changed(Element* coarse_e, Element* ref_e);
+
+        /// Unrefines the whole subtree of ref_e.
+        void collapse(Element* ref_e);
+
+        /// Refines the element of ref_mesh corresponding to an active coarse element.
+        void refine_ref_layer(Element* ref_e);
+
+        /// Refines ref_e, its sons get the given ids in the order of their creation.
+        void refine_with_ids(Element* ref_e, int refinement, const int* son_ids, int count);
+
         /// Storage.
         Mesh* coarse_mesh;
         int refinement;
+
+        /// The reference mesh of update_ref_mesh() and its seq number after the last update.
+        Mesh* ref_mesh;
+        unsigned ref_mesh_seq;
+
+        /// The ids below ref_base are reserved for the elements of the coarse mesh,
+        /// the ids of the elements of the reference refinement are allocated above it.
+        int ref_base;
+        int ref_next_id;
+        Hermes::vector<int> ref_free_ids;
       };
 
     private:
@@ -429,12 +487,24 @@ namespace Hermes
       Array<Element> elements;
       int nactive;
       unsigned seq;
+      /// See get_elements_seq().
+      unsigned elements_seq;
+
+      /// See get_element_index().
+      mutable ElementIndex* element_index;
 
       int nbase, ntopvert;
       int ninitial;
 
       void unrefine_element_internal(Element* e);
 
+      /// Takes a slot for a new element, see forced_element_ids.
+      Element* add_element();
+
+      /// Ids for the next elements created by create_triangle() and create_quad(), the last one is used first.
+      /// If empty, the elements get the first free ids.
+      Hermes::vector<int> forced_element_ids;
+
       /// Returns a NURBS curve with reversed control points and inverted knot vector.
       /// Used for curved edges inside a mesh, where two mirror Nurbs have to be created
       /// for the adjacent elements
@@ -546,8 +616,10 @@ namespace Hermes
 
       friend class MeshReaderH2D;
       friend class MeshReaderH2DXML;
+      friend class MeshReaderBinary;
       friend class MeshReaderH1DXML;
       friend class MeshReaderExodusII;
+      friend class ReferenceMeshCreator;
       friend class DiscreteProblem<double>;
       friend class DiscreteProblem<std::complex<double> >;
       friend class WeakForm<double>;
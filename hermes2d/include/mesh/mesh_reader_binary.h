@@ -0,0 +1,74 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#ifndef _MESH_READER_BINARY_H_
+#define _MESH_READER_BINARY_H_
+
+#include "mesh_reader.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    class BinaryReader;
+
+    /// Mesh reader from the Hermes2D binary format
+    ///
+    /// @ingroup mesh_readers
+    /// Stores the base mesh (vertices, elements, markers, curves) and the refinement history as flat arrays
+    /// in the format of BinaryWriter, so that loading needs neither parsing nor per-vertex conversions.
+    /// The vertex and element arrays are used directly from the memory-mapped file if set_memory_map() is on.
+    /// Typical usage:
+    /// Hermes::Hermes2D::Mesh mesh;
+    /// Hermes::Hermes2D::MeshReaderBinary mloader;
+    /// try
+    /// {
+    ///&nbsp;mloader.load("mesh.h2db", &mesh);
+    /// }
+    /// catch(Exceptions::MeshLoadFailureException& e)
+    /// {
+    ///&nbsp;e.print_msg();
+    ///&nbsp;return -1;
+    /// }
+    class HERMES_API MeshReaderBinary : public MeshReader
+    {
+    public:
+      MeshReaderBinary();
+      virtual ~MeshReaderBinary();
+
+      /// This method loads a single mesh from a file.
+      virtual bool load(const char *filename, Mesh *mesh);
+
+      /// This method saves a single mesh to a file.
+      /// \param[in] compress Compress the file (needs WITH_ZLIB), compressed files can not be memory-mapped.
+      bool save(const char *filename, Mesh *mesh, bool compress = false);
+
+      /// Map the file into memory when loading (POSIX systems).
+      /// Default: true.
+      void set_memory_map(bool memory_map);
+
+      /// Returns true if the file is a mesh in this format.
+      static bool is_binary_file(const char *filename);
+
+    protected:
+      /// Returns the next section of count items of type T, either in place in the mapped file or read into storage.
+      template<typename T>
+      T* get_section(BinaryReader& reader, unsigned long long count, Hermes::vector<T>& storage, const char *filename);
+
+      bool memory_map;
+    };
+  }
+}
+#endif
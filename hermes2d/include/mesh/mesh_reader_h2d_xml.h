@@ -59,6 +59,7 @@ namespace Hermes
       virtual ~MeshReaderH2DXML();
 
       /// This method loads a single mesh from a file.
+      /// Files saved by MeshReaderBinary are recognized and loaded by it.
       virtual bool load(const char *filename, Mesh *mesh);
 
       /// This method saves a single mesh to a file.
@@ -75,6 +75,7 @@ namespace Hermes
       static void untransform(Element* e, double x, double y, double& xi1, double& xi2);
 
       /// Returns the element pointer located at physical coordinates x, y.
+      /// Only the elements listed for (x, y) in the spatial index of the mesh (Mesh::get_element_index()) are tested.
       /// \param[in] x Physical x-coordinate.
       /// \param[in] y Physical y-coordinate.
       /// \param[in] x_reference Optional parameter, in which the x-coordinate of x in the reference domain will be returned.
@@ -84,6 +85,13 @@ namespace Hermes
       /// Find out if the coordinatex [x,y] lie in the element e.
       static bool is_element_on_physical_coordinates(Element* e, double x, double y, double* x_reference, double* y_reference);
 
+    protected:
+      /// The element out of elements located at physical coordinates x, y, NULL if there is none.
+      /// See element_on_physical_coordinates().
+      static Element* element_on_physical_coordinates(Element** elements, int count, double x, double y, double* x_reference, double* y_reference);
+
+    public:
+
       /// Returns the x-coordinates of the integration points transformed to the
       /// physical domain of the element. Intended for integrals containing spatial
       /// variables.
@@ -104,6 +104,7 @@ namespace Hermes
       friend class Views::Vectorizer;
       template<typename Scalar> friend class DiscreteProblem;
       template<typename Scalar> friend class DiscreteProblemLinear;
+      template<typename Scalar> friend class KellyTypeAdapt;
       };
 
       void begin(int n, const Mesh** meshes, Transformable** fn = NULL);
@@ -111,6 +112,16 @@ namespace Hermes
 
       State* get_next_state(int* top_by_ref = NULL, int* id_by_ref = NULL);
       int get_num_states(Hermes::vector<const Mesh*> meshes);
+
+      /// Materializes all the states of the traversal of meshes (elements, sub-element transformations, boundary flags)
+      /// into one array, so that the states can be processed in any order, e.g. by OpenMP threads indexing the array directly.
+      /// Has to be called on a master instance. The array is to be deleted (delete []) by the caller.
+      /// @param[out] states_count Number of the states.
+      State* get_states(Hermes::vector<const Mesh*> meshes, int& states_count);
+
+      /// Sets the active elements and sub-element transformations of the functions fn (one per mesh) to the state,
+      /// the same way get_next_state() does with the functions passed to begin().
+      static void set_state_transforms(State* state, Transformable** fn);
       inline Element*  get_base() const { return base; }
 
       void init_transforms(State* s, int i);
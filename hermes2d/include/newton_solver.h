@@ -97,6 +97,8 @@ namespace Hermes
 
       /// Solve which keeps jacobian.
       /// A solve() method where the jacobian is reused.
+      /// The jacobian is kept even between calls, for reusing it only for a number of steps within solve(),
+      /// see set_max_steps_with_reused_jacobian().
       void solve_keep_jacobian(Scalar* coeff_vec = NULL);
       
       /// Solve which keeps jacobian.
@@ -185,6 +187,40 @@ namespace Hermes
       /// Set the weak forms.
       void set_weak_formulation(const WeakForm<Scalar>* wf);
 
+      /// Assemble the residual and the jacobian in one traversal of the mesh(es).
+      /// Both are then calculated from the same per-element data (u_ext, geometry, shape functions),
+      /// at the price of assembling one jacobian that is not needed in the last (converged) iteration.
+      /// Has no effect in solve_keep_jacobian().
+      /// Default: true
+      void set_fused_assembly(bool onOff);
+
+      /// Reuse the jacobian (and its factorization in the case of a direct solver) for up to this number of
+      /// consecutive steps in solve(). The jacobian is recalculated earlier if the residual norm does not decrease
+      /// sufficiently, see set_sufficient_improvement_factor_jacobian().
+      /// When the jacobian is recalculated, direct solvers reuse the reordering of the previous one (the sparsity structure does not change).
+      /// The residual and the jacobian are then assembled separately, see set_fused_assembly().
+      /// Default: 0 (the jacobian is recalculated in every step).
+      /// \param[in] steps Number of steps.
+      void set_max_steps_with_reused_jacobian(unsigned int steps);
+
+      /// Set the ratio of the current residual norm and the previous residual norm necessary to keep reusing the jacobian.
+      /// If the residual norm is not reduced at least by this factor, the jacobian is recalculated.
+      /// Has effect only with set_max_steps_with_reused_jacobian().
+      /// Default: 0.5
+      /// \param[in] ratio The ratio, must be positive.
+      void set_sufficient_improvement_factor_jacobian(double ratio);
+
+      /// Inexact Newton's method with an iterative linear solver.
+      /// The tolerance of the linear solver (relative to the residual norm) is set in each step by the forcing term
+      /// of Eisenstat and Walker (choice 2, with their safeguards), so that the linear systems are solved
+      /// only as exactly as the current nonlinear residual justifies.
+      /// Has no effect with direct solvers.
+      /// Default: off.
+      /// \param[in] onOff on(true)-inexact Newton, off(false)-the tolerance of the linear solver is left as it is.
+      /// \param[in] initial_forcing_term The tolerance in the first step, must be in (0, 1).
+      /// \param[in] max_forcing_term The upper bound of the tolerance, must be in (0, 1).
+      void set_inexact_newton(bool onOff, double initial_forcing_term = 0.5, double max_forcing_term = 0.9);
+
     protected:
       /// This instance owns its DP.
       const bool own_dp;
@@ -195,6 +231,9 @@ namespace Hermes
       /// Internal setting of default values (see individual set methods).
       void init_attributes();
 
+      /// Passes the iterative method and the preconditioner names (if set) to the linear solver.
+      void set_iterative_settings();
+
       /// Jacobian.
       SparseMatrix<Scalar>* jacobian;
 
@@ -208,6 +247,9 @@ namespace Hermes
       int newton_max_iter;
       bool residual_as_function;
 
+      /// Residual and jacobian assembled in one pass.
+      bool fused_assembly;
+
       /// Maximum allowed residual norm. If this number is exceeded, the methods solve() return 'false'.
       /// By default set to 1E6.
       /// Possible to change via method set_max_allowed_residual_norm().
@@ -226,6 +268,18 @@ namespace Hermes
       double sufficient_improvement_factor;
       /// necessary number of steps to increase back the damping coeff.
       unsigned int necessary_successful_steps_to_increase;
+
+      /// Jacobian reuse.
+      unsigned int max_steps_with_reused_jacobian;
+      double sufficient_improvement_factor_jacobian;
+
+      /// Inexact Newton.
+      bool inexact_newton;
+      double initial_forcing_term;
+      double max_forcing_term;
+
+      /// Calculates the Eisenstat-Walker forcing term of the current step.
+      double calculate_forcing_term(double forcing_term, double residual_norm, double last_residual_norm) const;
     };
   }
 }
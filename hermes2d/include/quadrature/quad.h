@@ -33,6 +33,9 @@ namespace Hermes
 
     const int g_max_quad = 24;
     const int g_max_tri = 20;
+    /// A maximum number of points of the standard rules (13 x 13 Gauss points of the order g_max_quad on quads,
+    /// 79 points of the order g_max_tri on triangles), e.g. for fixed-size buffers in forms.
+    const int g_max_quad_points = 169;
 
     /// Quad1D is a base class for all 1D quadrature points.
     ///
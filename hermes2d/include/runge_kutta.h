@@ -27,13 +27,8 @@ namespace Hermes
   {
     // TODO LIST:
     //
-    // (1) With explicit and diagonally implicit methods, the matrix is treated
-    //     in the same way as with fully implicit ones. To make this more
-    //     efficient, with explicit and diagonally implicit methods one should
-    //     first only solve for the upper left block, then eliminate all blocks
-    //     under it, then solve for block at position 22, eliminate all blocks
-    //     under it, etc. Currently this is not done and everything is left to
-    //     the matrix solver.
+    // (1) Done - explicit and diagonally implicit methods are solved stage by stage,
+    //     see set_sequential_stages().
     //
     // (2) In example 03-timedep-adapt-space-and-time with implicit Euler
     //     method, Newton's method takes much longer than in 01-timedep-adapt-space-only
@@ -89,6 +84,13 @@ namespace Hermes
       void set_residual_as_solutions();
       void set_block_diagonal_jacobian();
 
+      /// With diagonally implicit (or explicit) Butcher's tables, the stages are solved one after another,
+      /// each stage being a system of size ndof, instead of one coupled system of size num_stages*ndof.
+      /// With set_freeze_jacobian(), one factorization is also shared by consecutive stages with the same
+      /// diagonal entry of the table (SDIRK methods).
+      /// Default: true.
+      void set_sequential_stages(bool sequential_stages);
+
       /// Destructor.
       ~RungeKutta();
 
@@ -157,6 +159,22 @@ namespace Hermes
       /// Updates the augmented weak formulation.
       void update_stage_wf(Hermes::vector<Solution<Scalar>*> slns_time_prev);
 
+      /// Time step solving the stages one after another, see set_sequential_stages().
+      void rk_time_step_newton_sequential(Hermes::vector<Solution<Scalar>*> slns_time_prev, Hermes::vector<Solution<Scalar>*> slns_time_new, Hermes::vector<Solution<Scalar>*> error_fns);
+
+      /// Creates the weak formulation of a single stage (size ndof times ndof).
+      void create_stage_wf_sequential(unsigned int size);
+
+      /// Updates the weak formulation of a single stage for the stage stage_i.
+      void update_stage_wf_sequential(Hermes::vector<Solution<Scalar>*> slns_time_prev, unsigned int stage_i);
+
+      /// Calculates the new time level solution (and the error estimate) from the stage vectors in K_vector.
+      void calculate_time_level_solutions(Hermes::vector<Solution<Scalar>*> slns_time_prev, Hermes::vector<Solution<Scalar>*> slns_time_new, Hermes::vector<Solution<Scalar>*> error_fns);
+
+      /// Output of the matrix / rhs in the Newton's iteration it, if requested (see MatrixRhsOutput).
+      void output_matrix(SparseMatrix<Scalar>* matrix, int it);
+      void output_rhs(Vector<Scalar>* rhs, int it);
+
       // Prepare u_ext_vec.
       void prepare_u_ext_vec();
 
@@ -194,6 +212,18 @@ namespace Hermes
       WeakForm<Scalar> stage_wf_left;
       DiscreteProblem<Scalar>* stage_dp_left;
 
+      /// Weak formulation of a single stage, used with sequential_stages,
+      /// size ndof times ndof.
+      WeakForm<Scalar> stage_wf_sequential;
+      DiscreteProblem<Scalar>* stage_dp_sequential;
+
+      /// Matrix, vector and matrix solver of a single stage.
+      SparseMatrix<Scalar>* matrix_stage;
+      Vector<Scalar>* vector_stage;
+      LinearMatrixSolver<Scalar>* solver_stage;
+
+      bool sequential_stages;
+
       bool start_from_zero_K_vector;
       bool block_diagonal_jacobian;
       bool residual_as_vector;
@@ -114,6 +114,19 @@ namespace Hermes
 
       virtual void precalculate(int order, int mask);
 
+      /// Makes the point buffers large enough for np points.
+      void reserve_points(int np);
+
+      /// Integration points transformed by precalculate(), x followed by y, for up to points_size points.
+      double* points;
+      int points_size;
+
+      /// 1D factors of the tensor-product quad functions (Shapeset::get_tensor_factors()), the x factors followed
+      /// by the y factors, valid for the tensor_np points tensor_points (x followed by y).
+      double* tensor_factors;
+      double* tensor_points;
+      int tensor_np;
+
       void update_max_index();
 
       /// Forces a transform without using push_transform() etc.
@@ -17,6 +17,10 @@
 #define __H2D_SHAPESET_H
 
 #include "../global.h"
+
+/// Number of points processed at once by the batch evaluation kernels of Shapeset.
+#define H2D_SHAPESET_BATCH_BLOCK 64
+
 namespace Hermes
 {
   namespace Hermes2D
@@ -119,6 +123,8 @@ namespace Hermes
       virtual SpaceType get_space_type() const = 0;
 
     protected:
+      Shapeset();
+
       /// Returns a complete set of indices of bubble functions for an element of the given order.
       int* get_bubble_indices(int order, ElementMode2D mode) const;
 
@@ -133,6 +139,19 @@ namespace Hermes
       /// domain, component is 0 for Scalar shapesets and 0 or 1 for vector shapesets.
       double get_value(int n, int index, double x, double y, int component, ElementMode2D mode);
 
+      /// Evaluates the given shape function (expansion n) at np points of the reference domain,
+      /// the values are stored to result[0 .. np-1].
+      void get_values(int n, int index, int np, const double* x, const double* y, int component, double* result, ElementMode2D mode);
+
+      /// Computes the 1D factors of the tensor-product quad functions (see quad_tensor_table) of all the degrees
+      /// 0 .. max_order at np points: factors[(3 * degree + derivative) * np + i], derivative being 0, 1 or 2.
+      /// One Legendre recurrence gives all the degrees, so that the factors can be shared by all the shape functions.
+      void get_tensor_factors(int np, const double* x, double* factors) const;
+
+      /// Expansion n of the quad shape function 'index' as the product of the factors from get_tensor_factors()
+      /// for the x and y coordinates of the np points.
+      void get_tensor_values(int n, int index, int np, const double* factors_x, const double* factors_y, double* result) const;
+
       double get_fn_value (int index, double x, double y, int component, ElementMode2D mode);
       double get_dx_value (int index, double x, double y, int component, ElementMode2D mode);
       double get_dy_value (int index, double x, double y, int component, ElementMode2D mode);
@@ -154,6 +173,13 @@ namespace Hermes
       int**  bubble_count;
       int**  index_to_order;
 
+      /// Tensor-product form of the quad shape functions, NULL if the shapeset does not have one.
+      /// Function 'index' is quad_tensor_table[index][2] * f_i(x) * f_j(y), i = quad_tensor_table[index][0],
+      /// j = quad_tensor_table[index][1], f being the Lobatto shape functions or the Legendre polynomials.
+      int (*quad_tensor_table)[3];
+      /// The 1D factors of quad_tensor_table are Lobatto shape functions (true) or Legendre polynomials (false).
+      bool quad_tensor_lobatto;
+
       double2 ref_vert[H2D_MAX_SOLUTION_COMPONENTS][H2D_MAX_NUMBER_VERTICES];
       int max_order;
       int num_components;
@@ -202,6 +228,10 @@ namespace Hermes
       ///
       double get_constrained_value(int n, int index, double x, double y, int component, ElementMode2D mode);
 
+      /// Batch version of get_constrained_value(), the combination of edge functions is evaluated
+      /// one edge function at a time over all the points.
+      void get_constrained_values(int n, int index, int np, const double* x, const double* y, int component, double* result, ElementMode2D mode);
+
       template<typename Scalar> friend class DiscreteProblem;
       template<typename Scalar> friend class Solution;
       friend class CurvMap; friend class RefMap;
@@ -28,5 +28,6 @@ extern int* simple_quad_edge_indices[H2D_MAX_NUMBER_EDGES];
 extern int* simple_quad_bubble_indices[];
 extern int simple_quad_bubble_count[];
 extern int simple_quad_index_to_order[];
+extern int simple_quad_tensor_table[][3];
 
 #endif
\ No newline at end of file
@@ -184,8 +184,16 @@ namespace Hermes
       bool save(const char *filename) const;
 
       /// Loads a space from a file.
+      /// Files created by save_binary() are recognized and loaded by load_binary().
       static Space<Scalar>* load(const char *filename, Mesh* mesh, bool validate, EssentialBCs<Scalar>* essential_bcs = NULL, Shapeset* shapeset = NULL);
 
+      /// Saves this space into a compact binary file, see BinaryWriter.
+      /// \param[in] compress Compress the element data (needs Hermes built with WITH_ZLIB).
+      bool save_binary(const char *filename, bool compress = false) const;
+
+      /// Loads a space from a file created by save_binary().
+      static Space<Scalar>* load_binary(const char *filename, Mesh* mesh, EssentialBCs<Scalar>* essential_bcs = NULL, Shapeset* shapeset = NULL);
+
       /// Obtains an assembly list for the given element.
       virtual void get_element_assembly_list(Element* e, AsmList<Scalar>* al, unsigned int first_dof = 0) const;
 
@@ -202,6 +210,8 @@ namespace Hermes
         /// \param[in] order_increase Increase of the polynomial order.
         ReferenceSpaceCreator(const Space<Scalar>* coarse_space, const Mesh* ref_mesh, unsigned int order_increase = 1);
 
+        virtual ~ReferenceSpaceCreator();
+
         /// Method that does the creation.
         /// THIS IS THE METHOD TO OVERLOAD FOR CUSTOM CREATING OF A REFERENCE SPACE.
         virtual void handle_orders(Space<Scalar>* ref_space);
@@ -209,6 +219,15 @@ namespace Hermes
         /// Methods that user calls to get the reference space pointer (has to be properly casted if necessary).
         virtual Space<Scalar>* create_ref_space(bool assign_dofs = true);
 
+        /// Brings the reference space owned by this creator up to date with the coarse space and returns it.
+        /// The first call uses create_ref_space(), the later ones keep the space and only set its element orders again
+        /// by handle_orders(), which saves constructing a new space (with its uniform orders and DOF numbering).
+        /// Intended for ref_mesh updated in place by Mesh::ReferenceMeshCreator::update_ref_mesh().
+        /// Only the elements under the coarse elements changed in the last adaptivity step are marked as changed
+        /// (if assign_dofs is true), so that the assembling can reuse the data of the others.
+        /// The returned space is always the same instance, it is deleted with the creator.
+        virtual Space<Scalar>* update_ref_space(bool assign_dofs = true);
+
         /// Construction initialization.
       private:
         L2Space<Scalar>* init_construction_l2();
@@ -219,10 +238,16 @@ namespace Hermes
         /// Construction finalization.
         virtual void finish_construction(Space<Scalar>* ref_space);
 
+        /// Marks the reference elements under the coarse elements changed in the last adaptivity step as changed.
+        void mark_changed_elements(Space<Scalar>* ref_space);
+
         /// Storage.
         const Space<Scalar>* coarse_space;
         const Mesh* ref_mesh;
         unsigned int order_increase;
+
+        /// The reference space of update_ref_space().
+        Space<Scalar>* ref_space;
       };
 
       /// Sets element polynomial order. This version does not call assign_dofs() and is
@@ -232,12 +257,15 @@ namespace Hermes
       /// \brief Builds basis functions and assigns DOF numbers to them.
       /// \details This functions must be called \b after assigning element orders, and \b before
       /// using the space in a computation, otherwise an error will occur.
+      /// The DOFs are ordered according to the parameter Hermes2DApi dofOrdering, see DofOrdering.
       /// \param first_dof[in] The DOF number of the first basis function.
       /// \param stride[in] The difference between the DOF numbers of successive basis functions.
       /// \return The number of basis functions contained in the space.
       virtual int assign_dofs(int first_dof = 0, int stride = 1);
 
       /// \brief Assings the degrees of freedom to all Spaces in the Hermes::vector.
+      /// Every space gets a contiguous range of DOFs, reordered within the range according to the parameter
+      /// Hermes2DApi dofOrdering.
       static int assign_dofs(Hermes::vector<Space<Scalar>*> spaces);
 
       virtual Scalar* get_bc_projection(SurfPos* surf_pos, int order, EssentialBoundaryCondition<Scalar> *bc) = 0;
@@ -274,7 +302,7 @@ namespace Hermes
       void free();
 
       /// Returns the total (global) number of vertex functions.
-      /// The DOF ordering starts with vertex functions, so it it necessary to know how many of them there are.
+      /// The native DOF ordering starts with vertex functions, so it it necessary to know how many of them there are.
       int get_vertex_functions_count();
       /// Returns the total (global) number of edge functions.
       int get_edge_functions_count();
@@ -368,6 +396,12 @@ namespace Hermes
       virtual void assign_edge_dofs() = 0;
       virtual void assign_bubble_dofs() = 0;
 
+      /// Permutes the DOFs assigned by assign_vertex_dofs(), assign_edge_dofs() and assign_bubble_dofs()
+      /// by the reverse Cuthill-McKee algorithm applied to the graph of DOF blocks (two blocks are adjacent if they
+      /// share an element). The DOFs of one block stay consecutive, so that NodeData::dof / ElementData::bdof
+      /// remain the first DOF of the block.
+      void renumber_dofs_rcm();
+
       virtual void get_vertex_assembly_list(Element* e, int iv, AsmList<Scalar>* al) const = 0;
       virtual void get_boundary_assembly_list_internal(Element* e, int surf_num, AsmList<Scalar>* al) const = 0;
       virtual void get_bubble_assembly_list(Element* e, AsmList<Scalar>* al) const;
@@ -392,6 +426,9 @@ namespace Hermes
 
       void free_bc_data();
 
+      /// Creates an empty space of the given type for load() and load_binary(), the element data are to be filled in.
+      static Space<Scalar>* create_for_load(SpaceType type, Mesh* mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset, const char* filename);
+
       /// Internal. Used by DiscreteProblem to detect changes in the space.
       int get_seq() const;
       template<typename T> friend class OGProjection;
@@ -412,6 +449,7 @@ namespace Hermes
       template<typename T> friend class Views::VectorBaseView;
       friend class Adapt<Scalar>;
       friend class DiscreteProblem<Scalar>;
+      template<typename T> friend class DiscreteProblemLinear;
       template<typename T> friend class CalculationContinuity;
     };
   }
@@ -51,6 +51,13 @@ namespace Hermes
       /// One-dimensional function derivative integration order.
       Hermes::Ord derivative(Hermes::Ord x) const {return Hermes::Ord(2);};
 
+      /// One-dimensional function values in n points.
+      /// The interval lookup is a direct index on uniform grids, and the extrapolation is selected without branching on the flags.
+      void value(int n, const double* x, double* result) const;
+
+      /// One-dimensional function derivative values in n points.
+      void derivative(int n, const double* x, double* result) const;
+
       /// Plots the spline in format for Pylab (just pairs
       /// x-coordinate and value per line). The interval of definition
       /// of the spline will be extended by "extension" both to the left
@@ -64,6 +71,9 @@ namespace Hermes
       /// Returns false if point lies outside.
       bool find_interval(double x_in, int& m) const;
 
+      /// Index of the interval of x_in, which has to lie in the interval of definition.
+      int get_interval(double x_in) const;
+
       /// Extrapolate the value of the spline outside of its interval of definition.
       double extrapolate_value(double point_end, double value_end, double derivative_end, double x_in) const;
       /// Grid points, ordered.
@@ -94,6 +104,10 @@ namespace Hermes
       /// A set of four coefficients a, b, c, d for an elementary cubic spline.
       Hermes::vector<SplineCoeff> coeffs;
 
+      /// The points are equidistant, the interval is then found without searching.
+      bool uniform_grid;
+      double inv_grid_step;
+
       /// Gets derivative at a point that lies in interval 'm'.
       double get_derivative_from_interval(double x_in, int m) const;
 
@@ -307,6 +307,20 @@ namespace Hermes
       virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
         Geom<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+      /// Batched evaluation of the whole local matrix (optional).
+      /// Fills result[i][j] with the value of the form for the basis function u[j] and the test function v[i],
+      /// for all n_u basis and n_v test functions at once. This way the quadrature weights, geometry and
+      /// external functions are processed only once per element instead of once per (basis, test) pair.
+      /// If sym is true (the form is symmetric), u and v are the same functions (n_u == n_v) and only the upper triangle
+      /// result[i][j], j >= i has to be filled.
+      /// Used by the assembling only if has_value_local_matrix() returns true.
+      virtual void value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+        Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const;
+
+      /// The form implements value_local_matrix().
+      /// If false (default), value() is called for every (basis, test) pair.
+      virtual bool has_value_local_matrix() const;
+
     protected:
       friend class DiscreteProblem<Scalar>;
     };
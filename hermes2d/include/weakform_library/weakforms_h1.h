@@ -51,6 +51,11 @@ namespace Hermes
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u,
           Func<Hermes::Ord> *v, Geom<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+        virtual void value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+          Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const;
+
+        virtual bool has_value_local_matrix() const;
+
         virtual MatrixFormVol<Scalar>* clone() const;
 
       private:
@@ -83,6 +88,11 @@ namespace Hermes
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
           Geom<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+        virtual void value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+          Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const;
+
+        virtual bool has_value_local_matrix() const;
+
         virtual MatrixFormVol<Scalar>* clone() const;
 
       private:
@@ -110,6 +120,11 @@ namespace Hermes
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
           Geom<Hermes::Ord> *e, Func<Ord> **ext) const;
 
+        virtual void value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+          Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const;
+
+        virtual bool has_value_local_matrix() const;
+
         virtual MatrixFormVol<Scalar>* clone() const;
 
       private:
@@ -432,6 +432,7 @@ namespace Hermes
       homogenize_shared_mesh_orders(meshes);
 
       // mesh regularization
+      Hermes::vector<int> regularized_ids[H2D_MAX_COMPONENTS];
       if(regularize >= 0)
       {
         if(regularize == 0)
@@ -444,6 +445,9 @@ namespace Hermes
           int* parents;
           parents = meshes[i]->regularize(regularize);
           this->spaces[i]->distribute_orders(meshes[i], parents);
+          for_all_active_elements(e, meshes[i])
+            if(parents[e->id] != e->id)
+              regularized_ids[i].push_back(e->id);
           ::free(parents);
         }
       }
@@ -463,12 +467,25 @@ namespace Hermes
       for(unsigned int i = 0; i < this->spaces.size(); i++)
         this->spaces[i]->assign_dofs();
 
+      // assign_dofs() marks all the elements as changed, only the refined ones (and those created by the regularization) are,
+      // so that the reference spaces and the assembling can reuse the data of the rest.
       for (int i = 0; i < this->num; i++)
       {
         for_all_active_elements(e, this->spaces[i]->get_mesh())
           this->spaces[i]->edata[e->id].changed_in_last_adaptation = false;
-        for(id_to_refine = 0; id_to_refine < ids.size(); id_to_refine++)
-          this->spaces[i]->edata[ids[id_to_refine]].changed_in_last_adaptation = false;
+        for(unsigned int regularized_i = 0; regularized_i < regularized_ids[i].size(); regularized_i++)
+          this->spaces[i]->edata[regularized_ids[i][regularized_i]].changed_in_last_adaptation = true;
+      }
+      for(unsigned int refinement_i = 0; refinement_i < last_refinements.size(); refinement_i++)
+      {
+        Space<Scalar>* space = this->spaces[last_refinements[refinement_i].comp];
+        e = space->get_mesh()->get_element(last_refinements[refinement_i].id);
+        if(e->active)
+          space->edata[e->id].changed_in_last_adaptation = true;
+        else
+          for (int j = 0; j < 4; j++)
+            if(e->sons[j] != NULL && e->sons[j]->active)
+              space->edata[e->sons[j]->id].changed_in_last_adaptation = true;
       }
 
       return false;
@@ -1085,15 +1102,14 @@ namespace Hermes
 
       // Prepare multi-mesh traversal and error arrays.
       const Mesh **meshes = new const Mesh *[2 * num];
-      Transformable **tr = new Transformable *[2 * num];
-      Traverse trav(true);
+      MeshFunction<Scalar>** fns = new MeshFunction<Scalar>*[2 * num];
       num_act_elems = 0;
       for (i = 0; i < num; i++)
       {
         meshes[i] = sln[i]->get_mesh();
         meshes[i + num] = rsln[i]->get_mesh();
-        tr[i] = sln[i];
-        tr[i + num] = rsln[i];
+        fns[i] = sln[i];
+        fns[i + num] = rsln[i];
 
         num_act_elems += sln[i]->get_mesh()->get_num_active_elements();
 
@@ -1114,32 +1130,115 @@ namespace Hermes
       if(solutions_for_adapt) this->errors_squared_sum = 0.0;
       double total_error = 0.0;
 
+      // Union mesh states.
+      Hermes::vector<const Mesh*> meshes_vector;
+      for (i = 0; i < 2 * num; i++)
+        meshes_vector.push_back(meshes[i]);
+      int num_states;
+      Traverse trav_master(true);
+      Traverse::State* states = trav_master.get_states(meshes_vector, num_states);
+
+      // Per-thread copies of the solutions.
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+      MeshFunction<Scalar>*** thread_fns = Global<Scalar>::clone_for_threads(fns, 2 * num, num_threads_used);
+      Transformable*** trfs = new Transformable**[num_threads_used];
+      for(i = 0; i < num_threads_used; i++)
+      {
+        trfs[i] = new Transformable*[2 * num];
+        for(j = 0; j < 2 * num; j++)
+          trfs[i][j] = thread_fns[i][j];
+      }
+
+      // Errors and norms of the components in each state, summed in the order of the states afterwards,
+      // so that neither the result nor the element errors depend on the number of threads.
+      double* state_errors = new double[num_states * num + 1];
+      double* state_norms = new double[num_states * num + 1];
+      memset(state_errors, 0, (num_states * num + 1) * sizeof(double));
+      memset(state_norms, 0, (num_states * num + 1) * sizeof(double));
+
       // Calculate error.
-      Traverse::State * ee;
-      trav.begin(2 * num, meshes, tr);
-      while ((ee = trav.get_next_state()) != NULL)
+      this->caughtException = NULL;
+      int state_i;
+#pragma omp parallel shared(states, thread_fns, trfs, state_errors, state_norms) private(state_i, i, j) num_threads(num_threads_used)
       {
-        for (i = 0; i < num; i++)
+#pragma omp for schedule(dynamic, 1)
+        for(state_i = 0; state_i < num_states; state_i++)
         {
-          for (j = 0; j < num; j++)
+          if(this->caughtException != NULL)
+            continue;
+
+          try
           {
-            if(error_form[i][j] != NULL)
+            MeshFunction<Scalar>** current_fns = thread_fns[omp_get_thread_num()];
+            Traverse::set_state_transforms(states + state_i, trfs[omp_get_thread_num()]);
+
+            for (i = 0; i < num; i++)
             {
-              double err, nrm;
-              err = eval_error(error_form[i][j], sln[i], sln[j], rsln[i], rsln[j]);
-              nrm = eval_error_norm(norm_form[i][j], rsln[i], rsln[j]);
-
-              norms[i] += nrm;
-              total_norm  += nrm;
-              total_error += err;
-              errors_components[i] += err;
-              if(solutions_for_adapt)
-                this->errors[i][ee->e[i]->id] += err;
+              for (j = 0; j < num; j++)
+              {
+                if(error_form[i][j] != NULL)
+                {
+                  state_errors[state_i * num + i] += eval_error(error_form[i][j], current_fns[i], current_fns[j], current_fns[i + num], current_fns[j + num]);
+                  state_norms[state_i * num + i] += eval_error_norm(norm_form[i][j], current_fns[i + num], current_fns[j + num]);
+                }
+              }
             }
           }
+          catch(Hermes::Exceptions::Exception& exception)
+          {
+#pragma omp critical (adapt_caught_exception)
+            if(this->caughtException == NULL)
+              this->caughtException = exception.clone();
+          }
+          catch(std::exception& exception)
+          {
+#pragma omp critical (adapt_caught_exception)
+            if(this->caughtException == NULL)
+              this->caughtException = new Hermes::Exceptions::Exception(exception.what());
+          }
+        }
+      }
+
+      if(this->caughtException == NULL)
+      {
+        for(state_i = 0; state_i < num_states; state_i++)
+        {
+          for (i = 0; i < num; i++)
+          {
+            double err = state_errors[state_i * num + i];
+            double nrm = state_norms[state_i * num + i];
+
+            norms[i] += nrm;
+            total_norm  += nrm;
+            total_error += err;
+            errors_components[i] += err;
+            if(solutions_for_adapt)
+              this->errors[i][states[state_i].e[i]->id] += err;
+          }
+        }
+      }
+
+      for(i = 0; i < num_threads_used; i++)
+        delete [] trfs[i];
+      delete [] trfs;
+      Global<Scalar>::free_thread_clones(thread_fns, 2 * num, num_threads_used);
+      delete [] state_errors;
+      delete [] state_norms;
+      delete [] states;
+      delete [] fns;
+
+      if(this->caughtException != NULL)
+      {
+        for (i = 0; i < this->num; i++)
+        {
+          this->sln[i] = slns_original[i];
+          this->rsln[i] = rslns_original[i];
         }
+        delete [] meshes;
+        delete [] norms;
+        delete [] errors_components;
+        throw *(this->caughtException);
       }
-      trav.finish();
 
       // Store the calculation for each solution component separately.
       if(component_errors != NULL)
@@ -1199,7 +1298,6 @@ namespace Hermes
       }
 
       delete [] meshes;
-      delete [] tr;
       delete [] norms;
       delete [] errors_components;
 
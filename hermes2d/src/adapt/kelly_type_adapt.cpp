@@ -13,6 +13,7 @@
 // You should have received a copy of the GNU General Public License
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
 #include "kelly_type_adapt.h"
+#include "api2d.h"
 
 namespace Hermes
 {
@@ -127,12 +128,14 @@ namespace Hermes
       this->have_coarse_solutions = true;
 
       const Mesh** meshes = new const Mesh*[this->num];
-      Transformable** fns = new Transformable*[this->num];
+      Hermes::vector<const Mesh*> meshes_vector;
+      MeshFunction<Scalar>** fns = new MeshFunction<Scalar>*[this->num];
 
       this->num_act_elems = 0;
       for (int i = 0; i < this->num; i++)
       {
         meshes[i] = (this->sln[i]->get_mesh());
+        meshes_vector.push_back(meshes[i]);
         fns[i] = (this->sln[i]);
 
         this->num_act_elems += meshes[i]->get_num_active_elements();
@@ -161,263 +164,145 @@ namespace Hermes
       this->errors_squared_sum = 0.0;
       double total_error = 0.0;
 
-      bool bnd[H2D_MAX_NUMBER_EDGES];
-      SurfPos surf_pos[H2D_MAX_NUMBER_EDGES];
-      Traverse::State *ee;
-      Traverse trav(true);
+      // The neighbor searches of the interface estimators need the spaces.
+      for (unsigned int iest = 0; iest < error_estimators_surf.size(); iest++)
+      {
+        if(error_estimators_surf[iest]->area == H2D_DG_INNER_EDGE)
+        {
+          Hermes::vector<const Space<Scalar>*> dp_spaces;
+          for (int i = 0; i < this->num; i++)
+            dp_spaces.push_back(this->spaces[i]);
+          this->dp.set_spaces(dp_spaces);
+          break;
+        }
+      }
 
-      // Reset the e->visited status of each element of each mesh (most likely it will be set to true from
-      // the latest assembling procedure).
-      if(ignore_visited_segments)
+      // Determine the minimum mesh seq.
+      unsigned int min_dg_mesh_seq = 0;
+      for(unsigned int j = 0; j < this->spaces.size(); j++)
+        if(this->spaces[j]->get_mesh()->get_seq() < min_dg_mesh_seq || j == 0)
+          min_dg_mesh_seq = this->spaces[j]->get_mesh()->get_seq();
+
+      // Union mesh states.
+      int num_states;
+      Traverse trav_master(true);
+      Traverse::State* states = trav_master.get_states(meshes_vector, num_states);
+
+      // Per-thread copies of the solutions. The external functions of the estimator forms are shared,
+      // so the estimators are evaluated serially if there are any.
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+      for (unsigned int iest = 0; iest < error_estimators_vol.size(); iest++)
+        if(error_estimators_vol[iest]->ext.size() > 0)
+          num_threads_used = 1;
+      for (unsigned int iest = 0; iest < error_estimators_surf.size(); iest++)
+        if(error_estimators_surf[iest]->ext.size() > 0)
+          num_threads_used = 1;
+      MeshFunction<Scalar>*** thread_fns = Global<Scalar>::clone_for_threads(fns, this->num, num_threads_used);
+      Solution<Scalar>*** thread_slns = new Solution<Scalar>**[num_threads_used];
+      Transformable*** trfs = new Transformable**[num_threads_used];
+      for(int thread_i = 0; thread_i < num_threads_used; thread_i++)
       {
+        thread_slns[thread_i] = new Solution<Scalar>*[this->num];
+        trfs[thread_i] = new Transformable*[this->num];
         for (int i = 0; i < this->num; i++)
         {
-          Element* e;
-          for_all_active_elements(e, meshes[i])
-            e->visited = false;
+          thread_slns[thread_i][i] = static_cast<Solution<Scalar>*>(thread_fns[thread_i][i]);
+          trfs[thread_i][i] = thread_fns[thread_i][i];
         }
       }
 
-      // Begin the multimesh traversal.
-      trav.begin(this->num, meshes, fns);
-      while ((ee = trav.get_next_state()) != NULL)
+      // Errors and norms of the components in each state, and the interface errors added to the elements on the other
+      // side of the evaluated segments, summed in the order of the states afterwards, so that neither the result
+      // nor the element errors depend on the number of threads.
+      double* state_errors = new double[num_states * this->num + 1];
+      double* state_norms = new double[num_states * this->num + 1];
+      memset(state_errors, 0, (num_states * this->num + 1) * sizeof(double));
+      memset(state_norms, 0, (num_states * this->num + 1) * sizeof(double));
+      Hermes::vector<std::pair<int, double> >* state_neighbor_errors = new Hermes::vector<std::pair<int, double> >[num_states * this->num + 1];
+
+      this->caughtException = NULL;
+      int state_i;
+#pragma omp parallel shared(states, thread_slns, trfs, state_errors, state_norms, state_neighbor_errors) private(state_i) num_threads(num_threads_used)
       {
-        bnd[0] = ee->bnd[0];
-        bnd[1] = ee->bnd[1];
-        bnd[2] = ee->bnd[2];
-        bnd[3] = ee->bnd[3];
-
-        surf_pos[0].marker = ee->rep->en[0]->marker;
-        surf_pos[1].marker = ee->rep->en[1]->marker;
-        surf_pos[2].marker = ee->rep->en[2]->marker;
-        surf_pos[3].marker = ee->rep->en[3]->marker;
-
-        surf_pos[0].surf_num = 0;
-        surf_pos[1].surf_num = 1;
-        surf_pos[2].surf_num = 2;
-        surf_pos[3].surf_num = 3;
-
-        // Go through all solution components.
-        for (int i = 0; i < this->num; i++)
+#pragma omp for schedule(dynamic, 1)
+        for(state_i = 0; state_i < num_states; state_i++)
         {
-          if(ee->e[i] == NULL)
+          if(this->caughtException != NULL)
             continue;
 
-          // Set maximum integration order for use in integrals, see limit_order()
-          update_limit_table(ee->e[i]->get_mode());
-
-          RefMap *rm = this->sln[i]->get_refmap();
-
-          double err = 0.0;
-
-          // Go through all volumetric error estimators.
-          for (unsigned int iest = 0; iest < error_estimators_vol.size(); iest++)
+          try
           {
-            // Skip current error estimator if it is assigned to a different component or geometric area
-            // different from that of the current active element.
-
-            if(error_estimators_vol[iest]->i != i)
-              continue;
-
-            if(error_estimators_vol[iest]->area != HERMES_ANY)
-              if(!element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).valid || element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).marker != ee->e[i]->marker)
-                continue;
-
-            err += eval_volumetric_estimator(error_estimators_vol[iest], rm);
+            calc_err_state(states + state_i, thread_slns[omp_get_thread_num()], trfs[omp_get_thread_num()], min_dg_mesh_seq, calc_norm,
+              state_errors + state_i * this->num, state_norms + state_i * this->num, state_neighbor_errors + state_i * this->num);
+          }
+          catch(Hermes::Exceptions::Exception& exception)
+          {
+#pragma omp critical (kelly_caught_exception)
+            if(this->caughtException == NULL)
+              this->caughtException = exception.clone();
           }
+          catch(std::exception& exception)
+          {
+#pragma omp critical (kelly_caught_exception)
+            if(this->caughtException == NULL)
+              this->caughtException = new Hermes::Exceptions::Exception(exception.what());
+          }
+        }
+      }
 
-          // Go through all surface error estimators (includes both interface and boundary est's).
-          for (unsigned int iest = 0; iest < error_estimators_surf.size(); iest++)
+      if(this->caughtException == NULL)
+      {
+        for(state_i = 0; state_i < num_states; state_i++)
+        {
+          for (int i = 0; i < this->num; i++)
           {
-            if(error_estimators_surf[iest]->i != i)
+            if(states[state_i].e[i] == NULL)
               continue;
 
-            for (int isurf = 0; isurf < ee->e[i]->get_nvert(); isurf++)
-            {
-              if(bnd[isurf])   // Boundary
-              {
-                if(error_estimators_surf[iest]->area != HERMES_ANY)
-                {
-                  if(!boundary_markers_conversion.get_internal_marker(error_estimators_surf[iest]->area).valid)
-                    continue;
-                  int imarker = boundary_markers_conversion.get_internal_marker(error_estimators_surf[iest]->area).marker;
-
-                  if(imarker == H2D_DG_INNER_EDGE_INT)
-                    continue;
-                  if(imarker != surf_pos[isurf].marker)
-                    continue;
-                }
-
-                err += eval_boundary_estimator(error_estimators_surf[iest], rm, &surf_pos[isurf]);
-              }
-              else              // Interface
-              {
-                if(error_estimators_surf[iest]->area != H2D_DG_INNER_EDGE)
-                  continue;
-
-                // BEGIN COPY FROM DISCRETE_PROBLEM.CPP
-
-                // 5 is for bits per page in the array.
-                LightArray<NeighborSearch<Scalar>*> neighbor_searches(5);
-                unsigned int num_neighbors = 0;
-                NeighborNode* root;
-                int ns_index;
-
-                // Determine the minimum mesh seq in this stage.
-                unsigned int min_dg_mesh_seq = 0;
-                for(unsigned int j = 0; j < this->spaces.size(); j++)
-                  if(this->spaces[j]->get_mesh()->get_seq() < min_dg_mesh_seq || j == 0)
-                    min_dg_mesh_seq = this->spaces[j]->get_mesh()->get_seq();
-
-                ns_index = meshes[i]->get_seq() - min_dg_mesh_seq; // = 0 for single mesh
-
-                // Initialize the NeighborSearches.
-                this->dp.init_neighbors(neighbor_searches, ee, min_dg_mesh_seq);
-
-                // Create a multimesh tree;
-                root = new NeighborNode(NULL, 0);
-                this->dp.build_multimesh_tree(root, neighbor_searches);
-
-                // Update all NeighborSearches according to the multimesh tree.
-                // After this, all NeighborSearches in neighbor_searches should have the same count
-                // of neighbors and proper set of transformations
-                // for the central and the neighbor element(s) alike.
-                // Also check that every NeighborSearch has the same number of neighbor elements.
-                for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                {
-                  if(neighbor_searches.present(j))
-                  {
-                    NeighborSearch<Scalar>* ns = neighbor_searches.get(j);
-                    this->dp.update_neighbor_search(ns, root);
-                    if(num_neighbors == 0)
-                      num_neighbors = ns->n_neighbors;
-                    if(ns->n_neighbors != num_neighbors)
-                      throw Hermes::Exceptions::Exception("Num_neighbors of different NeighborSearches not matching in KellyTypeAdapt<Scalar>::calc_err_internal.");
-                  }
-                }
-
-                // Go through all segments of the currently processed interface (segmentation is caused
-                // by hanging nodes on the other side of the interface).
-                for (unsigned int neighbor = 0; neighbor < num_neighbors; neighbor++)
-                {
-                  if(ignore_visited_segments)
-                  {
-                    bool processed = true;
-                    for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                      if(neighbor_searches.present(j))
-                        if(!neighbor_searches.get(j)->neighbors.at(neighbor)->visited)
-                        {
-                          processed = false;
-                          break;
-                        }
-
-                    if(processed) continue;
-                  }
-
-                  // We do not use cache_e and cache_jwt here.
-
-                  // Set the active segment in all NeighborSearches
-                  for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                  {
-                    if(neighbor_searches.present(j))
-                    {
-                      neighbor_searches.get(j)->active_segment = neighbor;
-                      neighbor_searches.get(j)->neighb_el = neighbor_searches.get(j)->neighbors[neighbor];
-                      neighbor_searches.get(j)->neighbor_edge = neighbor_searches.get(j)->neighbor_edges[neighbor];
-                    }
-                  }
-
-                  // Push all the necessary transformations to all functions of this stage.
-                  // The important thing is that the transformations to the current subelement are already there.
-                  // Also store the current neighbor element and neighbor edge in neighb_el, neighbor_edge.
-                  for(unsigned int fns_i = 0; fns_i < this->num; fns_i++)
-                  {
-                    NeighborSearch<Scalar> *ns = neighbor_searches.get(meshes[fns_i]->get_seq() - min_dg_mesh_seq);
-                    if(ns->central_transformations.present(neighbor))
-                      ns->central_transformations.get(neighbor)->apply_on(fns[fns_i]);
-                  }
-
-                  // END COPY FROM DISCRETE_PROBLEM.CPP
-                  rm->force_transform(this->sln[i]->get_transform(), this->sln[i]->get_ctm());
-
-                  // The estimate is multiplied by 0.5 in order to distribute the error equally onto
-                  // the two neighboring elements.
-                  double central_err = 0.5 * eval_interface_estimator(error_estimators_surf[iest],
-                                                                      rm, &surf_pos[isurf], neighbor_searches,
-                                                                      ns_index);
-                  double neighb_err = central_err;
-
-                  // Scale the error estimate by the scaling function dependent on the element diameter
-                  // (use the central element's diameter).
-                  if(use_aposteriori_interface_scaling && interface_scaling_fns[i])
-                    if(!element_markers_conversion.get_user_marker(ee->e[i]->marker).valid)
-                      throw Hermes::Exceptions::Exception("Marker not valid.");
-                    else
-                      central_err *= interface_scaling_fns[i]->value(ee->e[i]->get_diameter(), element_markers_conversion.get_user_marker(ee->e[i]->marker).marker);
-
-                  // In the case this edge will be ignored when calculating the error for the element on
-                  // the other side, add the now computed error to that element as well.
-                  if(ignore_visited_segments)
-                  {
-                    Element *neighb = neighbor_searches.get(ns_index)->neighb_el;
-
-                    // Scale the error estimate by the scaling function dependent on the element diameter
-                    // (use the diameter of the element on the other side).
-                    if(use_aposteriori_interface_scaling && interface_scaling_fns[i])
-                      if(!element_markers_conversion.get_user_marker(neighb->marker).valid)
-                      throw Hermes::Exceptions::Exception("Marker not valid.");
-                    else
-                      neighb_err *= interface_scaling_fns[i]->value(neighb->get_diameter(), element_markers_conversion.get_user_marker(neighb->marker).marker);
-
-                    errors_components[i] += central_err + neighb_err;
-                    total_error += central_err + neighb_err;
-                    this->errors[i][ee->e[i]->id] += central_err;
-                    this->errors[i][neighb->id] += neighb_err;
-                  }
-                  else
-                    err += central_err;
-
-                  // BEGIN COPY FROM DISCRETE_PROBLEM.CPP
-
-                  // Clear the transformations from the RefMaps and all functions.
-                  for(unsigned int fns_i = 0; fns_i < this->num; fns_i++)
-                    fns[fns_i]->set_transform(neighbor_searches.get(meshes[fns_i]->get_seq() - min_dg_mesh_seq)->original_central_el_transform);
-
-                  rm->set_transform(neighbor_searches.get(ns_index)->original_central_el_transform);
-
-                  // END COPY FROM DISCRETE_PROBLEM.CPP
-                }
-
-                // BEGIN COPY FROM DISCRETE_PROBLEM.CPP
-
-                // Delete the multimesh tree;
-                delete root;
-
-                // Delete the neighbor_searches array.
-                for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                  if(neighbor_searches.present(j))
-                    delete neighbor_searches.get(j);
+            double err = state_errors[state_i * this->num + i];
+            errors_components[i] += err;
+            total_error += err;
+            this->errors[i][states[state_i].e[i]->id] += err;
 
-                // END COPY FROM DISCRETE_PROBLEM.CPP
-              }
+            Hermes::vector<std::pair<int, double> >& neighbor_errors = state_neighbor_errors[state_i * this->num + i];
+            for(unsigned int j = 0; j < neighbor_errors.size(); j++)
+            {
+              errors_components[i] += neighbor_errors[j].second;
+              total_error += neighbor_errors[j].second;
+              this->errors[i][neighbor_errors[j].first] += neighbor_errors[j].second;
             }
-          }
 
-          if(calc_norm)
-          {
-            double nrm = eval_solution_norm(this->norm_form[i][i], rm, this->sln[i]);
-            norms[i] += nrm;
-            total_norm += nrm;
+            if(calc_norm)
+            {
+              norms[i] += state_norms[state_i * this->num + i];
+              total_norm += state_norms[state_i * this->num + i];
+            }
           }
-
-          errors_components[i] += err;
-          total_error += err;
-          this->errors[i][ee->e[i]->id] += err;
-
-          ee->e[i]->visited = true;
         }
       }
-      trav.finish();
+
+      for(int thread_i = 0; thread_i < num_threads_used; thread_i++)
+      {
+        delete [] thread_slns[thread_i];
+        delete [] trfs[thread_i];
+      }
+      delete [] thread_slns;
+      delete [] trfs;
+      Global<Scalar>::free_thread_clones(thread_fns, this->num, num_threads_used);
+      delete [] state_errors;
+      delete [] state_norms;
+      delete [] state_neighbor_errors;
+      delete [] states;
+      delete [] fns;
+
+      if(this->caughtException != NULL)
+      {
+        delete [] meshes;
+        if(calc_norm)
+          delete [] norms;
+        delete [] errors_components;
+        throw *(this->caughtException);
+      }
 
       // Store the calculation for each solution component separately.
       if(component_errors != NULL)
@@ -463,6 +348,7 @@ namespace Hermes
       this->fill_regular_queue(meshes);
       this->have_errors = true;
 
+      delete [] meshes;
       if(calc_norm)
         delete [] norms;
       delete [] errors_components;
@@ -479,6 +365,219 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::calc_err_state(Traverse::State* ee, Solution<Scalar>** slns, Transformable** fns, unsigned int min_dg_mesh_seq,
+                                                bool calc_norm, double* errors, double* norms, Hermes::vector<std::pair<int, double> >* neighbor_errors)
+    {
+      Traverse::set_state_transforms(ee, fns);
+
+      SurfPos surf_pos[H2D_MAX_NUMBER_EDGES];
+      for (int isurf = 0; isurf < ee->rep->get_nvert(); isurf++)
+      {
+        surf_pos[isurf].marker = ee->rep->en[isurf]->marker;
+        surf_pos[isurf].surf_num = isurf;
+      }
+
+      bool interface_estimators_present = false;
+
+      // Go through all solution components, evaluate the volumetric and boundary estimators.
+      for (int i = 0; i < this->num; i++)
+      {
+        if(ee->e[i] == NULL)
+          continue;
+
+        RefMap *rm = slns[i]->get_refmap();
+
+        // Go through all volumetric error estimators.
+        for (unsigned int iest = 0; iest < error_estimators_vol.size(); iest++)
+        {
+          // Skip current error estimator if it is assigned to a different component or geometric area
+          // different from that of the current active element.
+          if(error_estimators_vol[iest]->i != i)
+            continue;
+
+          if(error_estimators_vol[iest]->area != HERMES_ANY)
+            if(!element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).valid || element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).marker != ee->e[i]->marker)
+              continue;
+
+          errors[i] += eval_volumetric_estimator(error_estimators_vol[iest], rm, slns);
+        }
+
+        // Go through all boundary error estimators, the interface ones are evaluated below.
+        for (unsigned int iest = 0; iest < error_estimators_surf.size(); iest++)
+        {
+          if(error_estimators_surf[iest]->i != i)
+            continue;
+
+          if(error_estimators_surf[iest]->area == H2D_DG_INNER_EDGE)
+          {
+            interface_estimators_present = true;
+            continue;
+          }
+
+          for (int isurf = 0; isurf < ee->e[i]->get_nvert(); isurf++)
+          {
+            if(!ee->bnd[isurf])
+              continue;
+
+            if(error_estimators_surf[iest]->area != HERMES_ANY)
+            {
+              if(!boundary_markers_conversion.get_internal_marker(error_estimators_surf[iest]->area).valid)
+                continue;
+              int imarker = boundary_markers_conversion.get_internal_marker(error_estimators_surf[iest]->area).marker;
+
+              if(imarker == H2D_DG_INNER_EDGE_INT)
+                continue;
+              if(imarker != surf_pos[isurf].marker)
+                continue;
+            }
+
+            errors[i] += eval_boundary_estimator(error_estimators_surf[iest], rm, &surf_pos[isurf], slns);
+          }
+        }
+
+        if(calc_norm)
+          norms[i] += eval_solution_norm(this->norm_form[i][i], rm, slns[i]);
+      }
+
+      if(!interface_estimators_present)
+        return;
+
+      // Interface estimators. The neighbor searches of an inner edge are done once and shared by all the components
+      // and estimators.
+      for (int isurf = 0; isurf < ee->rep->get_nvert(); isurf++)
+      {
+        if(ee->bnd[isurf])
+          continue;
+
+        ee->isurf = isurf;
+
+        // 5 is for bits per page in the array.
+        LightArray<NeighborSearch<Scalar>*> neighbor_searches(5);
+        unsigned int num_neighbors = 0;
+
+        // Initialize the NeighborSearches.
+        this->dp.init_neighbors(neighbor_searches, ee, min_dg_mesh_seq);
+
+        // Create a multimesh tree;
+        NeighborNode* root = new NeighborNode(NULL, 0);
+        this->dp.build_multimesh_tree(root, neighbor_searches);
+
+        // Update all NeighborSearches according to the multimesh tree.
+        // After this, all NeighborSearches in neighbor_searches should have the same count
+        // of neighbors and proper set of transformations
+        // for the central and the neighbor element(s) alike.
+        // Also check that every NeighborSearch has the same number of neighbor elements.
+        for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
+        {
+          if(neighbor_searches.present(j))
+          {
+            NeighborSearch<Scalar>* ns = neighbor_searches.get(j);
+            this->dp.update_neighbor_search(ns, root);
+            if(num_neighbors == 0)
+              num_neighbors = ns->n_neighbors;
+            if(ns->n_neighbors != num_neighbors)
+              throw Hermes::Exceptions::Exception("Num_neighbors of different NeighborSearches not matching in KellyTypeAdapt<Scalar>::calc_err_internal.");
+          }
+        }
+
+        // Go through all segments of the currently processed interface (segmentation is caused
+        // by hanging nodes on the other side of the interface).
+        for (unsigned int neighbor = 0; neighbor < num_neighbors; neighbor++)
+        {
+          // The segment is evaluated from one side only, see DiscreteProblem::DG_segment_assembled_from_neighbor().
+          if(ignore_visited_segments && this->dp.DG_segment_assembled_from_neighbor(neighbor_searches, neighbor))
+            continue;
+
+          // Set the active segment in all NeighborSearches
+          for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
+          {
+            if(neighbor_searches.present(j))
+            {
+              neighbor_searches.get(j)->active_segment = neighbor;
+              neighbor_searches.get(j)->neighb_el = neighbor_searches.get(j)->neighbors[neighbor];
+              neighbor_searches.get(j)->neighbor_edge = neighbor_searches.get(j)->neighbor_edges[neighbor];
+            }
+          }
+
+          // Push all the necessary transformations to all functions of this stage.
+          // The important thing is that the transformations to the current subelement are already there.
+          for(unsigned int fns_i = 0; fns_i < this->num; fns_i++)
+          {
+            NeighborSearch<Scalar> *ns = neighbor_searches.get(slns[fns_i]->get_mesh()->get_seq() - min_dg_mesh_seq);
+            if(ns->central_transformations.present(neighbor))
+              ns->central_transformations.get(neighbor)->apply_on(fns[fns_i]);
+          }
+
+          for (int i = 0; i < this->num; i++)
+          {
+            if(ee->e[i] == NULL)
+              continue;
+
+            int ns_index = slns[i]->get_mesh()->get_seq() - min_dg_mesh_seq; // = 0 for single mesh
+            RefMap *rm = slns[i]->get_refmap();
+            rm->force_transform(slns[i]->get_transform(), slns[i]->get_ctm());
+
+            for (unsigned int iest = 0; iest < error_estimators_surf.size(); iest++)
+            {
+              if(error_estimators_surf[iest]->i != i || error_estimators_surf[iest]->area != H2D_DG_INNER_EDGE)
+                continue;
+
+              // The estimate is multiplied by 0.5 in order to distribute the error equally onto
+              // the two neighboring elements.
+              double central_err = 0.5 * eval_interface_estimator(error_estimators_surf[iest],
+                                                                  rm, &surf_pos[isurf], neighbor_searches,
+                                                                  ns_index, min_dg_mesh_seq, slns);
+              double neighb_err = central_err;
+
+              // Scale the error estimate by the scaling function dependent on the element diameter
+              // (use the central element's diameter).
+              if(use_aposteriori_interface_scaling && interface_scaling_fns[i])
+                if(!element_markers_conversion.get_user_marker(ee->e[i]->marker).valid)
+                  throw Hermes::Exceptions::Exception("Marker not valid.");
+                else
+                  central_err *= interface_scaling_fns[i]->value(ee->e[i]->get_diameter(), element_markers_conversion.get_user_marker(ee->e[i]->marker).marker);
+
+              errors[i] += central_err;
+
+              // In the case this edge will be ignored when calculating the error for the element on
+              // the other side, add the now computed error to that element as well.
+              if(ignore_visited_segments)
+              {
+                Element *neighb = neighbor_searches.get(ns_index)->neighb_el;
+
+                // Scale the error estimate by the scaling function dependent on the element diameter
+                // (use the diameter of the element on the other side).
+                if(use_aposteriori_interface_scaling && interface_scaling_fns[i])
+                  if(!element_markers_conversion.get_user_marker(neighb->marker).valid)
+                    throw Hermes::Exceptions::Exception("Marker not valid.");
+                  else
+                    neighb_err *= interface_scaling_fns[i]->value(neighb->get_diameter(), element_markers_conversion.get_user_marker(neighb->marker).marker);
+
+                neighbor_errors[i].push_back(std::pair<int, double>(neighb->id, neighb_err));
+              }
+            }
+          }
+
+          // Clear the transformations from the RefMaps and all functions.
+          for(unsigned int fns_i = 0; fns_i < this->num; fns_i++)
+          {
+            uint64_t original_transform = neighbor_searches.get(slns[fns_i]->get_mesh()->get_seq() - min_dg_mesh_seq)->original_central_el_transform;
+            fns[fns_i]->set_transform(original_transform);
+            slns[fns_i]->get_refmap()->set_transform(original_transform);
+          }
+        }
+
+        // Delete the multimesh tree;
+        delete root;
+
+        // Delete the neighbor_searches array.
+        for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
+          if(neighbor_searches.present(j))
+            delete neighbor_searches.get(j);
+      }
+    }
+
     template<typename Scalar>
     double KellyTypeAdapt<Scalar>::eval_solution_norm(typename Adapt<Scalar>::MatrixFormVolError* form,
                                                       RefMap *rm, MeshFunction<Scalar>* sln)
@@ -527,14 +626,14 @@ namespace Hermes
 
     template<typename Scalar>
     double KellyTypeAdapt<Scalar>::eval_volumetric_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
-                                                             RefMap *rm)
+                                                             RefMap *rm, Solution<Scalar>** slns)
     {
       // Determine the integration order.
-      int inc = (this->sln[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
+      int inc = (slns[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
 
       Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[this->num];
       for (int i = 0; i < this->num; i++)
-        oi[i] = init_fn_ord(this->sln[i]->get_fn_order() + inc);
+        oi[i] = init_fn_ord(slns[i]->get_fn_order() + inc);
 
       // Polynomial order of additional external functions.
       Func<Hermes::Ord>** fake_ext_fn = new Func<Hermes::Ord>*[err_est_form->ext.size()];
@@ -568,7 +667,7 @@ namespace Hermes
       delete [] fake_ext_fn;
 
       // eval the form
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
+      Quad2D* quad = slns[err_est_form->i]->get_quad_2d();
       double3* pt = quad->get_points(order, rm->get_active_element()->get_mode());
       int np = quad->get_num_points(order, rm->get_active_element()->get_mode());
 
@@ -583,7 +682,7 @@ namespace Hermes
       Func<Scalar>** ui = new Func<Scalar>*[this->num];
 
       for (int i = 0; i < this->num; i++)
-        ui[i] = init_fn(this->sln[i], order);
+        ui[i] = init_fn(slns[i], order);
 
       Func<Scalar>** ext_fn = new Func<Scalar>*[err_est_form->ext.size()];
       for (unsigned i = 0; i < err_est_form->ext.size(); i++)
@@ -622,13 +721,13 @@ namespace Hermes
 
     template<typename Scalar>
     double KellyTypeAdapt<Scalar>::eval_boundary_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
-                                                           RefMap *rm, SurfPos* surf_pos)
+                                                           RefMap *rm, SurfPos* surf_pos, Solution<Scalar>** slns)
     {
       // Determine the integration order.
-      int inc = (this->sln[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
+      int inc = (slns[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
       Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[this->num];
       for (int i = 0; i < this->num; i++)
-        oi[i] = init_fn_ord(this->sln[i]->get_edge_fn_order(surf_pos->surf_num) + inc);
+        oi[i] = init_fn_ord(slns[i]->get_edge_fn_order(surf_pos->surf_num) + inc);
 
       // Polynomial order of additional external functions.
       Func<Hermes::Ord>** fake_ext_fn = new Func<Hermes::Ord>*[err_est_form->ext.size()];
@@ -659,7 +758,7 @@ namespace Hermes
       delete [] fake_ext_fn;
 
       // Evaluate the form.
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
+      Quad2D* quad = slns[err_est_form->i]->get_quad_2d();
       int eo = quad->get_edge_points(surf_pos->surf_num, order, rm->get_active_element()->get_mode());
       double3* pt = quad->get_points(eo, rm->get_active_element()->get_mode());
       int np = quad->get_num_points(eo, rm->get_active_element()->get_mode());
@@ -674,7 +773,7 @@ namespace Hermes
       // Function values
       Func<Scalar>** ui = new Func<Scalar>*[this->num];
       for (int i = 0; i < this->num; i++)
-        ui[i] = init_fn(this->sln[i], eo);
+        ui[i] = init_fn(slns[i], eo);
 
       Func<Scalar>** ext_fn = new Func<Scalar>*[err_est_form->ext.size()];
       for (unsigned i = 0; i < err_est_form->ext.size(); i++)
@@ -716,29 +815,30 @@ namespace Hermes
     double KellyTypeAdapt<Scalar>::eval_interface_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
                                                             RefMap *rm, SurfPos* surf_pos,
                                                             LightArray<NeighborSearch<Scalar>*>& neighbor_searches,
-                                                            int neighbor_index)
+                                                            int neighbor_index, unsigned int min_dg_mesh_seq,
+                                                            Solution<Scalar>** slns)
     {
       NeighborSearch<Scalar>* nbs = neighbor_searches.get(neighbor_index);
-      Hermes::vector<MeshFunction<Scalar>*> slns;
+      Hermes::vector<MeshFunction<Scalar>*> fns;
       for (int i = 0; i < this->num; i++)
-        slns.push_back(this->sln[i]);
+        fns.push_back(slns[i]);
 
       // Determine integration order.
-      Func<Hermes::Ord>** fake_ext_fns = new Func<Hermes::Ord>*[err_est_form->ext.size()];
-      for (unsigned int j = 0; j < err_est_form->ext.size(); j++)
+      Func<Hermes::Ord>** fake_ext_fns = new Func<Hermes::Ord>*[this->num];
+      for (int j = 0; j < this->num; j++)
       {
-        int inc = (err_est_form->ext[j]->get_num_components() == 2) ? 1 : 0;
-        int central_order = err_est_form->ext[j]->get_edge_fn_order(neighbor_searches.get(err_est_form->ext[j]->get_mesh()->get_seq())->active_edge) + inc;
-        int neighbor_order = err_est_form->ext[j]->get_edge_fn_order(neighbor_searches.get(err_est_form->ext[j]->get_mesh()->get_seq())->neighbor_edge.local_num_of_edge) + inc;
+        NeighborSearch<Scalar>* ns = neighbor_searches.get(slns[j]->get_mesh()->get_seq() - min_dg_mesh_seq);
+        int inc = (slns[j]->get_num_components() == 2) ? 1 : 0;
+        int central_order = slns[j]->get_edge_fn_order(ns->active_edge) + inc;
+        int neighbor_order = slns[j]->get_edge_fn_order(ns->neighbor_edge.local_num_of_edge) + inc;
         fake_ext_fns[j] = new DiscontinuousFunc<Hermes::Ord>(init_fn_ord(central_order), init_fn_ord(neighbor_order));
       }
 
       // Polynomial order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
       Geom<Hermes::Ord>* fake_e = new InterfaceGeom<Hermes::Ord>(init_geom_ord(), nbs->neighb_el->marker, nbs->neighb_el->id, Hermes::Ord(nbs->neighb_el->get_diameter()));
       double fake_wt = 1.0;
-      DiscontinuousFunc<Hermes::Ord> fake_ext_fns_i(fake_ext_fns[err_est_form->i], false, false);
-      
-      Hermes::Ord o = err_est_form->ord(1, &fake_wt, fake_ext_fns, &fake_ext_fns_i, fake_e, NULL);
+
+      Hermes::Ord o = err_est_form->ord(1, &fake_wt, fake_ext_fns, static_cast<DiscontinuousFunc<Hermes::Ord>*>(fake_ext_fns[err_est_form->i]), fake_e, NULL);
 
       int order = rm->get_inv_ref_order();
       order += o.get_order();
@@ -756,9 +856,7 @@ namespace Hermes
       fake_e->free_ord();
       delete fake_e;
 
-      //delete fake_ext;
-
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
+      Quad2D* quad = slns[err_est_form->i]->get_quad_2d();
       int eo = quad->get_edge_points(surf_pos->surf_num, order, rm->get_active_element()->get_mode());
       int np = quad->get_num_points(eo, rm->get_active_element()->get_mode());
       double3* pt = quad->get_points(eo, rm->get_active_element()->get_mode());
@@ -775,15 +873,18 @@ namespace Hermes
         jwt[i] = pt[i][2] * tan[i][2];
 
       // Function values.
-      DiscontinuousFunc<Scalar>** ui = this->dp.init_ext_fns(slns, neighbor_searches, order, 0);
+      DiscontinuousFunc<Scalar>** ui = this->dp.init_ext_fns(fns, neighbor_searches, order, min_dg_mesh_seq);
 
       Scalar res = interface_scaling_const *
         err_est_form->value(np, jwt, NULL, ui[err_est_form->i], e, NULL);
 
       if(ui != NULL)
       {
-        for(unsigned int i = 0; i < slns.size(); i++)
+        for(unsigned int i = 0; i < fns.size(); i++)
+        {
           ui[i]->free_fn();
+          delete ui[i];
+        }
         delete [] ui;
       }
 
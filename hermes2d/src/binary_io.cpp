@@ -0,0 +1,366 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "binary_io.h"
+#include <cstring>
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    static const unsigned int H2D_BINARY_BYTE_ORDER_MARK = 0x01020304;
+    static const unsigned int H2D_BINARY_FLAG_COMPRESSED = 0x1;
+    static const size_t H2D_BINARY_HEADER_SIZE = 32;
+    static const size_t H2D_BINARY_ALIGNMENT = 16;
+
+    enum BinarySectionEncoding
+    {
+      H2D_BINARY_RAW = 0,
+      H2D_BINARY_SHUFFLED_DEFLATE = 1
+    };
+
+    static size_t binary_padding(size_t size)
+    {
+      return (H2D_BINARY_ALIGNMENT - size % H2D_BINARY_ALIGNMENT) % H2D_BINARY_ALIGNMENT;
+    }
+
+    BinaryMapping::BinaryMapping(void* data, size_t size) : data(data), size(size)
+    {
+    }
+
+    BinaryMapping::~BinaryMapping()
+    {
+#ifndef WIN32
+      munmap(data, size);
+#endif
+    }
+
+    BinaryWriter::BinaryWriter(const char* filename, const char* magic, unsigned int version, bool compress) : filename(filename), compress(compress)
+    {
+      if(strlen(magic) != 8)
+        throw Exceptions::Exception("Binary file magic has to be 8 characters long.");
+#ifndef WITH_ZLIB
+      if(compress)
+        throw Exceptions::Exception("Compressed binary files need Hermes built with WITH_ZLIB.");
+#endif
+
+      this->file = fopen(filename, "wb");
+      if(this->file == NULL)
+        throw Exceptions::Exception("Could not open %s for writing.", filename);
+
+      char header[H2D_BINARY_HEADER_SIZE];
+      memset(header, 0, H2D_BINARY_HEADER_SIZE);
+      unsigned int flags = compress ? H2D_BINARY_FLAG_COMPRESSED : 0;
+      memcpy(header, magic, 8);
+      memcpy(header + 8, &H2D_BINARY_BYTE_ORDER_MARK, sizeof(unsigned int));
+      memcpy(header + 12, &version, sizeof(unsigned int));
+      memcpy(header + 16, &flags, sizeof(unsigned int));
+      this->write(header, H2D_BINARY_HEADER_SIZE);
+    }
+
+    BinaryWriter::~BinaryWriter()
+    {
+      if(this->file != NULL)
+        fclose(this->file);
+    }
+
+    void BinaryWriter::write(const void* data, size_t size)
+    {
+      if(size > 0 && fwrite(data, 1, size, this->file) != size)
+        throw Exceptions::Exception("Could not write to %s.", this->filename.c_str());
+    }
+
+    void BinaryWriter::write_padding(size_t size)
+    {
+      char zeros[H2D_BINARY_ALIGNMENT];
+      memset(zeros, 0, H2D_BINARY_ALIGNMENT);
+      this->write(zeros, binary_padding(size));
+    }
+
+    void BinaryWriter::write_section(const void* data, unsigned int item_size, unsigned long long count)
+    {
+      if(this->file == NULL)
+        throw Exceptions::Exception("Writing to a closed binary file %s.", this->filename.c_str());
+
+      unsigned long long size = item_size * count;
+      unsigned long long descriptor[4];
+      descriptor[0] = item_size + ((unsigned long long)H2D_BINARY_RAW << 32);
+      descriptor[1] = count;
+      descriptor[2] = size;
+      descriptor[3] = 0;
+
+#ifdef WITH_ZLIB
+      if(this->compress && size > 0)
+      {
+        // Shuffle the bytes, so that e.g. the exponents of doubles end up next to each other.
+        unsigned char* shuffled = (unsigned char*)malloc(size);
+        const unsigned char* bytes = (const unsigned char*)data;
+        for(unsigned long long item_i = 0; item_i < count; item_i++)
+          for(unsigned int byte_i = 0; byte_i < item_size; byte_i++)
+            shuffled[byte_i * count + item_i] = bytes[item_i * item_size + byte_i];
+
+        uLongf compressed_size = compressBound(size);
+        unsigned char* compressed = (unsigned char*)malloc(compressed_size);
+        int result = compress2(compressed, &compressed_size, shuffled, size, Z_BEST_SPEED);
+        ::free(shuffled);
+
+        if(result == Z_OK && compressed_size < size)
+        {
+          descriptor[0] = item_size + ((unsigned long long)H2D_BINARY_SHUFFLED_DEFLATE << 32);
+          descriptor[2] = compressed_size;
+          this->write(descriptor, sizeof(descriptor));
+          this->write(compressed, compressed_size);
+          this->write_padding(compressed_size);
+          ::free(compressed);
+          return;
+        }
+        ::free(compressed);
+      }
+#endif
+
+      this->write(descriptor, sizeof(descriptor));
+      this->write(data, size);
+      this->write_padding(size);
+    }
+
+    void BinaryWriter::write_ints(const int* data, unsigned long long count)
+    {
+      this->write_section(data, sizeof(int), count);
+    }
+
+    void BinaryWriter::close()
+    {
+      if(this->file == NULL)
+        return;
+      bool failed = (fflush(this->file) != 0);
+      failed = (fclose(this->file) != 0) || failed;
+      this->file = NULL;
+      if(failed)
+        throw Exceptions::Exception("Could not write to %s.", this->filename.c_str());
+    }
+
+    BinaryReader::BinaryReader(const char* filename, const char* magic, unsigned int max_version, bool memory_map) : file(NULL), filename(filename), mapping(NULL), position(0), have_descriptor(false)
+    {
+      // Without mmap(), the file is read as usual.
+#ifndef WIN32
+      if(memory_map)
+      {
+        int fd = open(filename, O_RDONLY);
+        if(fd < 0)
+          throw Exceptions::Exception("Could not open %s.", filename);
+        struct stat file_stat;
+        if(fstat(fd, &file_stat) != 0)
+        {
+          ::close(fd);
+          throw Exceptions::Exception("Could not open %s.", filename);
+        }
+        size_t size = file_stat.st_size;
+        void* data = size > 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if(data == MAP_FAILED)
+          throw Exceptions::Exception("Could not map %s into memory.", filename);
+        this->mapping = new BinaryMapping(data, size);
+      }
+#endif
+      if(this->mapping == NULL)
+      {
+        this->file = fopen(filename, "rb");
+        if(this->file == NULL)
+          throw Exceptions::Exception("Could not open %s.", filename);
+      }
+
+      char header[H2D_BINARY_HEADER_SIZE];
+      this->read(header, H2D_BINARY_HEADER_SIZE);
+
+      unsigned int byte_order_mark;
+      memcpy(&byte_order_mark, header + 8, sizeof(unsigned int));
+      memcpy(&this->version, header + 12, sizeof(unsigned int));
+      memcpy(&this->flags, header + 16, sizeof(unsigned int));
+
+      if(strlen(magic) != 8 || memcmp(header, magic, 8))
+        throw Exceptions::Exception("%s is not a binary file of the expected kind.", filename);
+      if(byte_order_mark != H2D_BINARY_BYTE_ORDER_MARK)
+        throw Exceptions::Exception("%s was written on a machine with a different byte order.", filename);
+      if(this->version > max_version)
+        throw Exceptions::Exception("%s has format version %u, only versions up to %u are supported.", filename, this->version, max_version);
+    }
+
+    BinaryReader::~BinaryReader()
+    {
+      if(this->file != NULL)
+        fclose(this->file);
+      delete this->mapping;
+    }
+
+    bool BinaryReader::is_binary_file(const char* filename, const char* magic)
+    {
+      FILE* file = fopen(filename, "rb");
+      if(file == NULL)
+        return false;
+      char header[8];
+      bool result = (fread(header, 1, 8, file) == 8) && !memcmp(header, magic, 8);
+      fclose(file);
+      return result;
+    }
+
+    unsigned int BinaryReader::get_version() const
+    {
+      return this->version;
+    }
+
+    bool BinaryReader::is_compressed() const
+    {
+      return (this->flags & H2D_BINARY_FLAG_COMPRESSED) != 0;
+    }
+
+    bool BinaryReader::is_mapped() const
+    {
+      return this->mapping != NULL;
+    }
+
+    void BinaryReader::read(void* data, size_t size)
+    {
+      if(this->mapping != NULL)
+      {
+        if(this->position + size > this->mapping->size)
+          throw Exceptions::Exception("Unexpected end of %s.", this->filename.c_str());
+        memcpy(data, (char*)this->mapping->data + this->position, size);
+        this->position += size;
+      }
+      else if(size > 0 && fread(data, 1, size, this->file) != size)
+        throw Exceptions::Exception("Unexpected end of %s.", this->filename.c_str());
+    }
+
+    void BinaryReader::skip(size_t size)
+    {
+      if(this->mapping != NULL)
+      {
+        if(this->position + size > this->mapping->size)
+          throw Exceptions::Exception("Unexpected end of %s.", this->filename.c_str());
+        this->position += size;
+      }
+      else if(size > 0 && fseek(this->file, size, SEEK_CUR) != 0)
+        throw Exceptions::Exception("Unexpected end of %s.", this->filename.c_str());
+    }
+
+    void BinaryReader::read_descriptor()
+    {
+      if(this->have_descriptor)
+        return;
+
+      unsigned long long descriptor[4];
+      this->read(descriptor, sizeof(descriptor));
+      this->descriptor.item_size = (unsigned int)(descriptor[0] & 0xFFFFFFFF);
+      this->descriptor.encoding = (unsigned int)(descriptor[0] >> 32);
+      this->descriptor.count = descriptor[1];
+      this->descriptor.stored_size = descriptor[2];
+      this->descriptor.reserved = descriptor[3];
+
+      if(this->descriptor.encoding == H2D_BINARY_RAW && this->descriptor.stored_size != this->descriptor.item_size * this->descriptor.count)
+        throw Exceptions::Exception("Corrupted section in %s.", this->filename.c_str());
+      if(this->descriptor.encoding > H2D_BINARY_SHUFFLED_DEFLATE)
+        throw Exceptions::Exception("Unknown section encoding in %s.", this->filename.c_str());
+
+      this->have_descriptor = true;
+    }
+
+    unsigned long long BinaryReader::next_section_count(unsigned int item_size)
+    {
+      this->read_descriptor();
+      if(this->descriptor.item_size != item_size)
+        throw Exceptions::Exception("Section in %s has items of %u bytes, %u expected.", this->filename.c_str(), this->descriptor.item_size, item_size);
+      return this->descriptor.count;
+    }
+
+    void BinaryReader::read_section(void* data)
+    {
+      this->read_descriptor();
+      this->have_descriptor = false;
+
+      unsigned long long size = this->descriptor.item_size * this->descriptor.count;
+      if(this->descriptor.encoding == H2D_BINARY_RAW)
+        this->read(data, size);
+      else
+      {
+#ifdef WITH_ZLIB
+        unsigned char* compressed = (unsigned char*)malloc(this->descriptor.stored_size);
+        unsigned char* shuffled = (unsigned char*)malloc(size);
+        try
+        {
+          this->read(compressed, this->descriptor.stored_size);
+        }
+        catch(Exceptions::Exception&)
+        {
+          ::free(compressed);
+          ::free(shuffled);
+          throw;
+        }
+        uLongf uncompressed_size = size;
+        int result = uncompress(shuffled, &uncompressed_size, compressed, this->descriptor.stored_size);
+        ::free(compressed);
+        if(result != Z_OK || uncompressed_size != size)
+        {
+          ::free(shuffled);
+          throw Exceptions::Exception("Corrupted compressed section in %s.", this->filename.c_str());
+        }
+
+        unsigned char* bytes = (unsigned char*)data;
+        for(unsigned long long item_i = 0; item_i < this->descriptor.count; item_i++)
+          for(unsigned int byte_i = 0; byte_i < this->descriptor.item_size; byte_i++)
+            bytes[item_i * this->descriptor.item_size + byte_i] = shuffled[byte_i * this->descriptor.count + item_i];
+        ::free(shuffled);
+#else
+        throw Exceptions::Exception("%s is compressed, this needs Hermes built with WITH_ZLIB.", this->filename.c_str());
+#endif
+      }
+      this->skip(binary_padding(this->descriptor.stored_size));
+    }
+
+    void BinaryReader::read_ints(int* data, unsigned long long count)
+    {
+      if(this->next_section_count(sizeof(int)) != count)
+        throw Exceptions::Exception("Section in %s has %llu items, %llu expected.", this->filename.c_str(), this->descriptor.count, count);
+      this->read_section(data);
+    }
+
+    void* BinaryReader::map_section()
+    {
+      this->read_descriptor();
+      if(this->mapping == NULL || this->descriptor.encoding != H2D_BINARY_RAW)
+        return NULL;
+
+      this->have_descriptor = false;
+      void* data = (char*)this->mapping->data + this->position;
+      this->skip(this->descriptor.stored_size + binary_padding(this->descriptor.stored_size));
+      return data;
+    }
+
+    BinaryMapping* BinaryReader::release_mapping()
+    {
+      BinaryMapping* mapping = this->mapping;
+      this->mapping = NULL;
+      return mapping;
+    }
+  }
+}
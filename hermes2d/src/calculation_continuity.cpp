@@ -15,6 +15,7 @@
 
 #include "calculation_continuity.h"
 #include "mesh_reader_h2d_xml.h"
+#include "mesh_reader_binary.h"
 #include "space_h1.h"
 #include "space_hdiv.h"
 #include "space_hcurl.h"
@@ -373,14 +374,13 @@ namespace Hermes
     template<typename Scalar>
     void CalculationContinuity<Scalar>::Record::save_meshes(Hermes::vector<Mesh*> meshes)
     {
-      MeshReaderH2DXML reader;
       for(unsigned int i = 0; i < meshes.size(); i++)
       {
         std::stringstream filename;
         filename << CalculationContinuity<Scalar>::mesh_file_name << i << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
         try
         {
-          reader.save(filename.str().c_str(), meshes[i]);
+          save_mesh_file(meshes[i], filename.str().c_str());
         }
         catch(std::exception& e)
         {
@@ -391,12 +391,11 @@ namespace Hermes
     template<typename Scalar>
     void CalculationContinuity<Scalar>::Record::save_mesh(Mesh* mesh)
     {
-      MeshReaderH2DXML reader;
       std::stringstream filename;
       filename << CalculationContinuity<Scalar>::mesh_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        reader.save(filename.str().c_str(), mesh);
+        save_mesh_file(mesh, filename.str().c_str());
       }
       catch(std::exception& e)
       {
@@ -413,7 +412,7 @@ namespace Hermes
         filename << CalculationContinuity<Scalar>::space_file_name << i << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
         try
         {
-          spaces[i]->save(filename.str().c_str());
+          save_space_file(spaces[i], filename.str().c_str());
         }
         catch(std::exception& e)
         {
@@ -429,7 +428,7 @@ namespace Hermes
       filename << CalculationContinuity<Scalar>::space_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        space->save(filename.str().c_str());
+        save_space_file(space, filename.str().c_str());
       }
       catch(std::exception& e)
       {
@@ -447,7 +446,7 @@ namespace Hermes
 
         try
         {
-          solutions[i]->save(filename.str().c_str());
+          save_solution_file(solutions[i], filename.str().c_str());
         }
         catch(Hermes::Exceptions::SolutionSaveFailureException& e)
         {
@@ -462,7 +461,7 @@ namespace Hermes
       filename << CalculationContinuity<Scalar>::solution_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        solution->save(filename.str().c_str());
+        save_solution_file(solution, filename.str().c_str());
       }
       catch(Hermes::Exceptions::SolutionSaveFailureException& e)
       {
@@ -649,7 +648,7 @@ namespace Hermes
         filename << CalculationContinuity<Scalar>::solution_file_name << i << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
         try
         {
-          solutions[i]->load(filename.str().c_str(), spaces[i]);
+          load_solution_file(solutions[i], spaces[i], filename.str().c_str());
           solutions[i]->space_type = spaces[i]->get_type();
         }
         catch(Hermes::Exceptions::SolutionLoadFailureException& e)
@@ -669,7 +668,7 @@ namespace Hermes
       filename << CalculationContinuity<Scalar>::solution_file_name << 0 << '_' << (std::string)"t = " << this->time << (std::string)"n = " << this->number << (std::string)".h2d";
       try
       {
-        solution->load(filename.str().c_str(), space);
+        load_solution_file(solution, space, filename.str().c_str());
         solution->space_type = space->get_type();
       }
       catch(Hermes::Exceptions::SolutionLoadFailureException& e)
@@ -788,6 +787,84 @@ namespace Hermes
       error_file_name = error_file_nameToSet;
     }
 
+    template<typename Scalar>
+    typename CalculationContinuity<Scalar>::StorageFormat CalculationContinuity<Scalar>::storage_format = CalculationContinuity<Scalar>::storageXML;
+
+    template<typename Scalar>
+    bool CalculationContinuity<Scalar>::memory_mapped_loading = false;
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::set_storage_format(StorageFormat storage_formatToSet)
+    {
+      storage_format = storage_formatToSet;
+    }
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::set_memory_mapped_loading(bool memory_mapped_loadingToSet)
+    {
+      memory_mapped_loading = memory_mapped_loadingToSet;
+    }
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::save_mesh_file(Mesh* mesh, const char* filename)
+    {
+      // MeshReaderH2DXML::load() recognizes the binary files, so loading does not depend on the format.
+      if(storage_format == storageXML)
+      {
+        MeshReaderH2DXML reader;
+        reader.save(filename, mesh);
+      }
+      else
+      {
+        MeshReaderBinary reader;
+        reader.save(filename, mesh, storage_format == storageBinaryCompressed);
+      }
+    }
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::save_space_file(Space<Scalar>* space, const char* filename)
+    {
+      switch(storage_format)
+      {
+      case storageXML:
+        space->save(filename);
+        break;
+      case storageBinary:
+        space->save_binary(filename, false);
+        break;
+      case storageBinaryCompressed:
+        space->save_binary(filename, true);
+        break;
+      }
+    }
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::save_solution_file(Solution<Scalar>* solution, const char* filename)
+    {
+      switch(storage_format)
+      {
+      case storageXML:
+        solution->save(filename);
+        break;
+      case storageBinary:
+        solution->save_binary(filename, false);
+        break;
+      case storageBinaryCompressed:
+        solution->save_binary(filename, true);
+        break;
+      }
+    }
+
+    template<typename Scalar>
+    void CalculationContinuity<Scalar>::load_solution_file(Solution<Scalar>* solution, Space<Scalar>* space, const char* filename)
+    {
+      // Solution::load() recognizes binary files too, but does not map them.
+      if(memory_mapped_loading && Solution<Scalar>::is_binary_file(filename))
+        solution->load_binary(filename, space, true);
+      else
+        solution->load(filename, space);
+    }
+
     template class HERMES_API CalculationContinuity<double>;
     template class HERMES_API CalculationContinuity<std::complex<double> >;
   }
@@ -105,7 +105,21 @@ namespace Hermes
 
       cache_element_stored = NULL;
 
+      neighbor_pss = NULL;
+      neighbor_spss = NULL;
+      neighbor_refmaps = NULL;
+      local_matrix_buffers = NULL;
+
       this->do_not_use_cache = false;
+      this->thread_local_assembling = false;
+      this->thread_local_buffers_used = false;
+      this->cache_memory_budget = 0;
+      this->cache_assembling_stamp = 0;
+      this->cache_hits = this->cache_misses = 0;
+
+      this->states = NULL;
+      this->colored_states = NULL;
+      this->colored_states_count = 0;
 
       this->spaces_size = 0;
 
@@ -182,7 +196,7 @@ namespace Hermes
       current_rhs = NULL;
       current_block_weights = NULL;
 
-      cache_records_sub_idx = new std::map<uint64_t, CacheRecordPerSubIdx*>**[spaces.size()];
+      cache_records_sub_idx = new CacheRecordPerSubIdx**[spaces.size()];
       cache_records_element = new CacheRecordPerElement**[spaces.size()];
 
       this->cache_size = spaces[0]->get_mesh()->get_max_element_id() + 1;
@@ -195,15 +209,29 @@ namespace Hermes
 
       for(unsigned int i = 0; i < spaces.size(); i++)
       {
-        cache_records_sub_idx[i] = (std::map<uint64_t, CacheRecordPerSubIdx*>**)malloc(this->cache_size * sizeof(std::map<uint64_t, CacheRecordPerSubIdx*>*));
-        memset(cache_records_sub_idx[i], NULL, this->cache_size * sizeof(std::map<uint64_t, CacheRecordPerSubIdx*>*));
+        cache_records_sub_idx[i] = (CacheRecordPerSubIdx**)malloc(this->cache_size * sizeof(CacheRecordPerSubIdx*));
+        memset(cache_records_sub_idx[i], NULL, this->cache_size * sizeof(CacheRecordPerSubIdx*));
 
         cache_records_element[i] = (CacheRecordPerElement**)malloc(this->cache_size * sizeof(CacheRecordPerElement*));
         memset(cache_records_element[i], NULL, this->cache_size * sizeof(CacheRecordPerElement*));
       }
       cache_element_stored = NULL;
 
+      neighbor_pss = NULL;
+      neighbor_spss = NULL;
+      neighbor_refmaps = NULL;
+      local_matrix_buffers = NULL;
+
       this->do_not_use_cache = false;
+      this->thread_local_assembling = false;
+      this->thread_local_buffers_used = false;
+      this->cache_memory_budget = 0;
+      this->cache_assembling_stamp = 0;
+      this->cache_hits = this->cache_misses = 0;
+
+      this->states = NULL;
+      this->colored_states = NULL;
+      this->colored_states_count = 0;
     }
 
     template<typename Scalar>
@@ -232,6 +260,7 @@ namespace Hermes
       if(sp_seq != NULL) delete [] sp_seq;
 
       this->delete_cache();
+      this->free_state_coloring();
     }
 
     template<typename Scalar>
@@ -306,26 +335,7 @@ namespace Hermes
       for(unsigned int i = 0; i < spaces.size(); i++)
       {
         for(unsigned int j = 0; j < cache_size; j++)
-        {
-          if(this->cache_records_sub_idx[i][j] != NULL)
-          {
-            for(typename std::map<uint64_t, CacheRecordPerSubIdx*>::iterator it = this->cache_records_sub_idx[i][j]->begin(); it != this->cache_records_sub_idx[i][j]->end(); it++)
-            {
-              it->second->clear();
-              delete it->second;
-            }
-
-            this->cache_records_sub_idx[i][j]->clear();
-            delete this->cache_records_sub_idx[i][j];
-            this->cache_records_sub_idx[i][j] = NULL;
-          }
-          if(this->cache_records_element[i][j] != NULL)
-          {
-            this->cache_records_element[i][j]->clear();
-            delete this->cache_records_element[i][j];
-            this->cache_records_element[i][j] = NULL;
-          }
-        }
+          this->delete_cache_records(i, j);
         free(cache_records_sub_idx[i]);
         free(cache_records_element[i]);
       }
@@ -372,7 +382,7 @@ namespace Hermes
         // Matrix<Scalar> related settings.
         have_matrix = false;
 
-        cache_records_sub_idx = new std::map<uint64_t, CacheRecordPerSubIdx*>**[spaces.size()];
+        cache_records_sub_idx = new CacheRecordPerSubIdx**[spaces.size()];
         cache_records_element = new CacheRecordPerElement**[spaces.size()];
 
         this->cache_size = spaces[0]->get_mesh()->get_max_element_id() + 1;
@@ -385,8 +395,8 @@ namespace Hermes
 
         for(unsigned int i = 0; i < spaces.size(); i++)
         {
-          cache_records_sub_idx[i] = (std::map<uint64_t, CacheRecordPerSubIdx*>**)malloc(this->cache_size * sizeof(std::map<uint64_t, CacheRecordPerSubIdx*>*));
-          memset(cache_records_sub_idx[i], NULL, this->cache_size * sizeof(std::map<uint64_t, CacheRecordPerSubIdx*>*));
+          cache_records_sub_idx[i] = (CacheRecordPerSubIdx**)malloc(this->cache_size * sizeof(CacheRecordPerSubIdx*));
+          memset(cache_records_sub_idx[i], NULL, this->cache_size * sizeof(CacheRecordPerSubIdx*));
 
           cache_records_element[i] = (CacheRecordPerElement**)malloc(this->cache_size * sizeof(CacheRecordPerElement*));
           memset(cache_records_element[i], NULL, this->cache_size * sizeof(CacheRecordPerElement*));
@@ -408,8 +418,8 @@ namespace Hermes
         {
           for(unsigned int i = 0; i < this->spaces_size; i++)
           {
-            this->cache_records_sub_idx[i] = (std::map<uint64_t, CacheRecordPerSubIdx*>**)realloc(this->cache_records_sub_idx[i], max_size * sizeof(std::map<uint64_t, CacheRecordPerSubIdx*>*));
-            memset(this->cache_records_sub_idx[i] + this->cache_size, NULL, (max_size - this->cache_size) * sizeof(std::map<uint64_t, CacheRecordPerSubIdx*>*));
+            this->cache_records_sub_idx[i] = (CacheRecordPerSubIdx**)realloc(this->cache_records_sub_idx[i], max_size * sizeof(CacheRecordPerSubIdx*));
+            memset(this->cache_records_sub_idx[i] + this->cache_size, NULL, (max_size - this->cache_size) * sizeof(CacheRecordPerSubIdx*));
 
             this->cache_records_element[i] = (CacheRecordPerElement**)realloc(this->cache_records_element[i], max_size * sizeof(CacheRecordPerElement*));
             memset(this->cache_records_element[i] + this->cache_size, NULL, (max_size - this->cache_size) * sizeof(CacheRecordPerElement*));
@@ -425,42 +435,10 @@ namespace Hermes
             if(j < spaces[i]->get_mesh()->get_max_element_id())
             {
               if(spaces[i]->get_mesh()->get_element(j) == NULL || !spaces[i]->get_mesh()->get_element(j)->active || spaces[i]->get_element_order(spaces[i]->get_mesh()->get_element(j)->id) < 0)
-              {
-                if(this->cache_records_sub_idx[i][j] != NULL)
-                {
-                  for(typename std::map<uint64_t, CacheRecordPerSubIdx*>::iterator it = this->cache_records_sub_idx[i][j]->begin(); it != this->cache_records_sub_idx[i][j]->end(); it++)
-                    it->second->clear();
-
-                  this->cache_records_sub_idx[i][j]->clear();
-                  delete this->cache_records_sub_idx[i][j];
-                  this->cache_records_sub_idx[i][j] = NULL;
-                }
-                if(this->cache_records_element[i][j] != NULL)
-                {
-                  this->cache_records_element[i][j]->clear();
-                  delete this->cache_records_element[i][j];
-                  this->cache_records_element[i][j] = NULL;
-                }
-              }
+                this->delete_cache_records(i, j);
             }
             else
-            {
-              if(this->cache_records_sub_idx[i][j] != NULL)
-              {
-                for(typename std::map<uint64_t, CacheRecordPerSubIdx*>::iterator it = this->cache_records_sub_idx[i][j]->begin(); it != this->cache_records_sub_idx[i][j]->end(); it++)
-                  it->second->clear();
-
-                this->cache_records_sub_idx[i][j]->clear();
-                delete this->cache_records_sub_idx[i][j];
-                this->cache_records_sub_idx[i][j] = NULL;
-              }
-              if(this->cache_records_element[i][j] != NULL)
-              {
-                this->cache_records_element[i][j]->clear();
-                delete this->cache_records_element[i][j];
-                this->cache_records_element[i][j] = NULL;
-              }
-            }
+              this->delete_cache_records(i, j);
           }
         }
       }
@@ -671,6 +649,163 @@ namespace Hermes
       return true;
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::begin_thread_local_assembling(int num_threads)
+    {
+      // Also with one thread, so that the summation order is always the same.
+      this->thread_local_buffers_used = false;
+      if(!this->thread_local_assembling)
+        return;
+
+      // The merge itself happens in finish() called on the matrix / vector after assembling.
+      if(current_mat != NULL)
+        this->thread_local_buffers_used = current_mat->begin_thread_local_assembling(H2D_THREAD_LOCAL_BUFFERS, num_threads) || this->thread_local_buffers_used;
+      if(current_rhs != NULL)
+        this->thread_local_buffers_used = current_rhs->begin_thread_local_assembling(H2D_THREAD_LOCAL_BUFFERS, num_threads) || this->thread_local_buffers_used;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_thread_local_buffer(int buffer)
+    {
+      if(!this->thread_local_buffers_used)
+        return;
+
+      if(current_mat != NULL)
+        current_mat->set_thread_local_buffer(buffer);
+      if(current_rhs != NULL)
+        current_rhs->set_thread_local_buffer(buffer);
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_conflict_free_assembling(bool to_set)
+    {
+      // DG forms add also to the DOFs of the neighbors, the coloring does not cover that.
+      if(DG_matrix_forms_present || DG_vector_forms_present)
+        return;
+
+      if(current_mat != NULL)
+        current_mat->set_conflict_free_assembling(to_set);
+      if(current_rhs != NULL)
+        current_rhs->set_conflict_free_assembling(to_set);
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::init_state_coloring(Hermes::vector<const Mesh*>& meshes)
+    {
+      bool use_coloring = !(DG_matrix_forms_present || DG_vector_forms_present);
+
+      // The states hold element pointers, which do not survive e.g. Mesh::copy() that keeps the seq number,
+      // hence also the elements seq numbers of the meshes.
+      Hermes::vector<int> seqs;
+      for(unsigned int mesh_i = 0; mesh_i < meshes.size(); mesh_i++)
+      {
+        seqs.push_back(meshes[mesh_i]->get_seq());
+        seqs.push_back(meshes[mesh_i]->get_elements_seq());
+      }
+      for(unsigned int space_i = 0; space_i < this->spaces_size; space_i++)
+        seqs.push_back(spaces[space_i]->get_seq());
+      seqs.push_back(use_coloring ? 1 : 0);
+
+      // Up to date.
+      if(this->colored_states != NULL && this->coloring_meshes == meshes && this->coloring_seqs == seqs)
+        return;
+
+      this->free_state_coloring();
+
+      int num_states;
+      Traverse trav_master(true);
+      this->states = trav_master.get_states(meshes, num_states);
+
+      int* state_colors = new int[num_states];
+      memset(state_colors, 0, num_states * sizeof(int));
+      int num_colors = 1;
+
+      // Greedy coloring, a state gets the lowest color not used by any already colored state sharing a DOF with it.
+      if(use_coloring)
+      {
+        num_colors = 0;
+        Hermes::vector<int>* dof_colors = new Hermes::vector<int>[Space<Scalar>::get_num_dofs(spaces)];
+        // forbidden_colors[color] == state_i <=> color is used by a state sharing a DOF with the state state_i.
+        Hermes::vector<int> forbidden_colors;
+        Hermes::vector<int> state_dofs;
+        AsmList<Scalar> al;
+
+        for(int state_i = 0; state_i < num_states; state_i++)
+        {
+          state_dofs.clear();
+          for(unsigned int space_i = 0; space_i < this->spaces_size; space_i++)
+          {
+            if(this->states[state_i].e[space_i] == NULL)
+              continue;
+            spaces[space_i]->get_element_assembly_list(this->states[state_i].e[space_i], &al, spaces_first_dofs[space_i]);
+            for(unsigned int al_i = 0; al_i < al.cnt; al_i++)
+              if(al.dof[al_i] >= 0)
+                state_dofs.push_back(al.dof[al_i]);
+          }
+
+          for(unsigned int dof_i = 0; dof_i < state_dofs.size(); dof_i++)
+            for(unsigned int color_i = 0; color_i < dof_colors[state_dofs[dof_i]].size(); color_i++)
+              forbidden_colors[dof_colors[state_dofs[dof_i]][color_i]] = state_i;
+
+          int color = 0;
+          while(color < num_colors && forbidden_colors[color] == state_i)
+            color++;
+          if(color == num_colors)
+          {
+            forbidden_colors.push_back(-1);
+            num_colors++;
+          }
+
+          state_colors[state_i] = color;
+          for(unsigned int dof_i = 0; dof_i < state_dofs.size(); dof_i++)
+            dof_colors[state_dofs[dof_i]].push_back(color);
+        }
+
+        delete [] dof_colors;
+        if(num_colors == 0)
+          num_colors = 1;
+      }
+
+      // Sort the states by colors, keeping the traversal order within one color.
+      this->color_offsets.clear();
+      this->color_offsets.resize(num_colors + 1, 0);
+      for(int state_i = 0; state_i < num_states; state_i++)
+        this->color_offsets[state_colors[state_i] + 1]++;
+      for(int color_i = 0; color_i < num_colors; color_i++)
+        this->color_offsets[color_i + 1] += this->color_offsets[color_i];
+
+      int* positions = new int[num_colors];
+      for(int color_i = 0; color_i < num_colors; color_i++)
+        positions[color_i] = this->color_offsets[color_i];
+
+      this->colored_states = new Traverse::State*[num_states > 0 ? num_states : 1];
+      for(int state_i = 0; state_i < num_states; state_i++)
+        this->colored_states[positions[state_colors[state_i]]++] = this->states + state_i;
+      this->colored_states_count = num_states;
+
+      delete [] positions;
+      delete [] state_colors;
+
+      this->coloring_meshes = meshes;
+      this->coloring_seqs = seqs;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::free_state_coloring()
+    {
+      if(this->colored_states == NULL)
+        return;
+
+      delete [] this->states;
+      this->states = NULL;
+      delete [] this->colored_states;
+      this->colored_states = NULL;
+      this->colored_states_count = 0;
+      this->color_offsets.clear();
+      this->coloring_meshes.clear();
+      this->coloring_seqs.clear();
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::create_sparse_structure(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs)
     {
@@ -724,21 +859,28 @@ namespace Hermes
         // Spaces have changed: create the matrix from scratch.
         have_matrix = true;
         current_mat->free();
-        current_mat->prealloc(this->ndof);
 
-        AsmList<Scalar>* al = new AsmList<Scalar>[wf->get_neq()];
-        const Mesh** meshes = new const Mesh*[wf->get_neq()];
-        bool **blocks = wf->get_blocks(current_force_diagonal_blocks);
+        if(!is_DG)
+        {
+          SparsityPattern pattern;
+          this->create_sparsity_pattern(&pattern);
+          current_mat->alloc_from_pattern(&pattern);
+        }
+        else
+        {
+          current_mat->prealloc(this->ndof);
 
-        // Init multi-mesh traversal.
-        for (unsigned int i = 0; i < wf->get_neq(); i++)
-          meshes[i] = spaces[i]->get_mesh();
+          AsmList<Scalar>* al = new AsmList<Scalar>[wf->get_neq()];
+          const Mesh** meshes = new const Mesh*[wf->get_neq()];
+          bool **blocks = wf->get_blocks(current_force_diagonal_blocks);
 
-        Traverse trav(true);
-        trav.begin(wf->get_neq(), meshes);
+          // Init multi-mesh traversal.
+          for (unsigned int i = 0; i < wf->get_neq(); i++)
+            meshes[i] = spaces[i]->get_mesh();
+
+          Traverse trav(true);
+          trav.begin(wf->get_neq(), meshes);
 
-        if(is_DG)
-        {
           Hermes::vector<Space<Scalar>*> mutable_spaces;
           for(unsigned int i = 0; i < this->spaces_size; i++)
           {
@@ -746,23 +888,17 @@ namespace Hermes
             spaces_first_dofs[i] = 0;
           }
           Space<Scalar>::assign_dofs(mutable_spaces);
-        }
 
-        Traverse::State* current_state;
-        // Loop through all elements.
-        while ((current_state = trav.get_next_state()) != NULL)
-        {
-          // Obtain assembly lists for the element at all spaces.
-          /// \todo do not get the assembly list again if the element was not changed.
-          for (unsigned int i = 0; i < wf->get_neq(); i++)
-            if(current_state->e[i] != NULL)
-              if(is_DG)
+          Traverse::State* current_state;
+          // Loop through all elements.
+          while ((current_state = trav.get_next_state()) != NULL)
+          {
+            // Obtain assembly lists for the element at all spaces.
+            /// \todo do not get the assembly list again if the element was not changed.
+            for (unsigned int i = 0; i < wf->get_neq(); i++)
+              if(current_state->e[i] != NULL)
                 spaces[i]->get_element_assembly_list(current_state->e[i], &(al[i]));
-              else
-                spaces[i]->get_element_assembly_list(current_state->e[i], &(al[i]), spaces_first_dofs[i]);
 
-          if(is_DG)
-          {
             // Number of edges ( =  number of vertices).
             int num_edges = current_state->e[0]->nvert;
 
@@ -817,52 +953,52 @@ namespace Hermes
                               if(blocks[m][el]) current_mat->pre_add_ij(am->dof[i], an->dof[j]);
                               if(blocks[el][m]) current_mat->pre_add_ij(an->dof[j], am->dof[i]);
                             }
-                            delete an;
+                      delete an;
                     }
 
-                    // Deallocation an array of arrays of neighboring elements
-                    // for every mesh x edge.
-                    for(unsigned int el = 0; el < wf->get_neq(); el++)
-                    {
-                      for(int ed = 0; ed < num_edges; ed++)
-                        delete [] neighbor_elems_arrays[el][ed];
-                      delete [] neighbor_elems_arrays[el];
-                    }
-                    delete [] neighbor_elems_arrays;
+            // Deallocation an array of arrays of neighboring elements
+            // for every mesh x edge.
+            for(unsigned int el = 0; el < wf->get_neq(); el++)
+            {
+              for(int ed = 0; ed < num_edges; ed++)
+                delete [] neighbor_elems_arrays[el][ed];
+              delete [] neighbor_elems_arrays[el];
+            }
+            delete [] neighbor_elems_arrays;
 
-                    // The same, only for number of elements.
-                    for(unsigned int el = 0; el < wf->get_neq(); el++)
-                      delete [] neighbor_elems_counts[el];
-                    delete [] neighbor_elems_counts;
-          }
+            // The same, only for number of elements.
+            for(unsigned int el = 0; el < wf->get_neq(); el++)
+              delete [] neighbor_elems_counts[el];
+            delete [] neighbor_elems_counts;
 
-          // Go through all equation-blocks of the local stiffness matrix.
-          for (unsigned int m = 0; m < wf->get_neq(); m++)
-          {
-            for (unsigned int n = 0; n < wf->get_neq(); n++)
+            // Go through all equation-blocks of the local stiffness matrix.
+            for (unsigned int m = 0; m < wf->get_neq(); m++)
             {
-              if(blocks[m][n] && current_state->e[m] != NULL && current_state->e[n] != NULL)
+              for (unsigned int n = 0; n < wf->get_neq(); n++)
               {
-                AsmList<Scalar>*am = &(al[m]);
-                AsmList<Scalar>*an = &(al[n]);
-
-                // Pretend assembling of the element stiffness matrix.
-                for (unsigned int i = 0; i < am->cnt; i++)
-                  if(am->dof[i] >= 0)
-                    for (unsigned int j = 0; j < an->cnt; j++)
-                      if(an->dof[j] >= 0)
-                        current_mat->pre_add_ij(am->dof[i], an->dof[j]);
+                if(blocks[m][n] && current_state->e[m] != NULL && current_state->e[n] != NULL)
+                {
+                  AsmList<Scalar>*am = &(al[m]);
+                  AsmList<Scalar>*an = &(al[n]);
+
+                  // Pretend assembling of the element stiffness matrix.
+                  for (unsigned int i = 0; i < am->cnt; i++)
+                    if(am->dof[i] >= 0)
+                      for (unsigned int j = 0; j < an->cnt; j++)
+                        if(an->dof[j] >= 0)
+                          current_mat->pre_add_ij(am->dof[i], an->dof[j]);
+                }
               }
             }
           }
-        }
 
-        trav.finish();
-        delete [] al;
-        delete [] meshes;
-        delete [] blocks;
+          trav.finish();
+          delete [] al;
+          delete [] meshes;
+          delete [] blocks;
 
-        current_mat->alloc();
+          current_mat->alloc();
+        }
       }
 
       // WARNING: unlike Matrix<Scalar>::alloc(), Vector<Scalar>::alloc(ndof) frees the memory occupied
@@ -875,6 +1011,53 @@ namespace Hermes
         sp_seq[i] = spaces[i]->get_seq();
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::create_sparsity_pattern(SparsityPattern* pattern)
+    {
+      bool **blocks = wf->get_blocks(current_force_diagonal_blocks);
+
+      Hermes::vector<const Mesh*> meshes;
+      for (unsigned int i = 0; i < wf->get_neq(); i++)
+        meshes.push_back(spaces[i]->get_mesh());
+
+      int num_states;
+      Traverse trav_master(true);
+      Traverse::State* states = trav_master.get_states(meshes, num_states);
+
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+      pattern->begin(this->ndof, num_threads_used);
+
+      int state_i;
+#pragma omp parallel shared(states, blocks, pattern) private(state_i) num_threads(num_threads_used)
+      {
+        AsmList<Scalar>* al = new AsmList<Scalar>[wf->get_neq()];
+
+#pragma omp for schedule(static)
+        for(state_i = 0; state_i < num_states; state_i++)
+        {
+          Traverse::State* current_state = states + state_i;
+
+          // Obtain assembly lists for the element at all spaces.
+          for (unsigned int i = 0; i < wf->get_neq(); i++)
+            if(current_state->e[i] != NULL)
+              spaces[i]->get_element_assembly_list(current_state->e[i], &(al[i]), spaces_first_dofs[i]);
+
+          // Go through all equation-blocks of the local stiffness matrix.
+          for (unsigned int m = 0; m < wf->get_neq(); m++)
+            for (unsigned int n = 0; n < wf->get_neq(); n++)
+              if(blocks[m][n] && current_state->e[m] != NULL && current_state->e[n] != NULL)
+                pattern->add_block(omp_get_thread_num(), al[m].cnt, al[m].dof, al[n].cnt, al[n].dof);
+        }
+
+        delete [] al;
+      }
+
+      delete [] states;
+      delete [] blocks;
+
+      pattern->finish();
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::assemble(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs,
       bool force_diagonal_blocks, Table* block_weights)
@@ -969,6 +1152,32 @@ namespace Hermes
           weakforms[i]->cloneMembers(this->wf);
         }
 
+        // Neighbor precalc shapesets and refmaps, only needed when there are matrix DG forms present.
+        if(DG_matrix_forms_present)
+        {
+          assert(neighbor_pss == NULL);
+          neighbor_pss = new PrecalcShapeset**[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
+          neighbor_spss = new PrecalcShapeset**[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
+          neighbor_refmaps = new RefMap**[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
+          for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
+          {
+            neighbor_pss[i] = new PrecalcShapeset*[wf->get_neq()];
+            neighbor_spss[i] = new PrecalcShapeset*[wf->get_neq()];
+            neighbor_refmaps[i] = new RefMap*[wf->get_neq()];
+            for (unsigned int j = 0; j < wf->get_neq(); j++)
+            {
+              neighbor_pss[i][j] = new PrecalcShapeset(spaces[j]->shapeset);
+              neighbor_spss[i][j] = new PrecalcShapeset(neighbor_pss[i][j]);
+              neighbor_refmaps[i][j] = new RefMap();
+              neighbor_refmaps[i][j]->set_quad_2d(&g_quad_2d_std);
+            }
+          }
+        }
+
+        // Local matrices of the matrix forms.
+        assert(local_matrix_buffers == NULL);
+        local_matrix_buffers = new LocalMatrixBuffer[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
+
         assert(cache_element_stored == NULL);
         cache_element_stored = new bool*[this->spaces_size];
         for(unsigned int i = 0; i < this->spaces_size; i++)
@@ -1038,6 +1247,31 @@ namespace Hermes
         delete [] cache_element_stored[i];
       delete [] cache_element_stored;
       cache_element_stored = NULL;
+
+      delete [] local_matrix_buffers;
+      local_matrix_buffers = NULL;
+
+      if(neighbor_pss != NULL)
+      {
+        for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
+        {
+          for (unsigned int j = 0; j < wf->get_neq(); j++)
+          {
+            delete neighbor_spss[i][j];
+            delete neighbor_pss[i][j];
+            delete neighbor_refmaps[i][j];
+          }
+          delete [] neighbor_spss[i];
+          delete [] neighbor_pss[i];
+          delete [] neighbor_refmaps[i];
+        }
+        delete [] neighbor_spss;
+        delete [] neighbor_pss;
+        delete [] neighbor_refmaps;
+        neighbor_pss = NULL;
+        neighbor_spss = NULL;
+        neighbor_refmaps = NULL;
+      }
     }
 
     template<typename Scalar>
@@ -1095,12 +1329,10 @@ namespace Hermes
       for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
         meshes.push_back(spaces[space_i]->get_mesh());
 
-      Traverse trav_master(true);
-      unsigned int num_states = trav_master.get_num_states(meshes);
+      // Union mesh states, sorted by colors.
+      this->init_state_coloring(meshes);
+      this->cache_assembling_stamp++;
 
-      trav_master.begin(meshes.size(), &(meshes.front()));
-
-      Traverse* trav = new Traverse[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
       Hermes::vector<Transformable *>* fns = new Hermes::vector<Transformable *>[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
       for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
       {
@@ -1125,11 +1357,9 @@ namespace Hermes
           fns[i].push_back(u_ext[i][j]);
           u_ext[i][j]->set_quad_2d(&g_quad_2d_std);
         }
-        trav[i].begin(meshes.size(), &(meshes.front()), &(fns[i].front()));
-        trav[i].stack = trav_master.stack;
       }
 
-      int state_i;
+      int state_i, chunk_i, task_i;
 
       PrecalcShapeset** current_pss;
       PrecalcShapeset** current_spss;
@@ -1140,77 +1370,82 @@ namespace Hermes
 
 #define CHUNKSIZE 1
       int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
-#pragma omp parallel shared(trav_master, mat, rhs ) private(state_i, current_pss, current_spss, current_refmaps, current_u_ext, current_als, current_weakform) num_threads(num_threads_used)
-      {
-#pragma omp for schedule(static, CHUNKSIZE)
-        for(state_i = 0; state_i < num_states; state_i++)
-        {
-          if(this->caughtException != NULL)
-            continue;
-          try
+      this->begin_thread_local_assembling(num_threads_used);
+      this->set_conflict_free_assembling(true);
+#pragma omp parallel shared(fns, mat, rhs) private(state_i, chunk_i, task_i, current_pss, current_spss, current_refmaps, current_u_ext, current_als, current_weakform) num_threads(num_threads_used)
+      {
+        for(unsigned int color_i = 0; color_i < this->color_offsets.size() - 1; color_i++)
+        {
+          // No two states of one color share a DOF, the implicit barrier at the end of the omp for separates the colors.
+          // The states of the color are split into chunks of H2D_ASSEMBLING_CHUNK_SIZE states, the chunk chunk_i is assembled
+          // in order into the buffer chunk_i % H2D_THREAD_LOCAL_BUFFERS. Every value gets at most one contribution per color,
+          // so the result does not depend on the number of threads or on the scheduling. Without the coloring (DG forms),
+          // the chunks sharing a buffer are assembled one after another by one thread.
+          int color_begin = this->color_offsets[color_i];
+          int color_count = this->color_offsets[color_i + 1] - color_begin;
+          int chunk_count = (color_count + H2D_ASSEMBLING_CHUNK_SIZE - 1) / H2D_ASSEMBLING_CHUNK_SIZE;
+          bool chunks_conflict = this->thread_local_buffers_used && (DG_matrix_forms_present || DG_vector_forms_present);
+          int task_count = chunks_conflict ? std::min(chunk_count, H2D_THREAD_LOCAL_BUFFERS) : chunk_count;
+          int chunk_step = chunks_conflict ? H2D_THREAD_LOCAL_BUFFERS : chunk_count;
+#pragma omp for schedule(dynamic, CHUNKSIZE)
+          for(task_i = 0; task_i < task_count; task_i++)
           {
-            Traverse::State current_state;
-#pragma omp critical (get_next_state)
+            for(chunk_i = task_i; chunk_i < chunk_count; chunk_i += chunk_step)
             {
-              try
-              {
-                current_state = trav[omp_get_thread_num()].get_next_state(&trav_master.top, &trav_master.id);
-              }
-              catch(Hermes::Exceptions::Exception& e)
+              this->set_thread_local_buffer(chunk_i % H2D_THREAD_LOCAL_BUFFERS);
+              int chunk_end = std::min(color_begin + (chunk_i + 1) * H2D_ASSEMBLING_CHUNK_SIZE, color_begin + color_count);
+              for(state_i = color_begin + chunk_i * H2D_ASSEMBLING_CHUNK_SIZE; state_i < chunk_end; state_i++)
               {
-                if(this->caughtException == NULL)
-                  this->caughtException = e.clone();
-              }
-              catch(std::exception& e)
-              {
-                if(this->caughtException == NULL)
-                  this->caughtException = new Hermes::Exceptions::Exception(e.what());
+                if(this->caughtException != NULL)
+                  continue;
+                try
+                {
+                  Traverse::State* current_state = this->colored_states[state_i];
+                  Traverse::set_state_transforms(current_state, &(fns[omp_get_thread_num()].front()));
+
+                  current_pss = pss[omp_get_thread_num()];
+                  current_spss = spss[omp_get_thread_num()];
+                  current_refmaps = refmaps[omp_get_thread_num()];
+                  current_u_ext = u_ext[omp_get_thread_num()];
+                  current_als = als[omp_get_thread_num()];
+                  current_weakform = weakforms[omp_get_thread_num()];
+
+                  // One state is a collection of (virtual) elements sharing
+                  // the same physical location on (possibly) different meshes.
+                  // This is then the same element of the virtual union mesh.
+                  // The proper sub-element mappings to all the functions of
+                  // this stage are set by Traverse::set_state_transforms() above.
+                  assemble_one_state(current_pss, current_spss, current_refmaps, current_u_ext, current_als, current_state, current_weakform);
+
+                  if(DG_matrix_forms_present || DG_vector_forms_present)
+                    assemble_one_DG_state(current_pss, current_spss, current_refmaps, current_als, current_state, current_weakform->mfDG, current_weakform->vfDG, &(fns[omp_get_thread_num()].front()), current_weakform);
+                }
+                catch(Hermes::Exceptions::Exception& e)
+                {
+                  if(this->caughtException == NULL)
+                    this->caughtException = e.clone();
+                }
+                catch(std::exception& e)
+                {
+                  if(this->caughtException == NULL)
+                    this->caughtException = new Hermes::Exceptions::Exception(e.what());
+                }
               }
             }
-
-            current_pss = pss[omp_get_thread_num()];
-            current_spss = spss[omp_get_thread_num()];
-            current_refmaps = refmaps[omp_get_thread_num()];
-            current_u_ext = u_ext[omp_get_thread_num()];
-            current_als = als[omp_get_thread_num()];
-            current_weakform = weakforms[omp_get_thread_num()];
-
-            // One state is a collection of (virtual) elements sharing
-            // the same physical location on (possibly) different meshes.
-            // This is then the same element of the virtual union mesh.
-            // The proper sub-element mappings to all the functions of
-            // this stage is supplied by the function Traverse::get_next_state()
-            // called in the while loop.
-            assemble_one_state(current_pss, current_spss, current_refmaps, current_u_ext, current_als, &current_state, current_weakform);
-
-            if(DG_matrix_forms_present || DG_vector_forms_present)
-              assemble_one_DG_state(current_pss, current_spss, current_refmaps, current_als, &current_state, current_weakform->mfDG, current_weakform->vfDG, trav[omp_get_thread_num()].fn, current_weakform);
-          }
-          catch(Hermes::Exceptions::Exception& e)
-          {
-            if(this->caughtException == NULL)
-              this->caughtException = e.clone();
-          }
-          catch(std::exception& e)
-          {
-            if(this->caughtException == NULL)
-              this->caughtException = new Hermes::Exceptions::Exception(e.what());
           }
         }
       }
 
       deinit_assembling(pss, spss, refmaps, u_ext, als, weakforms);
 
-      trav_master.finish();
-      for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
-        trav[i].finish();
-
       for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
       {
         fns[i].clear();
       }
       delete [] fns;
-      delete [] trav;
+
+      this->set_conflict_free_assembling(false);
+      this->evict_cache_records();
 
       /// \todo Should this be really here? Or in assemble()?
       if(current_mat != NULL)
@@ -1218,14 +1453,6 @@ namespace Hermes
       if(current_rhs != NULL)
         current_rhs->finish();
 
-      if(DG_matrix_forms_present || DG_vector_forms_present)
-      {
-        Element* element_to_set_nonvisited;
-        for(unsigned int mesh_i = 0; mesh_i < meshes.size(); mesh_i++)
-          for_all_elements(element_to_set_nonvisited, meshes[mesh_i])
-          element_to_set_nonvisited->visited = false;
-      }
-
       if(this->caughtException != NULL)
         throw *(this->caughtException);
     }
@@ -1238,10 +1465,127 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    DiscreteProblem<Scalar>::CacheRecordPerSubIdx::CacheRecordPerSubIdx() : fnsSurface(NULL)
+    DiscreteProblem<Scalar>::CacheRecordPerSubIdx::CacheRecordPerSubIdx(uint64_t sub_idx) : sub_idx(sub_idx), next(NULL), last_used(0), fnsSurface(NULL),
+      local_matrices(NULL), local_matrices_count(0), local_matrices_memory(0)
     {
     }
 
+    template<typename Scalar>
+    size_t DiscreteProblem<Scalar>::CacheRecordPerSubIdx::get_memory() const
+    {
+      // Values and derivatives of the shape functions, geometry and the jacobian x weights.
+      size_t memory = sizeof(double) * this->n_quadrature_points * (3 * this->asmlistCnt + 3);
+      if(this->fnsSurface != NULL)
+        for(unsigned int edge_i = 0; edge_i < nvert; edge_i++)
+          if(this->fnsSurface[edge_i] != NULL)
+            memory += sizeof(double) * this->n_quadrature_pointsSurface[edge_i] * (3 * this->asmlistSurfaceCnt[edge_i] + 7);
+      return memory + this->local_matrices_memory;
+    }
+
+    template<typename Scalar>
+    typename DiscreteProblem<Scalar>::CacheRecordPerSubIdx* DiscreteProblem<Scalar>::find_cache_record(unsigned int space_i, Traverse::State* current_state) const
+    {
+      CacheRecordPerSubIdx* record = this->cache_records_sub_idx[space_i][current_state->e[space_i]->id];
+      while(record != NULL && record->sub_idx != current_state->sub_idx[space_i])
+        record = record->next;
+      return record;
+    }
+
+    template<typename Scalar>
+    typename DiscreteProblem<Scalar>::CacheRecordPerSubIdx* DiscreteProblem<Scalar>::insert_cache_record(unsigned int space_i, Traverse::State* current_state)
+    {
+      CacheRecordPerSubIdx* record = NULL;
+#pragma omp critical (cache_records_sub_idx_insert)
+      {
+        try
+        {
+          record = this->find_cache_record(space_i, current_state);
+          if(record == NULL)
+          {
+            record = new CacheRecordPerSubIdx(current_state->sub_idx[space_i]);
+            record->next = this->cache_records_sub_idx[space_i][current_state->e[space_i]->id];
+            // The record has to be visible to the (lock-free) readers before the list head.
+#pragma omp flush
+            this->cache_records_sub_idx[space_i][current_state->e[space_i]->id] = record;
+          }
+        }
+        catch(std::exception& e)
+        {
+          if(this->caughtException == NULL)
+            this->caughtException = new Hermes::Exceptions::Exception(e.what());
+        }
+      }
+      return record;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::delete_cache_records(unsigned int space_i, unsigned int element_id)
+    {
+      CacheRecordPerSubIdx* record = this->cache_records_sub_idx[space_i][element_id];
+      while(record != NULL)
+      {
+        CacheRecordPerSubIdx* next = record->next;
+        record->clear();
+        delete record;
+        record = next;
+      }
+      this->cache_records_sub_idx[space_i][element_id] = NULL;
+
+      if(this->cache_records_element[space_i][element_id] != NULL)
+      {
+        this->cache_records_element[space_i][element_id]->clear();
+        delete this->cache_records_element[space_i][element_id];
+        this->cache_records_element[space_i][element_id] = NULL;
+      }
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::evict_cache_records()
+    {
+      if(this->cache_memory_budget == 0)
+        return;
+
+      std::vector<std::pair<unsigned int, CacheRecordPerSubIdx*> > records;
+      size_t memory = 0;
+      for(unsigned int space_i = 0; space_i < this->spaces_size; space_i++)
+        for(unsigned int element_i = 0; element_i < this->cache_size; element_i++)
+          for(CacheRecordPerSubIdx* record = this->cache_records_sub_idx[space_i][element_i]; record != NULL; record = record->next)
+          {
+            records.push_back(std::pair<unsigned int, CacheRecordPerSubIdx*>(record->last_used, record));
+            memory += record->get_memory();
+          }
+
+      if(memory <= this->cache_memory_budget)
+        return;
+
+      // Least recently used first.
+      std::sort(records.begin(), records.end());
+      std::set<CacheRecordPerSubIdx*> evicted;
+      for(unsigned int record_i = 0; record_i < records.size() && memory > this->cache_memory_budget; record_i++)
+      {
+        memory -= records[record_i].second->get_memory();
+        evicted.insert(records[record_i].second);
+      }
+
+      for(unsigned int space_i = 0; space_i < this->spaces_size; space_i++)
+        for(unsigned int element_i = 0; element_i < this->cache_size; element_i++)
+        {
+          CacheRecordPerSubIdx** record_ptr = &this->cache_records_sub_idx[space_i][element_i];
+          while(*record_ptr != NULL)
+          {
+            if(evicted.find(*record_ptr) != evicted.end())
+            {
+              CacheRecordPerSubIdx* record = *record_ptr;
+              *record_ptr = record->next;
+              record->clear();
+              delete record;
+            }
+            else
+              record_ptr = &(*record_ptr)->next;
+          }
+        }
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::CacheRecordPerSubIdx::clear()
     {
@@ -1284,6 +1628,16 @@ namespace Hermes
 
         this->fnsSurface = NULL;
       }
+
+      if(this->local_matrices != NULL)
+      {
+        for(int i = 0; i < this->local_matrices_count; i++)
+          delete [] this->local_matrices[i];
+        delete [] this->local_matrices;
+        this->local_matrices = NULL;
+        this->local_matrices_count = 0;
+        this->local_matrices_memory = 0;
+      }
     }
 
     template<typename Scalar>
@@ -1292,6 +1646,28 @@ namespace Hermes
       delete [] this->asmlistIdx;
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::CacheRecordPerElement::set_geometry(Element* e)
+    {
+      this->nvert = e->get_nvert();
+      for(int i = 0; i < this->nvert; i++)
+      {
+        this->vertices[i][0] = e->vn[i]->x;
+        this->vertices[i][1] = e->vn[i]->y;
+      }
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::CacheRecordPerElement::same_geometry(Element* e) const
+    {
+      if(this->nvert != e->get_nvert())
+        return false;
+      for(int i = 0; i < this->nvert; i++)
+        if(this->vertices[i][0] != e->vn[i]->x || this->vertices[i][1] != e->vn[i]->y)
+          return false;
+      return true;
+    }
+
     template<typename Scalar>
     bool DiscreteProblem<Scalar>::state_needs_recalculation(AsmList<Scalar>** current_als, Traverse::State* current_state)
     {
@@ -1302,6 +1678,10 @@ namespace Hermes
         if(this->spaces[i]->edata[current_state->e[i]->id].changed_in_last_adaptation)
           return true;
 
+        // Not calculated yet, or evicted.
+        if(this->find_cache_record(i, current_state) == NULL)
+          return true;
+
         // Check of potential new constraints.
         if(!this->do_not_use_cache)
         {
@@ -1309,6 +1689,9 @@ namespace Hermes
           {
             if(this->cache_records_element[i][current_state->e[i]->id]->asmlistCnt != current_als[i]->cnt)
               return true;
+            // The id may have been given to a different element (reference meshes updated incrementally).
+            else if(!this->cache_records_element[i][current_state->e[i]->id]->same_geometry(current_state->e[i]))
+              return true;
             else
             {
               for(unsigned int idx_i = 0; idx_i < current_als[i]->cnt; idx_i++)
@@ -1329,44 +1712,16 @@ namespace Hermes
     {
       for(unsigned int space_i = 0; space_i < this->spaces_size; space_i++)
       {
-        bool new_cache = false;
         if(current_state->e[space_i] == NULL)
           continue;
 
-        // No sub_idx map for this element.
-#pragma omp critical (cache_records_sub_idx_map)
-        {
-          try
-          {
-            if(this->cache_records_sub_idx[space_i][current_state->e[space_i]->id] == NULL)
-            {
-              this->cache_records_sub_idx[space_i][current_state->e[space_i]->id] = new std::map<uint64_t, CacheRecordPerSubIdx*>;
-              new_cache = true;
-            }
-            else
-            {
-              // If the sub_idx map exists AND contains a record for this sub_idx, we need to delete the record.
-              typename std::map<uint64_t, CacheRecordPerSubIdx*>::iterator it = this->cache_records_sub_idx[space_i][current_state->e[space_i]->id]->find(current_state->sub_idx[space_i]);
-              if(it != this->cache_records_sub_idx[space_i][current_state->e[space_i]->id]->end())
-                (*it).second->clear();
-              else new_cache = true;
-            }
+        // If the record exists, it is recalculated, otherwise a new one is inserted.
+        CacheRecordPerSubIdx* record = this->find_cache_record(space_i, current_state);
+        if(record != NULL)
+          record->clear();
+        else
+          this->insert_cache_record(space_i, current_state);
 
-            // Insert the new record.
-            if(new_cache)
-              this->cache_records_sub_idx[space_i][current_state->e[space_i]->id]->insert(std::pair<uint64_t, CacheRecordPerSubIdx*>(current_state->sub_idx[space_i], new CacheRecordPerSubIdx));
-          }
-          catch(Hermes::Exceptions::Exception& e)
-          {
-            if(this->caughtException == NULL)
-              this->caughtException = e.clone();
-          }
-          catch(std::exception& e)
-          {
-            if(this->caughtException == NULL)
-              this->caughtException = new Hermes::Exceptions::Exception(e.what());
-          }
-        }
         if(this->caughtException != NULL)
           return;
       }
@@ -1482,13 +1837,11 @@ namespace Hermes
           this->cache_records_element[i][current_state->e[i]->id]->asmlistIdx = new int[current_als[i]->cnt];
           for(unsigned int asmlist_i = 0; asmlist_i < current_als[i]->cnt; asmlist_i++)
             this->cache_records_element[i][current_state->e[i]->id]->asmlistIdx[asmlist_i] = current_als[i]->idx[asmlist_i];
+          this->cache_records_element[i][current_state->e[i]->id]->set_geometry(current_state->e[i]);
           this->cache_element_stored[i][current_state->e[i]->id] = true;
         }
 
-        CacheRecordPerSubIdx* newRecord;
-
-#pragma omp critical (cache_records_sub_idx_map)
-        newRecord = (*this->cache_records_sub_idx[i][current_state->e[i]->id]->find(current_state->sub_idx[i])).second;
+        CacheRecordPerSubIdx* newRecord = this->find_cache_record(i, current_state);
 
         newRecord->nvert = current_state->rep->nvert;
         newRecord->order = order;
@@ -1574,6 +1927,16 @@ namespace Hermes
 
         // Do we have to recalculate the data for this state even if the cache contains the data?
         bool changedInLastAdaptation = this->do_not_use_cache ? true : this->state_needs_recalculation(current_als, current_state);
+        if(changedInLastAdaptation)
+        {
+#pragma omp atomic
+          this->cache_misses++;
+        }
+        else
+        {
+#pragma omp atomic
+          this->cache_hits++;
+        }
 
         // Assembly lists for surface forms.
         AsmList<Scalar>** current_alsSurface = NULL;
@@ -1605,12 +1968,8 @@ namespace Hermes
         {
           if(current_state->e[temp_i] == NULL)
             continue;
-#pragma omp critical (cache_records_sub_idx_map)
-          {
-            typename std::map<uint64_t, CacheRecordPerSubIdx*>::iterator it = this->cache_records_sub_idx[temp_i][current_state->e[temp_i]->id]->find(current_state->sub_idx[temp_i]);
-            if(it != this->cache_records_sub_idx[temp_i][current_state->e[temp_i]->id]->end())
-              cacheRecordPerSubIdx[temp_i] = it->second;
-          }
+          cacheRecordPerSubIdx[temp_i] = this->find_cache_record(temp_i, current_state);
+          cacheRecordPerSubIdx[temp_i]->last_used = this->cache_assembling_stamp;
         }
 
         // Ext functions.
@@ -1918,7 +2277,8 @@ namespace Hermes
       bool sym = (form->i == form->j) && (form->sym == 1);
 
       // Assemble the local stiffness matrix for the form form.
-      Scalar **local_stiffness_matrix = new_matrix<Scalar>(std::max(current_als_i->cnt, current_als_j->cnt));
+      LocalMatrixBuffer* buffer = &this->local_matrix_buffers[omp_get_thread_num()];
+      Scalar **local_stiffness_matrix = buffer->get_local_stiffness_matrix(std::max(current_als_i->cnt, current_als_j->cnt));
 
       Func<Scalar>** local_ext = ext;
       // If the user supplied custom ext functions for this form.
@@ -1937,6 +2297,9 @@ namespace Hermes
       if(RungeKutta)
         u_ext += form->u_ext_offset;
 
+      // Batched evaluation of all pairs, if the form provides it.
+      Scalar** form_values = this->calc_local_matrix_values(form, n_quadrature_points, jacobian_x_weights, u_ext, base_fns, test_fns, geometry, local_ext, current_als_i, current_als_j, false, buffer);
+
       // Actual form-specific calculation.
       for (unsigned int i = 0; i < current_als_i->cnt; i++)
       {
@@ -1960,10 +2323,12 @@ namespace Hermes
               Func<double>* u = base_fns[j];
               Func<double>* v = test_fns[i];
 
+              Scalar form_value = form_values != NULL ? form_values[i][j] : form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext);
+
               if(surface_form)
-                local_stiffness_matrix[i][j] = 0.5 * block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+                local_stiffness_matrix[i][j] = 0.5 * block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
               else
-                local_stiffness_matrix[i][j] = block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+                local_stiffness_matrix[i][j] = block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
             }
           }
         }
@@ -1983,7 +2348,9 @@ namespace Hermes
               Func<double>* u = base_fns[j];
               Func<double>* v = test_fns[i];
 
-              Scalar val = block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+              Scalar form_value = form_values != NULL ? form_values[i][j] : form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext);
+
+              Scalar val = block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
 
               local_stiffness_matrix[i][j] = local_stiffness_matrix[j][i] = val;
             }
@@ -2019,8 +2386,109 @@ namespace Hermes
       if(RungeKutta)
         u_ext -= form->u_ext_offset;
 
-      // Cleanup.
+    }
+
+    template<typename Scalar>
+    Scalar** DiscreteProblem<Scalar>::calc_local_matrix_values(MatrixForm<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext, Func<double>** base_fns, Func<double>** test_fns,
+      Geom<double>* geometry, Func<Scalar>** ext, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, bool dirichlet_basis_fns, LocalMatrixBuffer* buffer)
+    {
+      if(!form->has_value_local_matrix())
+        return NULL;
+
+      // For a symmetric form the basis functions with nonnegative dofs are the test functions.
+      bool sym = (form->i == form->j) && (form->sym == 1);
+
+      buffer->ensure_size(std::max(current_als_i->cnt, current_als_j->cnt));
+
+      // Only the pairs that are really assembled are handed over to the form.
+      int test_count = 0;
+      for (unsigned int i = 0; i < current_als_i->cnt; i++)
+      {
+        if(current_als_i->dof[i] < 0 || std::abs(current_als_i->coef[i]) < 1e-12)
+          continue;
+        buffer->test_indices[test_count] = i;
+        buffer->used_test_fns[test_count++] = test_fns[i];
+      }
+
+      int basis_count = 0;
+      for (unsigned int j = 0; j < current_als_j->cnt; j++)
+      {
+        if((sym && current_als_j->dof[j] >= 0) || (!dirichlet_basis_fns && current_als_j->dof[j] < 0) || std::abs(current_als_j->coef[j]) < 1e-12)
+          continue;
+        buffer->basis_indices[basis_count] = j;
+        buffer->used_base_fns[basis_count++] = base_fns[j];
+      }
+
+      Scalar** form_values = buffer->form_values;
+      Scalar** compressed_values = buffer->compressed_values;
+      if(sym && test_count > 0)
+      {
+        // The upper triangle, mirrored.
+        form->value_local_matrix(n_quadrature_points, jacobian_x_weights, u_ext, test_count, buffer->used_test_fns, test_count, buffer->used_test_fns, geometry, ext, compressed_values, true);
+        for(int i = 0; i < test_count; i++)
+          for(int j = i; j < test_count; j++)
+            form_values[buffer->test_indices[i]][buffer->test_indices[j]] = form_values[buffer->test_indices[j]][buffer->test_indices[i]] = compressed_values[i][j];
+      }
+      // All the pairs, for a symmetric form the Dirichlet lift ones only.
+      if(test_count > 0 && basis_count > 0)
+      {
+        form->value_local_matrix(n_quadrature_points, jacobian_x_weights, u_ext, basis_count, buffer->used_base_fns, test_count, buffer->used_test_fns, geometry, ext, compressed_values, false);
+        for(int i = 0; i < test_count; i++)
+          for(int j = 0; j < basis_count; j++)
+            form_values[buffer->test_indices[i]][buffer->basis_indices[j]] = compressed_values[i][j];
+      }
+
+      return form_values;
+    }
+
+    template<typename Scalar>
+    DiscreteProblem<Scalar>::LocalMatrixBuffer::LocalMatrixBuffer() : size(0), local_stiffness_matrix(NULL), form_values(NULL), compressed_values(NULL),
+      test_indices(NULL), basis_indices(NULL), used_test_fns(NULL), used_base_fns(NULL)
+    {
+    }
+
+    template<typename Scalar>
+    DiscreteProblem<Scalar>::LocalMatrixBuffer::~LocalMatrixBuffer()
+    {
+      this->free();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::LocalMatrixBuffer::free()
+    {
       delete [] local_stiffness_matrix;
+      delete [] form_values;
+      delete [] compressed_values;
+      delete [] test_indices;
+      delete [] basis_indices;
+      delete [] used_test_fns;
+      delete [] used_base_fns;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::LocalMatrixBuffer::ensure_size(unsigned int size)
+    {
+      if(size <= this->size)
+        return;
+
+      this->free();
+      this->size = size;
+      local_stiffness_matrix = new_matrix<Scalar>(size);
+      form_values = new_matrix<Scalar>(size);
+      compressed_values = new_matrix<Scalar>(size);
+      test_indices = new int[size];
+      basis_indices = new int[size];
+      used_test_fns = new Func<double>*[size];
+      used_base_fns = new Func<double>*[size];
+    }
+
+    template<typename Scalar>
+    Scalar** DiscreteProblem<Scalar>::LocalMatrixBuffer::get_local_stiffness_matrix(unsigned int size)
+    {
+      this->ensure_size(size);
+      for(unsigned int i = 0; i < size; i++)
+        memset(local_stiffness_matrix[i], 0, size * sizeof(Scalar));
+      return local_stiffness_matrix;
     }
 
     template<typename Scalar>
@@ -2251,41 +2719,27 @@ namespace Hermes
         if(spaces[i]->get_mesh()->get_seq() < min_dg_mesh_seq || i == 0)
           min_dg_mesh_seq = spaces[i]->get_mesh()->get_seq();
 
-      // Create neighbor psss, refmaps.
-      std::map<unsigned int, PrecalcShapeset *> npss;
-      std::map<unsigned int, PrecalcShapeset *> nspss;
-      std::map<unsigned int, RefMap *> nrefmap;
-
-      // Initialize neighbor precalc shapesets and refmaps.
-      // This is only needed when there are matrix DG forms present.
+      // Neighbor psss, refmaps of this thread (only present with matrix DG forms).
+      PrecalcShapeset** npss = NULL;
+      PrecalcShapeset** nspss = NULL;
+      RefMap** nrefmap = NULL;
       if(DG_matrix_forms_present)
       {
-        for (unsigned int i = 0; i < spaces.size(); i++)
-        {
-          PrecalcShapeset* new_ps = new PrecalcShapeset(spaces[i]->shapeset);
-          npss.insert(std::pair<unsigned int, PrecalcShapeset*>(i, new_ps));
-          PrecalcShapeset* new_pss = new PrecalcShapeset(npss[i]);
-          nspss.insert(std::pair<unsigned int, PrecalcShapeset*>(i, new_pss));
-          RefMap* new_rm = new RefMap();
-          new_rm->set_quad_2d(&g_quad_2d_std);
-          nrefmap.insert(std::pair<unsigned int, RefMap*>(i, new_rm));
-        }
+        npss = neighbor_pss[omp_get_thread_num()];
+        nspss = neighbor_spss[omp_get_thread_num()];
+        nrefmap = neighbor_refmaps[omp_get_thread_num()];
       }
 
       bool** processed = new bool*[current_state->rep->nvert];
       LightArray<NeighborSearch<Scalar>*>** neighbor_searches = new LightArray<NeighborSearch<Scalar>*>*[current_state->rep->nvert];
-      (5);
       unsigned int* num_neighbors = new unsigned int[current_state->rep->nvert];
 
       bool intra_edge_passed_DG[H2D_MAX_NUMBER_VERTICES];
       for(int a = 0; a < H2D_MAX_NUMBER_VERTICES; a++)
         intra_edge_passed_DG[a] = false;
 
-#pragma omp critical (DG)
+      // The neighbor searches only read the meshes, the states are processed in parallel.
       {
-        for(unsigned int i = 0; i < current_state->num; i++)
-          current_state->e[i]->visited = true;
-
         for(current_state->isurf = 0; current_state->isurf < current_state->rep->nvert; current_state->isurf++)
         {
           bool inner_edge_for_dg = false;
@@ -2380,23 +2834,7 @@ namespace Hermes
             processed[current_state->isurf] = new bool[num_neighbors[current_state->isurf]];
 
             for(unsigned int neighbor_i = 0; neighbor_i < num_neighbors[current_state->isurf]; neighbor_i++)
-            {
-              // If the active segment has already been processed (when the neighbor element was assembled), it is skipped.
-              // We test all neighbor searches, because in the case of intra-element edge, the neighboring (the same as central) element
-              // will be marked as visited, even though the edge was not calculated.
-              processed[current_state->isurf][neighbor_i] = true;
-              for(unsigned int i = 0; i < (*neighbor_searches[current_state->isurf]).get_size(); i++)
-              {
-                if((*neighbor_searches[current_state->isurf]).present(i))
-                {
-                  if(!(*neighbor_searches[current_state->isurf]).get(i)->neighbors.at(neighbor_i)->visited)
-                  {
-                    processed[current_state->isurf][neighbor_i] = false;
-                    break;
-                  }
-                }
-              }
-            }
+              processed[current_state->isurf][neighbor_i] = DG_segment_assembled_from_neighbor((*neighbor_searches[current_state->isurf]), neighbor_i);
           }
         }
       }
@@ -2437,24 +2875,30 @@ namespace Hermes
       delete [] processed;
       delete [] neighbor_searches;
       delete [] num_neighbors;
+    }
 
-      // Deinitialize neighbor pss's, refmaps.
-      if(DG_matrix_forms_present)
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::DG_segment_assembled_from_neighbor(LightArray<NeighborSearch<Scalar>*>& neighbor_searches, unsigned int neighbor_i) const
+    {
+      // The segment is seen from both sides with the same meshes, the first mesh where the two elements differ
+      // (it may be an intra-element edge on the others) decides by the element ids.
+      for(unsigned int i = 0; i < neighbor_searches.get_size(); i++)
       {
-        for(std::map<unsigned int, PrecalcShapeset *>::iterator it = nspss.begin(); it != nspss.end(); it++)
-          delete it->second;
-        for(std::map<unsigned int, PrecalcShapeset *>::iterator it = npss.begin(); it != npss.end(); it++)
-          delete it->second;
-        for(std::map<unsigned int, RefMap *>::iterator it = nrefmap.begin(); it != nrefmap.end(); it++)
-          delete it->second;
+        if(!neighbor_searches.present(i))
+          continue;
+        NeighborSearch<Scalar>* ns = neighbor_searches.get(i);
+        Element* neighbor = ns->neighbors.at(neighbor_i);
+        if(neighbor->id != ns->central_el->id)
+          return neighbor->id < ns->central_el->id;
       }
+      return true;
     }
 
     template<typename Scalar>
     void DiscreteProblem<Scalar>::assemble_DG_one_neighbor(bool edge_processed, unsigned int neighbor_i,
       PrecalcShapeset** current_pss, PrecalcShapeset** current_spss, RefMap** current_refmaps, AsmList<Scalar>** current_als,
       Traverse::State* current_state, Hermes::vector<MatrixFormDG<Scalar>*> current_mfDG, Hermes::vector<VectorFormDG<Scalar>*> current_vfDG, Transformable** fn,
-      std::map<unsigned int, PrecalcShapeset *> npss, std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap,
+      PrecalcShapeset** npss, PrecalcShapeset** nspss, RefMap** nrefmap,
       LightArray<NeighborSearch<Scalar>*>& neighbor_searches, unsigned int min_dg_mesh_seq, WeakForm<Scalar>* current_wf)
     {
       // Set the active segment in all NeighborSearches
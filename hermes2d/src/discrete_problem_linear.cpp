@@ -34,19 +34,19 @@ namespace Hermes
   namespace Hermes2D
   {
     template<typename Scalar>
-    DiscreteProblemLinear<Scalar>::DiscreteProblemLinear(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar> *> spaces) : DiscreteProblem<Scalar>(wf, spaces)
+    DiscreteProblemLinear<Scalar>::DiscreteProblemLinear(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar> *> spaces) : DiscreteProblem<Scalar>(wf, spaces), reuse_local_matrices(false)
     {
       this->is_linear = true;
     }
 
     template<typename Scalar>
-    DiscreteProblemLinear<Scalar>::DiscreteProblemLinear(const WeakForm<Scalar>* wf, const Space<Scalar>* space) : DiscreteProblem<Scalar>(wf, space)
+    DiscreteProblemLinear<Scalar>::DiscreteProblemLinear(const WeakForm<Scalar>* wf, const Space<Scalar>* space) : DiscreteProblem<Scalar>(wf, space), reuse_local_matrices(false)
     {
       this->is_linear = true;
     }
 
     template<typename Scalar>
-    DiscreteProblemLinear<Scalar>::DiscreteProblemLinear() : DiscreteProblem<Scalar>()
+    DiscreteProblemLinear<Scalar>::DiscreteProblemLinear() : DiscreteProblem<Scalar>(), reuse_local_matrices(false)
     {
       this->is_linear = true;
     }
@@ -56,6 +56,12 @@ namespace Hermes
     {
     }
 
+    template<typename Scalar>
+    void DiscreteProblemLinear<Scalar>::set_reuse_local_matrices(bool to_set)
+    {
+      this->reuse_local_matrices = to_set;
+    }
+
     template<typename Scalar>
     void DiscreteProblemLinear<Scalar>::assemble(SparseMatrix<Scalar>* mat,
       Vector<Scalar>* rhs,
@@ -111,12 +117,10 @@ namespace Hermes
           if(this->wf->get_forms()[form_i]->ext[ext_i] != NULL)
             meshes.push_back(this->wf->get_forms()[form_i]->ext[ext_i]->get_mesh());
 
-      Traverse trav_master(true);
-      unsigned int num_states = trav_master.get_num_states(meshes);
-
-      trav_master.begin(meshes.size(), &(meshes.front()));
+      // Union mesh states, sorted by colors.
+      this->init_state_coloring(meshes);
+      this->cache_assembling_stamp++;
 
-      Traverse* trav = new Traverse[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
       Hermes::vector<Transformable *>* fns = new Hermes::vector<Transformable *>[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
       for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
       {
@@ -136,11 +140,9 @@ namespace Hermes
               weakforms[i]->get_forms()[form_i]->ext[ext_i]->set_quad_2d(&g_quad_2d_std);
             }
         }
-        trav[i].begin(meshes.size(), &(meshes.front()), &(fns[i].front()));
-        trav[i].stack = trav_master.stack;
       }
 
-      int state_i;
+      int state_i, chunk_i, task_i;
 
       PrecalcShapeset** current_pss;
       PrecalcShapeset** current_spss;
@@ -150,78 +152,81 @@ namespace Hermes
 
 #define CHUNKSIZE 1
       int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
-#pragma omp parallel shared(trav_master, mat, rhs ) private(state_i, current_pss, current_spss, current_refmaps, current_als, current_weakform) num_threads(num_threads_used)
+      this->begin_thread_local_assembling(num_threads_used);
+      this->set_conflict_free_assembling(true);
+#pragma omp parallel shared(fns, mat, rhs) private(state_i, chunk_i, task_i, current_pss, current_spss, current_refmaps, current_als, current_weakform) num_threads(num_threads_used)
       {
-#pragma omp for schedule(static, CHUNKSIZE)
-        for(state_i = 0; state_i < num_states; state_i++)
+        for(unsigned int color_i = 0; color_i < this->color_offsets.size() - 1; color_i++)
         {
-          if(this->caughtException != NULL)
-            continue;
-
-          try
+          // No two states of one color share a DOF, the implicit barrier at the end of the omp for separates the colors.
+          // The states of the color are split into chunks of H2D_ASSEMBLING_CHUNK_SIZE states, the chunk chunk_i is assembled
+          // in order into the buffer chunk_i % H2D_THREAD_LOCAL_BUFFERS. Every value gets at most one contribution per color,
+          // so the result does not depend on the number of threads or on the scheduling. Without the coloring (DG forms),
+          // the chunks sharing a buffer are assembled one after another by one thread.
+          int color_begin = this->color_offsets[color_i];
+          int color_count = this->color_offsets[color_i + 1] - color_begin;
+          int chunk_count = (color_count + H2D_ASSEMBLING_CHUNK_SIZE - 1) / H2D_ASSEMBLING_CHUNK_SIZE;
+          bool chunks_conflict = this->thread_local_buffers_used && (this->DG_matrix_forms_present || this->DG_vector_forms_present);
+          int task_count = chunks_conflict ? std::min(chunk_count, H2D_THREAD_LOCAL_BUFFERS) : chunk_count;
+          int chunk_step = chunks_conflict ? H2D_THREAD_LOCAL_BUFFERS : chunk_count;
+#pragma omp for schedule(dynamic, CHUNKSIZE)
+          for(task_i = 0; task_i < task_count; task_i++)
           {
-            Traverse::State current_state;
-
-#pragma omp critical (get_next_state)
+            for(chunk_i = task_i; chunk_i < chunk_count; chunk_i += chunk_step)
             {
-              try
-              {
-                current_state = trav[omp_get_thread_num()].get_next_state(&trav_master.top, &trav_master.id);
-              }
-              catch(Hermes::Exceptions::Exception& e)
-              {
-                if(this->caughtException == NULL)
-                  this->caughtException = e.clone();
-              }
-              catch(std::exception& e)
+              this->set_thread_local_buffer(chunk_i % H2D_THREAD_LOCAL_BUFFERS);
+              int chunk_end = std::min(color_begin + (chunk_i + 1) * H2D_ASSEMBLING_CHUNK_SIZE, color_begin + color_count);
+              for(state_i = color_begin + chunk_i * H2D_ASSEMBLING_CHUNK_SIZE; state_i < chunk_end; state_i++)
               {
-                if(this->caughtException == NULL)
-                  this->caughtException = new Hermes::Exceptions::Exception(e.what());
+                if(this->caughtException != NULL)
+                  continue;
+                try
+                {
+                  Traverse::State* current_state = this->colored_states[state_i];
+                  Traverse::set_state_transforms(current_state, &(fns[omp_get_thread_num()].front()));
+
+                  current_pss = pss[omp_get_thread_num()];
+                  current_spss = spss[omp_get_thread_num()];
+                  current_refmaps = refmaps[omp_get_thread_num()];
+                  current_als = als[omp_get_thread_num()];
+                  current_weakform = weakforms[omp_get_thread_num()];
+
+                  // One state is a collection of (virtual) elements sharing
+                  // the same physical location on (possibly) different meshes.
+                  // This is then the same element of the virtual union mesh.
+                  // The proper sub-element mappings to all the functions of
+                  // this stage are set by Traverse::set_state_transforms() above.
+                  this->assemble_one_state(current_pss, current_spss, current_refmaps, NULL, current_als, current_state, current_weakform);
+
+                  if(this->DG_matrix_forms_present || this->DG_vector_forms_present)
+                    this->assemble_one_DG_state(current_pss, current_spss, current_refmaps, current_als, current_state, current_weakform->mfDG, current_weakform->vfDG, &(fns[omp_get_thread_num()].front()), current_weakform);
+                }
+                catch(Hermes::Exceptions::Exception& e)
+                {
+                  if(this->caughtException == NULL)
+                    this->caughtException = e.clone();
+                }
+                catch(std::exception& e)
+                {
+                  if(this->caughtException == NULL)
+                    this->caughtException = new Hermes::Exceptions::Exception(e.what());
+                }
               }
             }
-
-            current_pss = pss[omp_get_thread_num()];
-            current_spss = spss[omp_get_thread_num()];
-            current_refmaps = refmaps[omp_get_thread_num()];
-            current_als = als[omp_get_thread_num()];
-            current_weakform = weakforms[omp_get_thread_num()];
-
-            // One state is a collection of (virtual) elements sharing
-            // the same physical location on (possibly) different meshes.
-            // This is then the same element of the virtual union mesh.
-            // The proper sub-element mappings to all the functions of
-            // this stage is supplied by the function Traverse::get_next_state()
-            // called in the while loop. 
-            this->assemble_one_state(current_pss, current_spss, current_refmaps, NULL, current_als, &current_state, current_weakform);
-
-            if(this->DG_matrix_forms_present || this->DG_vector_forms_present)
-              this->assemble_one_DG_state(current_pss, current_spss, current_refmaps, current_als, &current_state, current_weakform->mfDG, current_weakform->vfDG, trav[omp_get_thread_num()].fn, current_weakform);
-          }
-          catch(Hermes::Exceptions::Exception& e)
-          {
-            if(this->caughtException == NULL)
-              this->caughtException = e.clone();
-          }
-          catch(std::exception& e)
-          {
-            if(this->caughtException == NULL)
-              this->caughtException = new Hermes::Exceptions::Exception(e.what());
           }
         }
       }
 
       this->deinit_assembling(pss, spss, refmaps, NULL, als, weakforms);
 
-      trav_master.finish();
-      for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
-        trav[i].finish();
-
       for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
       {
         fns[i].clear();
       }
       delete [] fns;
-      delete [] trav;
+
+      this->set_conflict_free_assembling(false);
+      this->evict_cache_records();
 
       /// \todo Should this be really here? Or in assemble()?
       if(this->current_mat != NULL)
@@ -229,16 +234,14 @@ namespace Hermes
       if(this->current_rhs != NULL)
         this->current_rhs->finish();
 
-      if(this->DG_matrix_forms_present || this->DG_vector_forms_present)
-      {
-        Element* element_to_set_nonvisited;
-        for(unsigned int mesh_i = 0; mesh_i < meshes.size(); mesh_i++)
-          for_all_elements(element_to_set_nonvisited, meshes[mesh_i])
-          element_to_set_nonvisited->visited = false;
-      }
-
       if(this->caughtException != NULL)
         throw *(this->caughtException);
+
+      // The cached data of all the elements is up to date now, until the next adaptivity step marks some of them again.
+      Element* e;
+      for(unsigned int i = 0; i < this->spaces_size; i++)
+        for_all_active_elements(e, this->spaces[i]->get_mesh())
+          this->spaces[i]->edata[e->id].changed_in_last_adaptation = false;
     }
 
     template<typename Scalar>
@@ -253,7 +256,8 @@ namespace Hermes
       bool sym = (form->i == form->j) && (form->sym == 1);
 
       // Assemble the local stiffness matrix for the form form.
-      Scalar **local_stiffness_matrix = new_matrix<Scalar>(std::max(current_als_i->cnt, current_als_j->cnt));
+      typename DiscreteProblem<Scalar>::LocalMatrixBuffer* buffer = &this->local_matrix_buffers[omp_get_thread_num()];
+      Scalar **local_stiffness_matrix = buffer->get_local_stiffness_matrix(std::max(current_als_i->cnt, current_als_j->cnt));
 
       Func<Scalar>** local_ext = ext;
       // If the user supplied custom ext functions for this form.
@@ -268,6 +272,12 @@ namespace Hermes
             local_ext[ext_i] = NULL;
       }
 
+      // Values stored from the previous assembling on this (unchanged) element.
+      Scalar** stored_values = this->get_local_matrix_values(form, n_quadrature_points, jacobian_x_weights, u_ext, base_fns, test_fns, geometry, current_als_i, current_als_j, current_state);
+
+      // Batched evaluation of all pairs (including the Dirichlet lift ones), if the form provides it.
+      Scalar** form_values = stored_values != NULL ? stored_values : this->calc_local_matrix_values(form, n_quadrature_points, jacobian_x_weights, u_ext, base_fns, test_fns, geometry, local_ext, current_als_i, current_als_j, true, buffer);
+
       // Actual form-specific calculation.
       for (unsigned int i = 0; i < current_als_i->cnt; i++)
       {
@@ -289,20 +299,22 @@ namespace Hermes
             Func<double>* u = base_fns[j];
             Func<double>* v = test_fns[i];
 
+            Scalar form_value = form_values != NULL ? form_values[i][j] : form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext);
+
             if(current_als_j->dof[j] >= 0)
             {
               if(surface_form)
-                local_stiffness_matrix[i][j] = 0.5 * block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+                local_stiffness_matrix[i][j] = 0.5 * block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
               else
-                local_stiffness_matrix[i][j] = block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+                local_stiffness_matrix[i][j] = block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
             }
             else
             {
               {
                 if(surface_form)
-                  this->current_rhs->add(current_als_i->dof[i], -0.5 * block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i]);
+                  this->current_rhs->add(current_als_i->dof[i], -0.5 * block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i]);
                 else
-                  this->current_rhs->add(current_als_i->dof[i], -block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i]);
+                  this->current_rhs->add(current_als_i->dof[i], -block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i]);
               }
             }
           }
@@ -321,7 +333,9 @@ namespace Hermes
             Func<double>* u = base_fns[j];
             Func<double>* v = test_fns[i];
 
-            Scalar val = block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+            Scalar form_value = form_values != NULL ? form_values[i][j] : form->value(n_quadrature_points, jacobian_x_weights, u_ext, u, v, geometry, local_ext);
+
+            Scalar val = block_scaling_coefficient * form_value * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
 
             if(current_als_j->dof[j] >= 0)
               local_stiffness_matrix[i][j] = local_stiffness_matrix[j][i] = val;
@@ -363,9 +377,63 @@ namespace Hermes
           }
           delete [] local_ext;
       }
+    }
+
+    template<typename Scalar>
+    Scalar** DiscreteProblemLinear<Scalar>::get_local_matrix_values(MatrixForm<Scalar>* form, int n_quadrature_points, double* jacobian_x_weights, Func<Scalar>** u_ext, Func<double>** base_fns, Func<double>** test_fns,
+      Geom<double>* geometry, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Traverse::State* current_state)
+    {
+      if(!this->reuse_local_matrices || this->do_not_use_cache || form->ext.size() > 0 || form->wf->ext.size() > 0)
+        return NULL;
+
+      // Slot of the form in the record: volumetric forms, then the surface forms of every edge.
+      const WeakForm<Scalar>* form_wf = form->wf;
+      int mfvol_count = form_wf->mfvol.size();
+      int mfsurf_count = form_wf->mfsurf.size();
+      int slot = -1;
+      if(dynamic_cast<MatrixFormVol<Scalar>*>(form) != NULL)
+      {
+        for(int form_i = 0; form_i < mfvol_count; form_i++)
+          if(form_wf->mfvol[form_i] == form)
+            slot = form_i;
+      }
+      else
+      {
+        for(int form_i = 0; form_i < mfsurf_count; form_i++)
+          if(form_wf->mfsurf[form_i] == form)
+            slot = mfvol_count + current_state->isurf * mfsurf_count + form_i;
+      }
+      if(slot == -1)
+        return NULL;
+
+      // The record is unique to the state, i.e. it is only accessed by the thread assembling this state.
+      typename DiscreteProblem<Scalar>::CacheRecordPerSubIdx* record = this->find_cache_record(form->i, current_state);
+      if(record == NULL)
+        return NULL;
+
+      if(record->local_matrices == NULL)
+      {
+        record->local_matrices_count = mfvol_count + H2D_MAX_NUMBER_EDGES * mfsurf_count;
+        record->local_matrices = new Scalar**[record->local_matrices_count];
+        memset(record->local_matrices, 0, record->local_matrices_count * sizeof(Scalar**));
+        record->local_matrices_memory = record->local_matrices_count * sizeof(Scalar**);
+      }
+
+      if(record->local_matrices[slot] == NULL)
+      {
+        // All the pairs are stored, so that the values stay valid if the coefficients or DOFs of the basis functions change.
+        Scalar** values = new_matrix<Scalar>(current_als_i->cnt, current_als_j->cnt);
+        bool sym = (form->i == form->j) && (form->sym == 1);
+        form->value_local_matrix(n_quadrature_points, jacobian_x_weights, u_ext, current_als_j->cnt, base_fns, current_als_i->cnt, test_fns, geometry, NULL, values, sym);
+        if(sym)
+          for (unsigned int i = 0; i < current_als_i->cnt; i++)
+            for (unsigned int j = i + 1; j < current_als_j->cnt; j++)
+              values[j][i] = values[i][j];
+        record->local_matrices[slot] = values;
+        record->local_matrices_memory += sizeof(Scalar*) * current_als_i->cnt + sizeof(Scalar) * current_als_i->cnt * current_als_j->cnt;
+      }
 
-      // Cleanup.
-      delete [] local_stiffness_matrix;
+      return record->local_matrices[slot];
     }
 
     template class HERMES_API DiscreteProblemLinear<double>;
@@ -279,6 +279,15 @@ namespace Hermes
       this->ctm = ctm;
     }
 
+    template<typename Scalar>
+    Func<Scalar>** MeshFunction<Scalar>::get_pt_values(double* x, double* y, int n)
+    {
+      Func<Scalar>** values = new Func<Scalar>*[n];
+      for (int i = 0; i < n; i++)
+        values[i] = this->get_pt_value(x[i], y[i]);
+      return values;
+    }
+
     template class HERMES_API MeshFunction<double>;
     template class HERMES_API MeshFunction<std::complex<double> >;
   }
@@ -17,6 +17,7 @@
 #include "forms.h"
 
 #include "solution_h2d_xml.h"
+#include "binary_io.h"
 #include "ogprojection.h"
 #include "api2d.h"
 
@@ -27,6 +28,10 @@ namespace Hermes
 {
   namespace Hermes2D
   {
+    /// Identification and version of the binary solution format.
+    static const char* H2D_SOLUTION_BINARY_MAGIC = "H2DSOLN_";
+    static const unsigned int H2D_SOLUTION_BINARY_VERSION = 1;
+
     static double3* cheb_tab_tri[11];
     static double3* cheb_tab_quad[11];
     static int      cheb_np_tri[11];
@@ -106,6 +111,7 @@ namespace Hermes
       elem_coeffs[0] = elem_coeffs[1] = NULL;
       elem_orders = NULL;
       dxdy_buffer = NULL;
+      mapping = NULL;
       num_coeffs = num_elems = 0;
       num_dofs = -1;
 
@@ -131,6 +137,7 @@ namespace Hermes
 			elem_coeffs[0] = elem_coeffs[1] = NULL;
 			elem_orders = NULL;
 			dxdy_buffer = NULL;
+			mapping = NULL;
 			num_coeffs = num_elems = 0;
 			num_dofs = -1;
 
@@ -221,6 +228,7 @@ namespace Hermes
       elem_coeffs[0] = sln->elem_coeffs[0];  sln->elem_coeffs[0] = NULL;
       elem_coeffs[1] = sln->elem_coeffs[1];  sln->elem_coeffs[1] = NULL;
       elem_orders = sln->elem_orders;      sln->elem_orders = NULL;
+      mapping = sln->mapping;              sln->mapping = NULL;
       dxdy_buffer = sln->dxdy_buffer;      sln->dxdy_buffer = NULL;
       num_coeffs = sln->num_coeffs;          sln->num_coeffs = 0;
       num_elems = sln->num_elems;          sln->num_elems = 0;
@@ -301,6 +309,17 @@ namespace Hermes
     template<>
     void Solution<double>::free()
     {
+      // Arrays used in place from a memory-mapped file.
+      if(mapping != NULL)
+      {
+        mono_coeffs = NULL;
+        elem_orders = NULL;
+        for (int i = 0; i < this->num_components; i++)
+          elem_coeffs[i] = NULL;
+        delete mapping;
+        mapping = NULL;
+      }
+
       if(mono_coeffs  != NULL) { delete [] mono_coeffs;   mono_coeffs = NULL;  }
       if(elem_orders != NULL) { delete [] elem_orders;  elem_orders = NULL; }
       if(dxdy_buffer != NULL) { delete [] dxdy_buffer;  dxdy_buffer = NULL; }
@@ -317,6 +336,17 @@ namespace Hermes
 		template<>
 		void Solution<std::complex<double> >::free()
 		{
+			// Arrays used in place from a memory-mapped file.
+			if(mapping != NULL)
+			{
+				mono_coeffs = NULL;
+				elem_orders = NULL;
+				for (int i = 0; i < this->num_components; i++)
+					elem_coeffs[i] = NULL;
+				delete mapping;
+				mapping = NULL;
+			}
+
 			if(mono_coeffs  != NULL) { delete [] mono_coeffs;   mono_coeffs = NULL;  }
 			if(elem_orders != NULL) { delete [] elem_orders;  elem_orders = NULL; }
 			if(dxdy_buffer != NULL) { delete [] dxdy_buffer;  dxdy_buffer = NULL; }
@@ -351,20 +381,27 @@ namespace Hermes
       // this is a set of LU-decomposed matrices shared by all Solutions
       double** mat[2][11];
       int* perm[2][11];
+      // and their inverses, so that the monomial coefficients of an element are just a matrix-vector product
+      double** inv[2][11];
 
       mono_lu_init()
       {
         memset(mat, 0, sizeof(mat));
+        memset(inv, 0, sizeof(inv));
       }
 
       ~mono_lu_init()
       {
         for (int m = 0; m <= 1; m++)
           for (int i = 0; i <= 10; i++)
+          {
             if(mat[m][i] != NULL) {
               delete [] mat[m][i];
               delete [] perm[m][i];
             }
+            if(inv[m][i] != NULL)
+              delete [] inv[m][i];
+          }
       }
     }
     mono_lu;
@@ -398,6 +435,28 @@ namespace Hermes
       return mat;
     }
 
+    template<typename Scalar>
+    double** Solution<Scalar>::get_mono_inverse(int o)
+    {
+      if(mono_lu.inv[this->mode][o] == NULL)
+      {
+        if(mono_lu.mat[this->mode][o] == NULL)
+          mono_lu.mat[this->mode][o] = calc_mono_matrix(o, mono_lu.perm[this->mode][o]);
+
+        // Columns of the inverse from the LU decomposition, stored as rows.
+        int n = this->mode ? sqr(o + 1) : (o + 1)*(o + 2)/2;
+        double** inv_transposed = new_matrix<double>(n, n);
+        for (int i = 0; i < n; i++)
+        {
+          inv_transposed[i][i] = 1.0;
+          lubksb(mono_lu.mat[this->mode][o], n, mono_lu.perm[this->mode][o], inv_transposed[i]);
+        }
+        transpose(inv_transposed, n, n);
+        mono_lu.inv[this->mode][o] = inv_transposed;
+      }
+      return mono_lu.inv[this->mode][o];
+    }
+
     template<typename Scalar>
     void Solution<Scalar>::set_coeff_vector(const Space<Scalar>* space, const Vector<Scalar>* vec,
         bool add_dir_lift, int start_index)
@@ -474,9 +533,12 @@ namespace Hermes
         memset(elem_coeffs[l], 0, sizeof(int) * num_elems);
       }
 
-      // Obtain element orders, allocate mono_coeffs.
+      // Obtain element orders, lay out mono_coeffs (each element has its components one after another),
+      // prepare the inverse monomial matrices of all the orders used.
       Element* e;
       num_coeffs = 0;
+      int max_np = 0;
+      Hermes::vector<Element*> elements;
       for_all_active_elements(e, this->mesh)
       {
         this->mode = e->get_mode();
@@ -491,55 +553,103 @@ namespace Hermes
         // Hcurl and Hdiv: actual order of functions is one higher than element order
         if((space->shapeset)->get_num_components() == 2) o++;
 
-        num_coeffs += this->mode ? sqr(o + 1) : (o + 1)*(o + 2)/2;
+        int np = this->mode ? sqr(o + 1) : (o + 1)*(o + 2)/2;
+        for (int l = 0; l < this->num_components; l++)
+          elem_coeffs[l][e->id] = num_coeffs + l * np;
+        num_coeffs += this->num_components * np;
+        max_np = std::max(max_np, np);
         elem_orders[e->id] = o;
+        elements.push_back(e);
+        get_mono_inverse(o);
       }
-      num_coeffs *= this->num_components;
       if(mono_coeffs != NULL)
         delete [] mono_coeffs;
       mono_coeffs = new Scalar[num_coeffs];
 
       // Express the solution on elements as a linear combination of monomials.
+      // The elements are independent, each thread has its own precalculated shapeset.
       Quad2D* quad = &g_quad_2d_cheb;
-      pss->set_quad_2d(quad);
-      Scalar* mono = mono_coeffs;
-      for_all_active_elements(e, this->mesh)
+      int num_elements = elements.size();
+      int num_threads_used = std::max(1, std::min((int)Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads), num_elements));
+      Hermes::Exceptions::Exception* caught_exception = NULL;
+      int element_i;
+#pragma omp parallel shared(elements, caught_exception) private(element_i) num_threads(num_threads_used)
       {
-        this->mode = e->get_mode();
-        o = elem_orders[e->id];
-        int np = quad->get_num_points(o, e->get_mode());
+        PrecalcShapeset* thread_pss = omp_get_thread_num() == 0 ? pss : new PrecalcShapeset(pss->shapeset);
+        thread_pss->set_quad_2d(quad);
+        Scalar* val = new Scalar[max_np];
 
-        AsmList<Scalar> al;
-        space->get_element_assembly_list(e, &al);
-        pss->set_active_element(e);
-
-        for (int l = 0; l < this->num_components; l++)
+#pragma omp for schedule(dynamic, 64)
+        for(element_i = 0; element_i < num_elements; element_i++)
         {
-          // Obtain solution values for the current element.
-          Scalar* val = mono;
-          elem_coeffs[l][e->id] = (int) (mono - mono_coeffs);
-          memset(val, 0, sizeof(Scalar)*np);
-          for (unsigned int k = 0; k < al.cnt; k++)
+          if(caught_exception != NULL)
+            continue;
+
+          try
           {
-            pss->set_active_shape(al.idx[k]);
-            pss->set_quad_order(o, H2D_FN_VAL);
-            int dof = al.dof[k];
-            double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
-            // By subtracting space->first_dof we make sure that it does not matter where the
-            // enumeration of dofs in the space starts. This ca be either zero or there can be some
-            // offset. By adding start_index we move to the desired section of coeff_vec.
-            Scalar coef = al.coef[k] * (dof >= 0 ? coeff_vec[dof  - space->first_dof + start_index] : dir_lift_coeff);
-            double* shape = pss->get_fn_values(l);
-            for (int i = 0; i < np; i++)
-              val[i] += shape[i] * coef;
-          }
-          mono += np;
+            Element* e = elements[element_i];
+            int o = elem_orders[e->id];
+            int np = quad->get_num_points(o, e->get_mode());
+            double** inv = mono_lu.inv[e->get_mode()][o];
 
-          // solve for the monomial coefficients
-          if(mono_lu.mat[this->mode][o] == NULL)
-            mono_lu.mat[this->mode][o] = calc_mono_matrix(o, mono_lu.perm[this->mode][o]);
-          lubksb(mono_lu.mat[this->mode][o], np, mono_lu.perm[this->mode][o], val);
+            AsmList<Scalar> al;
+            space->get_element_assembly_list(e, &al);
+            thread_pss->set_active_element(e);
+
+            for (int l = 0; l < this->num_components; l++)
+            {
+              // Obtain solution values for the current element.
+              memset(val, 0, sizeof(Scalar)*np);
+              for (unsigned int k = 0; k < al.cnt; k++)
+              {
+                thread_pss->set_active_shape(al.idx[k]);
+                thread_pss->set_quad_order(o, H2D_FN_VAL);
+                int dof = al.dof[k];
+                double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
+                // By subtracting space->first_dof we make sure that it does not matter where the
+                // enumeration of dofs in the space starts. This ca be either zero or there can be some
+                // offset. By adding start_index we move to the desired section of coeff_vec.
+                Scalar coef = al.coef[k] * (dof >= 0 ? coeff_vec[dof  - space->first_dof + start_index] : dir_lift_coeff);
+                double* shape = thread_pss->get_fn_values(l);
+                for (int i = 0; i < np; i++)
+                  val[i] += shape[i] * coef;
+              }
+
+              // the monomial coefficients
+              Scalar* mono = mono_coeffs + elem_coeffs[l][e->id];
+              for (int i = 0; i < np; i++)
+              {
+                Scalar sum = 0.0;
+                for (int j = 0; j < np; j++)
+                  sum += inv[i][j] * val[j];
+                mono[i] = sum;
+              }
+            }
+          }
+          catch(Hermes::Exceptions::Exception& exception)
+          {
+#pragma omp critical (set_coeff_vector_caught_exception)
+            if(caught_exception == NULL)
+              caught_exception = exception.clone();
+          }
+          catch(std::exception& exception)
+          {
+#pragma omp critical (set_coeff_vector_caught_exception)
+            if(caught_exception == NULL)
+              caught_exception = new Hermes::Exceptions::Exception(exception.what());
+          }
         }
+
+        delete [] val;
+        if(thread_pss != pss)
+          delete thread_pss;
+      }
+
+      if(caught_exception != NULL)
+      {
+        Hermes::Exceptions::Exception exception(*caught_exception);
+        delete caught_exception;
+        throw exception;
       }
 
       if(this->mesh == NULL) throw Hermes::Exceptions::Exception("mesh == NULL.\n");
@@ -1343,6 +1453,12 @@ namespace Hermes
     template<>
     void Solution<double>::load(const char* filename, Space<double>* space)
     {
+      if(BinaryReader::is_binary_file(filename, H2D_SOLUTION_BINARY_MAGIC))
+      {
+        this->load_binary(filename, space);
+        return;
+      }
+
       free();
       this->mesh = space->get_mesh();
       this->space_type = space->get_type();
@@ -1441,6 +1557,12 @@ namespace Hermes
     template<>
     void Solution<std::complex<double> >::load(const char* filename, Space<std::complex<double> >* space)
     {
+      if(BinaryReader::is_binary_file(filename, H2D_SOLUTION_BINARY_MAGIC))
+      {
+        this->load_binary(filename, space);
+        return;
+      }
+
       free();
       sln_type = HERMES_SLN;
       this->mesh = space->get_mesh();
@@ -1543,6 +1665,113 @@ namespace Hermes
       return;
     }
 
+    template<typename Scalar>
+    void Solution<Scalar>::save_binary(const char* filename, bool compress) const
+    {
+      if(sln_type == HERMES_UNDEF)
+        throw Exceptions::Exception("Cannot save -- uninitialized solution.");
+      if(sln_type != HERMES_SLN)
+        throw Hermes::Exceptions::SolutionSaveFailureException("Only solutions coming from computation can be saved in the binary format.");
+
+      try
+      {
+        BinaryWriter writer(filename, H2D_SOLUTION_BINARY_MAGIC, H2D_SOLUTION_BINARY_VERSION, compress);
+
+        int sizes[6] = { this->space_type, this->num_components, this->num_elems, this->num_coeffs, this->num_dofs, (int)sizeof(Scalar) };
+        writer.write_ints(sizes, 6);
+        writer.write_section(this->mono_coeffs, sizeof(Scalar), this->num_coeffs);
+        writer.write_ints(this->elem_orders, this->num_elems);
+        for (int component_i = 0; component_i < this->num_components; component_i++)
+          writer.write_ints(this->elem_coeffs[component_i], this->num_elems);
+
+        writer.close();
+      }
+      catch(Hermes::Exceptions::Exception& e)
+      {
+        throw Hermes::Exceptions::SolutionSaveFailureException("%s", e.what());
+      }
+    }
+
+    template<typename Scalar>
+    bool Solution<Scalar>::is_binary_file(const char* filename)
+    {
+      return BinaryReader::is_binary_file(filename, H2D_SOLUTION_BINARY_MAGIC);
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::load_binary(const char* filename, Space<Scalar>* space, bool memory_map)
+    {
+      free();
+      this->mesh = space->get_mesh();
+      this->space_type = space->get_type();
+
+      try
+      {
+        BinaryReader reader(filename, H2D_SOLUTION_BINARY_MAGIC, H2D_SOLUTION_BINARY_VERSION, memory_map);
+
+        int sizes[6];
+        reader.read_ints(sizes, 6);
+        if(sizes[0] != this->space_type)
+          throw Exceptions::Exception("Space types not compliant in Solution::load_binary().");
+        if(sizes[5] != (int)sizeof(Scalar))
+          throw Exceptions::Exception("Mismatched real - complex solutions.");
+        if(sizes[1] < 1 || sizes[1] > H2D_MAX_SOLUTION_COMPONENTS)
+          throw Exceptions::Exception("Wrong number of components in Solution::load_binary().");
+
+        this->num_components = sizes[1];
+        this->num_elems = sizes[2];
+        this->num_coeffs = sizes[3];
+        this->num_dofs = sizes[4];
+        this->sln_type = HERMES_SLN;
+
+        if(reader.next_section_count(sizeof(Scalar)) != this->num_coeffs)
+          throw Exceptions::Exception("Wrong number of coefficients in Solution::load_binary().");
+
+        if(reader.is_mapped() && !reader.is_compressed())
+        {
+          // All sections are raw, use them in place. The members are set only after all sections were found,
+          // so that free() does not get pointers into a mapping it does not own.
+          Scalar* mapped_mono_coeffs = (Scalar*)reader.map_section();
+          int* mapped_elem_coeffs[H2D_MAX_SOLUTION_COMPONENTS];
+          if(reader.next_section_count(sizeof(int)) != this->num_elems)
+            throw Exceptions::Exception("Wrong number of elements in Solution::load_binary().");
+          int* mapped_elem_orders = (int*)reader.map_section();
+          for (int component_i = 0; component_i < this->num_components; component_i++)
+          {
+            if(reader.next_section_count(sizeof(int)) != this->num_elems)
+              throw Exceptions::Exception("Wrong number of elements in Solution::load_binary().");
+            mapped_elem_coeffs[component_i] = (int*)reader.map_section();
+          }
+
+          this->mapping = reader.release_mapping();
+          this->mono_coeffs = mapped_mono_coeffs;
+          this->elem_orders = mapped_elem_orders;
+          for (int component_i = 0; component_i < this->num_components; component_i++)
+            this->elem_coeffs[component_i] = mapped_elem_coeffs[component_i];
+        }
+        else
+        {
+          this->mono_coeffs = new Scalar[this->num_coeffs];
+          reader.read_section(this->mono_coeffs);
+          this->elem_orders = new int[this->num_elems];
+          reader.read_ints(this->elem_orders, this->num_elems);
+          for (int component_i = 0; component_i < this->num_components; component_i++)
+          {
+            this->elem_coeffs[component_i] = new int[this->num_elems];
+            reader.read_ints(this->elem_coeffs[component_i], this->num_elems);
+          }
+        }
+
+        init_dxdy_buffer();
+      }
+      catch(Hermes::Exceptions::Exception& e)
+      {
+        free();
+        this->sln_type = HERMES_UNDEF;
+        throw Hermes::Exceptions::SolutionLoadFailureException("%s", e.what());
+      }
+    }
+
     template<typename Scalar>
     Scalar Solution<Scalar>::get_ref_value(Element* e, double xi1, double xi2, int component, int item)
     {
@@ -1696,10 +1925,9 @@ namespace Hermes
     {
       double xi1, xi2;
 
-      Func<Scalar>* toReturn = new Func<Scalar>(1, this->num_components);
-
       if(sln_type == HERMES_EXACT)
       {
+        Func<Scalar>* toReturn = new Func<Scalar>(1, this->num_components);
         if(this->num_components == 1)
         {
           Scalar val, dx = 0.0, dy = 0.0;
@@ -1749,61 +1977,86 @@ namespace Hermes
           RefMap::untransform(e, x, y, xi1, xi2);
 
         if(e != NULL)
-        {
-          if(this->num_components == 1)
-          {
-            toReturn->val = new Scalar[1];
-            toReturn->dx = new Scalar[1];
-            toReturn->dy = new Scalar[1];
-
-            toReturn->val[0] = get_ref_value(e, xi1, xi2, 0, 0);
-
-            double2x2 m;
-            double xx, yy;
-            this->refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, m);
-            Scalar dx = get_ref_value(e, xi1, xi2, 0, 1);
-            Scalar dy = get_ref_value(e, xi1, xi2, 0, 2);
-            toReturn->dx[0] = m[0][0]*dx + m[0][1]*dy;
-            toReturn->dy[0] = m[1][0]*dx + m[1][1]*dy;
-    
-#ifdef H2D_USE_SECOND_DERIVATIVES
-            toReturn->laplace = new Scalar[1];
-            double2x2 mat;
-            double3x2 mat2;
-
-            this->refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, mat);
-            this->refmap->second_ref_map_at_point(xi1, xi2, xx, yy, mat2);
-
-            Scalar vxx = get_ref_value(e, xi1, xi2, 0, 3);
-            Scalar vyy = get_ref_value(e, xi1, xi2, 0, 4);
-            Scalar vxy = get_ref_value(e, xi1, xi2, 0, 5);
-            Scalar dxx = sqr(mat[0][0])*vxx + 2*mat[0][1]*mat[0][0]*vxy + sqr(mat[0][1])*vyy + mat2[0][0]*dx + mat2[0][1]*dy;   // dxx
-            Scalar dyy = sqr(mat[1][0])*vxx + 2*mat[1][1]*mat[1][0]*vxy + sqr(mat[1][1])*vyy + mat2[2][0]*dx + mat2[2][1]*dy;   // dyy
-            toReturn->laplace[0] = dxx + dyy;
-#endif
-          }
-          else // vector solution
-          {
-            toReturn->val0 = new Scalar[1];
-            toReturn->val1 = new Scalar[1];
-
-            double2x2 m;
-            double xx, yy;
-            this->refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, m);
-            Scalar vx = get_ref_value(e, xi1, xi2, 0, 0);
-            Scalar vy = get_ref_value(e, xi1, xi2, 1, 0);
-            toReturn->val0[0] = m[0][0]*vx + m[0][1]*vy;
-            toReturn->val1[0] = m[1][0]*vx + m[1][1]*vy;
-            Hermes::Mixins::Loggable::Static::warn("Derivatives of vector functions not implemented yet.");
-          }
-          return toReturn;
-        }
+          return this->get_ref_pt_value(e, xi1, xi2);
 
         this->warn("Point (%g, %g) does not lie in any element.", x, y);
         return NULL;
       }
     }
 
+    template<typename Scalar>
+    Func<Scalar>* Solution<Scalar>::get_ref_pt_value(Element* e, double xi1, double xi2)
+    {
+      Func<Scalar>* toReturn = new Func<Scalar>(1, this->num_components);
+
+      if(this->num_components == 1)
+      {
+        toReturn->val = new Scalar[1];
+        toReturn->dx = new Scalar[1];
+        toReturn->dy = new Scalar[1];
+
+        toReturn->val[0] = get_ref_value(e, xi1, xi2, 0, 0);
+
+        double2x2 m;
+        double xx, yy;
+        this->refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, m);
+        Scalar dx = get_ref_value(e, xi1, xi2, 0, 1);
+        Scalar dy = get_ref_value(e, xi1, xi2, 0, 2);
+        toReturn->dx[0] = m[0][0]*dx + m[0][1]*dy;
+        toReturn->dy[0] = m[1][0]*dx + m[1][1]*dy;
+
+#ifdef H2D_USE_SECOND_DERIVATIVES
+        toReturn->laplace = new Scalar[1];
+        double2x2 mat;
+        double3x2 mat2;
+
+        this->refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, mat);
+        this->refmap->second_ref_map_at_point(xi1, xi2, xx, yy, mat2);
+
+        Scalar vxx = get_ref_value(e, xi1, xi2, 0, 3);
+        Scalar vyy = get_ref_value(e, xi1, xi2, 0, 4);
+        Scalar vxy = get_ref_value(e, xi1, xi2, 0, 5);
+        Scalar dxx = sqr(mat[0][0])*vxx + 2*mat[0][1]*mat[0][0]*vxy + sqr(mat[0][1])*vyy + mat2[0][0]*dx + mat2[0][1]*dy;   // dxx
+        Scalar dyy = sqr(mat[1][0])*vxx + 2*mat[1][1]*mat[1][0]*vxy + sqr(mat[1][1])*vyy + mat2[2][0]*dx + mat2[2][1]*dy;   // dyy
+        toReturn->laplace[0] = dxx + dyy;
+#endif
+      }
+      else // vector solution
+      {
+        toReturn->val0 = new Scalar[1];
+        toReturn->val1 = new Scalar[1];
+
+        double2x2 m;
+        double xx, yy;
+        this->refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, m);
+        Scalar vx = get_ref_value(e, xi1, xi2, 0, 0);
+        Scalar vy = get_ref_value(e, xi1, xi2, 1, 0);
+        toReturn->val0[0] = m[0][0]*vx + m[0][1]*vy;
+        toReturn->val1[0] = m[1][0]*vx + m[1][1]*vy;
+        Hermes::Mixins::Loggable::Static::warn("Derivatives of vector functions not implemented yet.");
+      }
+      return toReturn;
+    }
+
+    template<typename Scalar>
+    Func<Scalar>** Solution<Scalar>::get_pt_values(double* x, double* y, int n)
+    {
+      if(sln_type != HERMES_SLN)
+        return MeshFunction<Scalar>::get_pt_values(x, y, n);
+
+      Func<Scalar>** values = new Func<Scalar>*[n];
+      Element* e = NULL;
+      for (int i = 0; i < n; i++)
+      {
+        // The reference coordinates come from the element search, no further inversion of the reference map.
+        double xi1, xi2;
+        if(e == NULL || !RefMap::is_element_on_physical_coordinates(e, x[i], y[i], &xi1, &xi2))
+          e = RefMap::element_on_physical_coordinates(this->mesh, x[i], y[i], &xi1, &xi2);
+        values[i] = e == NULL ? NULL : this->get_ref_pt_value(e, xi1, xi2);
+      }
+      return values;
+    }
+
     template class HERMES_API Solution<double>;
     template class HERMES_API Solution<std::complex<double> >;
   }
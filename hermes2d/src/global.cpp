@@ -23,6 +23,7 @@
 #include "quadrature/limit_order.h"
 #include "integrals/h1.h"
 #include "discrete_problem.h"
+#include "api2d.h"
 
 namespace Hermes
 {
@@ -43,48 +44,187 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    double Global<Scalar>::calc_abs_error(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, int norm_type)
+    MeshFunction<Scalar>*** Global<Scalar>::clone_for_threads(MeshFunction<Scalar>** fns, int num_fns, int& num_threads)
     {
-      // sanity checks
-      if(sln1 == NULL) throw Hermes::Exceptions::Exception("sln1 is NULL in calc_abs_error().");
-      if(sln2 == NULL) throw Hermes::Exceptions::Exception("sln2 is NULL in calc_abs_error().");
+      if(num_threads < 1)
+        num_threads = 1;
+
+      MeshFunction<Scalar>*** clones = new MeshFunction<Scalar>**[num_threads];
+      for(int i = 0; i < num_threads; i++)
+      {
+        clones[i] = new MeshFunction<Scalar>*[num_fns];
+        memset(clones[i], 0, num_fns * sizeof(MeshFunction<Scalar>*));
+      }
+      for(int j = 0; j < num_fns; j++)
+        clones[0][j] = fns[j];
 
-      Quad2D* quad = &g_quad_2d_std;
-      sln1->set_quad_2d(quad);
-      sln2->set_quad_2d(quad);
+      try
+      {
+        for(int i = 1; i < num_threads; i++)
+          for(int j = 0; j < num_fns; j++)
+          {
+            clones[i][j] = fns[j]->clone();
+            clones[i][j]->set_quad_2d(fns[j]->get_quad_2d());
+          }
+      }
+      catch(Hermes::Exceptions::Exception&)
+      {
+        // Not clonable, fall back to the serial evaluation.
+        free_thread_clones(clones, num_fns, num_threads);
+        num_threads = 1;
+        clones = new MeshFunction<Scalar>**[1];
+        clones[0] = new MeshFunction<Scalar>*[num_fns];
+        for(int j = 0; j < num_fns; j++)
+          clones[0][j] = fns[j];
+      }
+
+      return clones;
+    }
+
+    template<typename Scalar>
+    void Global<Scalar>::free_thread_clones(MeshFunction<Scalar>*** clones, int num_fns, int num_threads)
+    {
+      for(int i = 0; i < num_threads; i++)
+      {
+        if(i > 0)
+          for(int j = 0; j < num_fns; j++)
+            delete clones[i][j];
+        delete [] clones[i];
+      }
+      delete [] clones;
+    }
+
+    template<typename Scalar>
+    double Global<Scalar>::calc_squared_integral(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, int norm_type)
+    {
+      int num_fns = (sln2 == NULL) ? 1 : 2;
+      MeshFunction<Scalar>* fns[2] = { sln1, sln2 };
+
+      Hermes::vector<const Mesh*> meshes;
+      for(int j = 0; j < num_fns; j++)
+      {
+        fns[j]->set_quad_2d(&g_quad_2d_std);
+        meshes.push_back(fns[j]->get_mesh());
+      }
 
-      const Mesh* meshes[2] = { sln1->get_mesh(), sln2->get_mesh() };
-      Transformable* tr[2] = { sln1, sln2 };
-      Traverse trav(true);
-      trav.begin(2, meshes, tr);
+      int num_states;
+      Traverse trav_master(true);
+      Traverse::State* states = trav_master.get_states(meshes, num_states);
 
-      double error = 0.0;
-      Traverse::State* ee;
-      while ((ee = trav.get_next_state()) != NULL)
+      int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
+      MeshFunction<Scalar>*** clones = clone_for_threads(fns, num_fns, num_threads_used);
+      Transformable*** trfs = new Transformable**[num_threads_used];
+      for(int i = 0; i < num_threads_used; i++)
       {
-        update_limit_table(ee->e[0]->get_mode());
+        trfs[i] = new Transformable*[num_fns];
+        for(int j = 0; j < num_fns; j++)
+          trfs[i][j] = clones[i][j];
+      }
+
+      double* state_values = new double[num_states > 0 ? num_states : 1];
+      Hermes::Exceptions::Exception* caughtException = NULL;
 
-        RefMap* ru = sln1->get_refmap();
-        RefMap* rv = sln2->get_refmap();
-        switch (norm_type)
+      int state_i;
+#pragma omp parallel shared(states, clones, trfs, state_values) private(state_i) num_threads(num_threads_used)
+      {
+#pragma omp for schedule(dynamic, 1)
+        for(state_i = 0; state_i < num_states; state_i++)
         {
-        case HERMES_L2_NORM:
-          error += error_fn_l2(sln1, sln2, ru, rv);
-          break;
-        case HERMES_H1_NORM:
-          error += error_fn_h1(sln1, sln2, ru, rv);
-          break;
-        case HERMES_HCURL_NORM:
-          error += error_fn_hc(sln1, sln2, ru, rv);
-          break;
-        case HERMES_HDIV_NORM:
-          error += error_fn_hdiv(sln1, sln2, ru, rv);
-          break;
-        default: throw Hermes::Exceptions::Exception("Unknown norm in calc_error().");
+          if(caughtException != NULL)
+            continue;
+
+          try
+          {
+            Traverse::set_state_transforms(states + state_i, trfs[omp_get_thread_num()]);
+            MeshFunction<Scalar>* u = clones[omp_get_thread_num()][0];
+            RefMap* ru = u->get_refmap();
+
+            if(num_fns == 1)
+            {
+              switch (norm_type)
+              {
+              case HERMES_L2_NORM:
+                state_values[state_i] = norm_fn_l2(u, ru);
+                break;
+              case HERMES_H1_NORM:
+                state_values[state_i] = norm_fn_h1(u, ru);
+                break;
+              case HERMES_HCURL_NORM:
+                state_values[state_i] = norm_fn_hc(u, ru);
+                break;
+              case HERMES_HDIV_NORM:
+                state_values[state_i] = norm_fn_hdiv(u, ru);
+                break;
+              default: throw Hermes::Exceptions::Exception("Unknown norm in calc_norm().");
+              }
+            }
+            else
+            {
+              MeshFunction<Scalar>* v = clones[omp_get_thread_num()][1];
+              RefMap* rv = v->get_refmap();
+              switch (norm_type)
+              {
+              case HERMES_L2_NORM:
+                state_values[state_i] = error_fn_l2(u, v, ru, rv);
+                break;
+              case HERMES_H1_NORM:
+                state_values[state_i] = error_fn_h1(u, v, ru, rv);
+                break;
+              case HERMES_HCURL_NORM:
+                state_values[state_i] = error_fn_hc(u, v, ru, rv);
+                break;
+              case HERMES_HDIV_NORM:
+                state_values[state_i] = error_fn_hdiv(u, v, ru, rv);
+                break;
+              default: throw Hermes::Exceptions::Exception("Unknown norm in calc_error().");
+              }
+            }
+          }
+          catch(Hermes::Exceptions::Exception& e)
+          {
+#pragma omp critical (global_caught_exception)
+            if(caughtException == NULL)
+              caughtException = e.clone();
+          }
+          catch(std::exception& e)
+          {
+#pragma omp critical (global_caught_exception)
+            if(caughtException == NULL)
+              caughtException = new Hermes::Exceptions::Exception(e.what());
+          }
         }
       }
-      trav.finish();
-      return sqrt(error);
+
+      double result = 0.0;
+      if(caughtException == NULL)
+        for(state_i = 0; state_i < num_states; state_i++)
+          result += state_values[state_i];
+
+      for(int i = 0; i < num_threads_used; i++)
+        delete [] trfs[i];
+      delete [] trfs;
+      free_thread_clones(clones, num_fns, num_threads_used);
+      delete [] state_values;
+      delete [] states;
+
+      if(caughtException != NULL)
+      {
+        Hermes::Exceptions::Exception exception(*caughtException);
+        delete caughtException;
+        throw exception;
+      }
+
+      return result;
+    }
+
+    template<typename Scalar>
+    double Global<Scalar>::calc_abs_error(MeshFunction<Scalar>* sln1, MeshFunction<Scalar>* sln2, int norm_type)
+    {
+      // sanity checks
+      if(sln1 == NULL) throw Hermes::Exceptions::Exception("sln1 is NULL in calc_abs_error().");
+      if(sln2 == NULL) throw Hermes::Exceptions::Exception("sln2 is NULL in calc_abs_error().");
+
+      return sqrt(calc_squared_integral(sln1, sln2, norm_type));
     }
 
     template<typename Scalar>
@@ -99,39 +239,9 @@ namespace Hermes
     template<typename Scalar>
     double Global<Scalar>::calc_norm(MeshFunction<Scalar>* sln, int norm_type)
     {
-      Quad2D* quad = &g_quad_2d_std;
-      sln->set_quad_2d(quad);
-
-      double norm = 0.0;
-      Element* e;
-      const Mesh* mesh = sln->get_mesh();
+      if(sln == NULL) throw Hermes::Exceptions::Exception("sln is NULL in calc_norm().");
 
-      for_all_active_elements(e, mesh)
-      {
-        // set maximum integration order for use in integrals, see limit_order()
-        update_limit_table(e->get_mode());
-
-        sln->set_active_element(e);
-        RefMap* ru = sln->get_refmap();
-
-        switch (norm_type)
-        {
-        case HERMES_L2_NORM:
-          norm += norm_fn_l2(sln, ru);
-          break;
-        case HERMES_H1_NORM:
-          norm += norm_fn_h1(sln, ru);
-          break;
-        case HERMES_HCURL_NORM:
-          norm += norm_fn_hc(sln, ru);
-          break;
-        case HERMES_HDIV_NORM:
-          norm += norm_fn_hdiv(sln, ru);
-          break;
-        default: throw Hermes::Exceptions::Exception("Unknown norm in calc_norm().");
-        }
-      }
-      return sqrt(norm);
+      return sqrt(calc_squared_integral(sln, NULL, norm_type));
     }
 
     template<typename Scalar>
@@ -22,6 +22,13 @@
 #include "mesh.h"
 #include "quad_all.h"
 #include "matrix.h"
+#include "api2d.h"
+#ifdef WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 
 using namespace Hermes::Algebra::DenseMatrixOperations;
 namespace Hermes
@@ -41,6 +48,11 @@ namespace Hermes
 
     Trf CurvMap::ctm;
 
+    /// Version of the stored projection matrices, increase whenever the file layout or the
+    /// calculation of the matrices changes.
+    static const int H2D_CURV_MAP_TABLES_VERSION = 1;
+    static const char H2D_CURV_MAP_TABLES_MAGIC[8] = "H2DCURV";
+
     static double lambda_0(double x, double y)
     {
       return -0.5 * (x + y);
@@ -386,6 +398,75 @@ namespace Hermes
 
     //// projection based interpolation ////////////////////////////////////////////////////////////////
 
+    static std::string curv_map_tables_filename(const char* name)
+    {
+      std::string dir = Hermes2DApi.get_text_param_value(precalculatedFormsDirPath);
+      if(dir.empty())
+        return dir;
+      if(dir[dir.length() - 1] != '/' && dir[dir.length() - 1] != '\\')
+        dir += '/';
+      return dir + "curv_map_" + name + ".h2d";
+    }
+
+    bool CurvMap::load_cholesky_projection_matrix(const char* name, int shapeset_id, int order, int n, double** mat, double* p)
+    {
+      std::string filename = curv_map_tables_filename(name);
+      if(filename.empty())
+        return false;
+
+      FILE* f = fopen(filename.c_str(), "rb");
+      if(f == NULL)
+        return false;
+
+      char magic[8];
+      int header[4];
+      bool ok = fread(magic, sizeof(char), 8, f) == 8 && memcmp(magic, H2D_CURV_MAP_TABLES_MAGIC, 8) == 0
+        && fread(header, sizeof(int), 4, f) == 4
+        && header[0] == H2D_CURV_MAP_TABLES_VERSION && header[1] == shapeset_id && header[2] == order && header[3] == n
+        // new_matrix() stores the rows contiguously.
+        && fread(mat[0], sizeof(double), n * n, f) == (size_t)(n * n)
+        && fread(p, sizeof(double), n, f) == (size_t)n;
+
+      fclose(f);
+      return ok;
+    }
+
+    void CurvMap::save_cholesky_projection_matrix(const char* name, int shapeset_id, int order, int n, double** mat, double* p)
+    {
+      if(!Hermes2DApi.get_integral_param_value(storePrecalculatedForms))
+        return;
+
+      std::string filename = curv_map_tables_filename(name);
+      if(filename.empty())
+        return;
+
+      // Write to a temporary file first, so that concurrently running processes never read a partial file.
+      // The name is unique per process (pid) and per call within the process (counter).
+      static int tmp_counter = 0;
+      int tmp_id;
+#pragma omp critical (curv_map_tmp_counter)
+      tmp_id = tmp_counter++;
+      std::stringstream ss;
+      ss << filename << "." << getpid() << "." << tmp_id << ".tmp";
+      std::string tmp_filename = ss.str();
+
+      FILE* f = fopen(tmp_filename.c_str(), "wb");
+      if(f == NULL)
+        return;
+
+      int header[4] = { H2D_CURV_MAP_TABLES_VERSION, shapeset_id, order, n };
+      bool ok = fwrite(H2D_CURV_MAP_TABLES_MAGIC, sizeof(char), 8, f) == 8
+        && fwrite(header, sizeof(int), 4, f) == 4
+        && fwrite(mat[0], sizeof(double), n * n, f) == (size_t)(n * n)
+        && fwrite(p, sizeof(double), n, f) == (size_t)n;
+
+      if(fclose(f) != 0)
+        ok = false;
+
+      if(!ok || rename(tmp_filename.c_str(), filename.c_str()) != 0)
+        remove(tmp_filename.c_str());
+    }
+
     // preparation of projection matrices, Cholesky factorization
     void CurvMap::precalculate_cholesky_projection_matrix_edge(H1ShapesetJacobi* ref_map_shapeset, PrecalcShapeset* ref_map_pss)
     {
@@ -394,6 +475,11 @@ namespace Hermes
 
       if(!edge_proj_matrix)
         edge_proj_matrix = new_matrix<double>(n, n);
+      if(!edge_p)
+        edge_p = new double[n];
+
+      if(load_cholesky_projection_matrix("edge", ref_map_shapeset->get_id(), order, n, edge_proj_matrix, edge_p))
+        return;
 
       // calculate projection matrix of maximum order
       for (int i = 0; i < n; i++)
@@ -493,9 +579,9 @@ namespace Hermes
       }
 
       // Cholesky factorization of the matrix
-      if(!edge_p)
-        edge_p = new double[n];
       choldc(edge_proj_matrix, n, edge_p);
+
+      save_cholesky_projection_matrix("edge", ref_map_shapeset->get_id(), order, n, edge_proj_matrix, edge_p);
     }
 
     // calculate the H1 seminorm products (\phi_i, \phi_j) for all 0 <= i, j < n, n is the number of bubble functions
@@ -540,12 +626,19 @@ namespace Hermes
       if(ref_map_pss->get_active_element()->get_mode() == HERMES_MODE_TRIANGLE)
       {
         int nb = ref_map_shapeset->get_num_bubbles(order, HERMES_MODE_TRIANGLE);
-        int* indices = ref_map_shapeset->get_bubble_indices(order, HERMES_MODE_TRIANGLE);
-        bubble_proj_matrix_tri = calculate_bubble_projection_matrix(nb, indices, ref_map_shapeset, ref_map_pss, HERMES_MODE_TRIANGLE);
-
-        // cholesky factorization of the matrix
+        bubble_proj_matrix_tri = new_matrix<double>(nb, nb);
         bubble_tri_p = new double[nb];
-        choldc(bubble_proj_matrix_tri, nb, bubble_tri_p);
+        if(!load_cholesky_projection_matrix("bubble_tri", ref_map_shapeset->get_id(), order, nb, bubble_proj_matrix_tri, bubble_tri_p))
+        {
+          delete [] bubble_proj_matrix_tri;
+          int* indices = ref_map_shapeset->get_bubble_indices(order, HERMES_MODE_TRIANGLE);
+          bubble_proj_matrix_tri = calculate_bubble_projection_matrix(nb, indices, ref_map_shapeset, ref_map_pss, HERMES_MODE_TRIANGLE);
+
+          // cholesky factorization of the matrix
+          choldc(bubble_proj_matrix_tri, nb, bubble_tri_p);
+
+          save_cholesky_projection_matrix("bubble_tri", ref_map_shapeset->get_id(), order, nb, bubble_proj_matrix_tri, bubble_tri_p);
+        }
       }
 
       // *** quads ***
@@ -555,13 +648,19 @@ namespace Hermes
       {
         order = H2D_MAKE_QUAD_ORDER(order, order);
         int nb = ref_map_shapeset->get_num_bubbles(order, HERMES_MODE_QUAD);
-        int *indices = ref_map_shapeset->get_bubble_indices(order, HERMES_MODE_QUAD);
+        bubble_proj_matrix_quad = new_matrix<double>(nb, nb);
+        bubble_quad_p = new double[nb];
+        if(!load_cholesky_projection_matrix("bubble_quad", ref_map_shapeset->get_id(), order, nb, bubble_proj_matrix_quad, bubble_quad_p))
+        {
+          delete [] bubble_proj_matrix_quad;
+          int *indices = ref_map_shapeset->get_bubble_indices(order, HERMES_MODE_QUAD);
+          bubble_proj_matrix_quad = calculate_bubble_projection_matrix(nb, indices, ref_map_shapeset, ref_map_pss, HERMES_MODE_QUAD);
 
-        bubble_proj_matrix_quad = calculate_bubble_projection_matrix(nb, indices, ref_map_shapeset, ref_map_pss, HERMES_MODE_QUAD);
+          // cholesky factorization of the matrix
+          choldc(bubble_proj_matrix_quad, nb, bubble_quad_p);
 
-        // cholesky factorization of the matrix
-        bubble_quad_p = new double[nb];
-        choldc(bubble_proj_matrix_quad, nb, bubble_quad_p);
+          save_cholesky_projection_matrix("bubble_quad", ref_map_shapeset->get_id(), order, nb, bubble_proj_matrix_quad, bubble_quad_p);
+        }
       }
     }
 
@@ -0,0 +1,146 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "element_index.h"
+#include "mesh.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Bounding box of the element, enlarged for curved elements.
+    static void get_element_bounding_box(Element* e, double& x_min, double& y_min, double& x_max, double& y_max)
+    {
+      x_min = x_max = e->vn[0]->x;
+      y_min = y_max = e->vn[0]->y;
+      for (unsigned int i = 1; i < e->get_nvert(); i++)
+      {
+        x_min = std::min(x_min, e->vn[i]->x);
+        x_max = std::max(x_max, e->vn[i]->x);
+        y_min = std::min(y_min, e->vn[i]->y);
+        y_max = std::max(y_max, e->vn[i]->y);
+      }
+
+      // A curved edge (circular arc of at most 180 degrees) deviates from its chord by at most half of the chord length.
+      if(e->is_curved())
+      {
+        double margin = 0.5 * std::max(x_max - x_min, y_max - y_min);
+        x_min -= margin;
+        x_max += margin;
+        y_min -= margin;
+        y_max += margin;
+      }
+    }
+
+    ElementIndex::ElementIndex(const Mesh* mesh) : mesh_seq(mesh->get_seq()), curved_elements(false), nx(1), ny(1), cell_starts(NULL), cell_elements(NULL)
+    {
+      Element* e;
+
+      // Bounding box of the mesh.
+      bool first = true;
+      int num_elements = 0;
+      x_min = y_min = x_max = y_max = 0.0;
+      for_all_active_elements(e, mesh)
+      {
+        double e_x_min, e_y_min, e_x_max, e_y_max;
+        get_element_bounding_box(e, e_x_min, e_y_min, e_x_max, e_y_max);
+        if(first)
+        {
+          x_min = e_x_min;
+          y_min = e_y_min;
+          x_max = e_x_max;
+          y_max = e_y_max;
+          first = false;
+        }
+        else
+        {
+          x_min = std::min(x_min, e_x_min);
+          y_min = std::min(y_min, e_y_min);
+          x_max = std::max(x_max, e_x_max);
+          y_max = std::max(y_max, e_y_max);
+        }
+        if(e->is_curved())
+          curved_elements = true;
+        num_elements++;
+      }
+
+      // Roughly one element per cell, with cells as square as possible.
+      double width = std::max(x_max - x_min, 1e-12 * (1.0 + std::abs(x_min)));
+      double height = std::max(y_max - y_min, 1e-12 * (1.0 + std::abs(y_min)));
+      double cell_size = std::sqrt(width * height / std::max(num_elements, 1));
+      nx = std::max(1, std::min((int) std::ceil(width / cell_size), 4 * num_elements + 1));
+      ny = std::max(1, std::min((int) std::ceil(height / cell_size), 4 * num_elements + 1));
+      inv_cell_width = nx / width;
+      inv_cell_height = ny / height;
+
+      // Count the elements of every cell, then fill them in.
+      cell_starts = new int[nx * ny + 1];
+      memset(cell_starts, 0, (nx * ny + 1) * sizeof(int));
+      for (int pass = 0; pass < 2; pass++)
+      {
+        int* fill = NULL;
+        if(pass == 1)
+        {
+          for (int cell_i = 0; cell_i < nx * ny; cell_i++)
+            cell_starts[cell_i + 1] += cell_starts[cell_i];
+          cell_elements = new Element*[std::max(cell_starts[nx * ny], 1)];
+          fill = new int[nx * ny];
+          memcpy(fill, cell_starts, nx * ny * sizeof(int));
+        }
+
+        for_all_active_elements(e, mesh)
+        {
+          double e_x_min, e_y_min, e_x_max, e_y_max;
+          get_element_bounding_box(e, e_x_min, e_y_min, e_x_max, e_y_max);
+          int i_first, i_last, j_first, j_last;
+          get_cell_range(e_x_min, e_x_max, x_min, inv_cell_width, nx, i_first, i_last);
+          get_cell_range(e_y_min, e_y_max, y_min, inv_cell_height, ny, j_first, j_last);
+          for (int j = j_first; j <= j_last; j++)
+            for (int i = i_first; i <= i_last; i++)
+              if(pass == 0)
+                cell_starts[j * nx + i + 1]++;
+              else
+                cell_elements[fill[j * nx + i]++] = e;
+        }
+
+        delete [] fill;
+      }
+    }
+
+    ElementIndex::~ElementIndex()
+    {
+      delete [] cell_starts;
+      delete [] cell_elements;
+    }
+
+    void ElementIndex::get_cell_range(double min, double max, double origin, double inv_size, int n, int& first, int& last) const
+    {
+      first = std::max(0, std::min(n - 1, (int) std::floor((min - origin) * inv_size)));
+      last = std::max(0, std::min(n - 1, (int) std::floor((max - origin) * inv_size)));
+    }
+
+    Element** ElementIndex::get_candidates(double x, double y, int& count) const
+    {
+      count = 0;
+      if(x < x_min || x > x_max || y < y_min || y > y_max)
+        return NULL;
+
+      int i = std::min(nx - 1, (int) ((x - x_min) * inv_cell_width));
+      int j = std::min(ny - 1, (int) ((y - y_min) * inv_cell_height));
+      count = cell_starts[j * nx + i + 1] - cell_starts[j * nx + i];
+      return cell_elements + cell_starts[j * nx + i];
+    }
+  }
+}
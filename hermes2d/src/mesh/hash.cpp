@@ -24,6 +24,7 @@ namespace Hermes
     HashTable::HashTable()
     {
       v_table = NULL; e_table = NULL;
+      v_count = e_count = num_resizes = 0;
     }
 
     HashTable::~HashTable()
@@ -44,6 +45,74 @@ namespace Hermes
 
       memset(v_table, 0, size * sizeof(Node*));
       memset(e_table, 0, size * sizeof(Node*));
+
+      v_count = e_count = num_resizes = 0;
+    }
+
+    void HashTable::rehash_table(Node** table, int old_size, Node** new_table)
+    {
+      for (int i = 0; i < old_size; i++)
+      {
+        Node* node = table[i];
+        while (node != NULL)
+        {
+          Node* next = node->next_hash;
+          int idx = hash(node->p1, node->p2);
+          node->next_hash = new_table[idx];
+          new_table[idx] = node;
+          node = next;
+        }
+      }
+    }
+
+    void HashTable::grow()
+    {
+      int old_size = mask + 1;
+      int size = 2 * old_size;
+      mask = size - 1;
+
+      Node** new_v_table = new Node*[size];
+      Node** new_e_table = new Node*[size];
+      memset(new_v_table, 0, size * sizeof(Node*));
+      memset(new_e_table, 0, size * sizeof(Node*));
+
+      rehash_table(v_table, old_size, new_v_table);
+      rehash_table(e_table, old_size, new_e_table);
+
+      delete [] v_table;
+      delete [] e_table;
+      v_table = new_v_table;
+      e_table = new_e_table;
+      num_resizes++;
+    }
+
+    HashTable::HashTableStatistics HashTable::get_statistics(Node** table, int count) const
+    {
+      HashTableStatistics statistics;
+      statistics.size = table == NULL ? 0 : mask + 1;
+      statistics.num_nodes = count;
+      statistics.load_factor = statistics.size == 0 ? 0.0 : count / (double)statistics.size;
+      statistics.max_chain_length = 0;
+      statistics.num_resizes = num_resizes;
+      for (int i = 0; i < statistics.size; i++)
+      {
+        int length = 0;
+        for (Node* node = table[i]; node != NULL; node = node->next_hash)
+          length++;
+        if(length > statistics.max_chain_length)
+          statistics.max_chain_length = length;
+      }
+      return statistics;
+    }
+
+    HashTable::HashTableStatistics HashTable::get_vertex_statistics() const
+    {
+      return get_statistics(v_table, v_count);
+    }
+
+    HashTable::HashTableStatistics HashTable::get_edge_statistics() const
+    {
+      return get_statistics(e_table, e_count);
     }
 
     void HashTable::copy_list(Node** ptr, Node* node)
@@ -79,6 +148,9 @@ namespace Hermes
       free();
       nodes.copy(ht->nodes);
       mask = ht->mask;
+      v_count = ht->v_count;
+      e_count = ht->e_count;
+      num_resizes = 0;
 
       v_table = new Node*[mask + 1];
       e_table = new Node*[mask + 1];
@@ -93,6 +165,7 @@ namespace Hermes
     {
       memset(v_table, 0, (mask + 1) * sizeof(Node*));
       memset(e_table, 0, (mask + 1) * sizeof(Node*));
+      v_count = e_count = 0;
 
       Node* node;
       for_all_nodes(node, this)
@@ -105,13 +178,18 @@ namespace Hermes
         {
           node->next_hash = v_table[idx];
           v_table[idx] = node;
+          v_count++;
         }
         else
         {
           node->next_hash = e_table[idx];
           e_table[idx] = node;
+          e_count++;
         }
       }
+
+      while (v_count > mask + 1 || e_count > mask + 1)
+        grow();
     }
 
     void HashTable::free()
@@ -165,6 +243,8 @@ namespace Hermes
       // insert into hashtable
       newnode->next_hash = v_table[i];
       v_table[i] = newnode;
+      if(++v_count > mask + 1)
+        grow();
 
       return newnode;
     }
@@ -192,6 +272,8 @@ namespace Hermes
       // insert into hashtable
       newnode->next_hash = e_table[i];
       e_table[i] = newnode;
+      if(++e_count > mask + 1)
+        grow();
 
       return newnode;
     }
@@ -219,6 +301,7 @@ namespace Hermes
         if(node->id == id)
         {
           *ptr = node->next_hash;
+          v_count--;
           break;
         }
         ptr = &node->next_hash;
@@ -240,6 +323,7 @@ namespace Hermes
         if(node->id == id)
         {
           *ptr = node->next_hash;
+          e_count--;
           break;
         }
         ptr = &node->next_hash;
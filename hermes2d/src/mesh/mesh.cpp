@@ -15,6 +15,7 @@
 
 #include "mesh.h"
 #include "refmap.h"
+#include "element_index.h"
 #include <algorithm>
 #include "global.h"
 #include "api2d.h"
@@ -247,11 +248,13 @@ namespace Hermes
     }
 
     unsigned g_mesh_seq = 0;
+    static unsigned g_mesh_elements_seq = 0;
 
-    Mesh::Mesh() : HashTable()
+    Mesh::Mesh() : HashTable(), element_index(NULL)
     {
       nbase = nactive = ntopvert = ninitial = 0;
       seq = g_mesh_seq++;
+      elements_seq = g_mesh_elements_seq++;
     }
 
     Mesh::~Mesh() 
@@ -272,10 +275,16 @@ namespace Hermes
       return okay;
     }
 
-    Mesh::ReferenceMeshCreator::ReferenceMeshCreator(Mesh* coarse_mesh, int refinement) : coarse_mesh(coarse_mesh), refinement(refinement)
+    Mesh::ReferenceMeshCreator::ReferenceMeshCreator(Mesh* coarse_mesh, int refinement) : coarse_mesh(coarse_mesh), refinement(refinement),
+      ref_mesh(NULL), ref_mesh_seq(0), ref_base(0), ref_next_id(0)
     {
     }
 
+    Mesh::ReferenceMeshCreator::~ReferenceMeshCreator()
+    {
+      delete this->ref_mesh;
+    }
+
     Mesh* Mesh::ReferenceMeshCreator::create_ref_mesh()
     {
       Mesh* ref_mesh = new Mesh;
@@ -284,6 +293,214 @@ namespace Hermes
       return ref_mesh;
     }
 
+    /// Refinement of an inactive element in the sense of Mesh::refine_element(), -1 if the sons are not of the type of the element.
+    static int get_son_refinement(Element* e)
+    {
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+        if(e->sons[i] != NULL && e->sons[i]->is_triangle() != e->is_triangle())
+          return -1;
+      if(e->is_triangle() || (e->sons[0] != NULL && e->sons[2] != NULL))
+        return 0;
+      return e->sons[0] != NULL ? 1 : 2;
+    }
+
+    Mesh* Mesh::ReferenceMeshCreator::update_ref_mesh()
+    {
+      bool updated = false;
+      if(this->ref_mesh == NULL)
+        this->ref_mesh = new Mesh;
+      else if(this->ref_mesh->get_seq() == this->ref_mesh_seq && this->refinement >= 0 && this->refinement <= 2 && this->base_unchanged())
+      {
+        // All the mismatching subtrees are removed first, so that an id the coarse mesh freed
+        // and reused elsewhere is free in the reference mesh as well before it is taken again.
+        updated = true;
+        Element* e;
+        for_all_base_elements(e, this->coarse_mesh)
+          if(!this->collapse_changed(e, this->ref_mesh->get_element_fast(e->id)))
+          {
+            updated = false;
+            break;
+          }
+        if(updated)
+          for_all_base_elements(e, this->coarse_mesh)
+            this->refine_changed(e, this->ref_mesh->get_element_fast(e->id));
+      }
+
+      if(!updated)
+        this->build_ref_mesh();
+
+      // The history of refinements reproduces the mesh, not the ids of the reference elements.
+      this->ref_mesh->refinements = this->coarse_mesh->refinements;
+      if(this->refinement != -1)
+      {
+        Element* e;
+        for_all_active_elements(e, this->coarse_mesh)
+          this->ref_mesh->refinements.push_back(std::pair<unsigned int, int>(e->id, this->refinement));
+      }
+      this->ref_mesh->ninitial = this->coarse_mesh->get_max_element_id();
+      this->ref_mesh_seq = this->ref_mesh->get_seq();
+      return this->ref_mesh;
+    }
+
+    void Mesh::ReferenceMeshCreator::build_ref_mesh()
+    {
+      this->ref_mesh->copy(this->coarse_mesh);
+
+      // Twice the current range, so that the coarse mesh can grow for a few adaptivity steps before a rebuild is needed.
+      this->ref_base = std::max(2 * this->coarse_mesh->get_max_element_id(), 1024);
+      this->ref_next_id = this->ref_base;
+      this->ref_free_ids.clear();
+
+      if(this->refinement != -1)
+      {
+        Hermes::vector<int> active_ids;
+        Element* e;
+        for_all_active_elements(e, this->ref_mesh)
+          active_ids.push_back(e->id);
+        for (unsigned int i = 0; i < active_ids.size(); i++)
+          this->refine_ref_layer(this->ref_mesh->get_element_fast(active_ids[i]));
+      }
+
+      this->ref_mesh->seq = g_mesh_seq++;
+    }
+
+    bool Mesh::ReferenceMeshCreator::base_unchanged()
+    {
+      if(this->coarse_mesh->get_max_element_id() > this->ref_base)
+        return false;
+      if(this->coarse_mesh->nbase != this->ref_mesh->nbase || this->coarse_mesh->ntopvert != this->ref_mesh->ntopvert)
+        return false;
+
+      for (int i = 0; i < this->coarse_mesh->nbase; i++)
+      {
+        Element* coarse_e = this->coarse_mesh->get_element_fast(i);
+        Element* ref_e = this->ref_mesh->get_element_fast(i);
+        if(coarse_e->used != ref_e->used)
+          return false;
+        if(!coarse_e->used)
+          continue;
+        if(coarse_e->get_nvert() != ref_e->get_nvert() || coarse_e->marker != ref_e->marker || coarse_e->is_curved() != ref_e->is_curved())
+          return false;
+        for (unsigned int j = 0; j < coarse_e->get_nvert(); j++)
+        {
+          if(coarse_e->vn[j]->id != ref_e->vn[j]->id || coarse_e->vn[j]->x != ref_e->vn[j]->x || coarse_e->vn[j]->y != ref_e->vn[j]->y)
+            return false;
+          if(this->coarse_mesh->get_base_edge_node(coarse_e, j)->marker != this->ref_mesh->get_base_edge_node(ref_e, j)->marker)
+            return false;
+        }
+      }
+      return true;
+    }
+
+    bool Mesh::ReferenceMeshCreator::collapse_changed(Element* coarse_e, Element* ref_e)
+    {
+      if(ref_e->active)
+        return true;
+
+      bool keep;
+      if(coarse_e->active)
+      {
+        // Only the reference refinement may be under ref_e.
+        keep = get_son_refinement(ref_e) == (ref_e->is_triangle() ? 0 : this->refinement);
+        for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+          if(ref_e->sons[i] != NULL && (ref_e->sons[i]->id < this->ref_base || !ref_e->sons[i]->active))
+            keep = false;
+        if(!keep)
+          this->collapse(ref_e);
+        return true;
+      }
+
+      int coarse_refinement = get_son_refinement(coarse_e);
+      if(coarse_refinement == -1)
+        return false;
+
+      keep = get_son_refinement(ref_e) == coarse_refinement;
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS && keep; i++)
+        if((coarse_e->sons[i] == NULL) != (ref_e->sons[i] == NULL) || (coarse_e->sons[i] != NULL && coarse_e->sons[i]->id != ref_e->sons[i]->id))
+          keep = false;
+      if(!keep)
+      {
+        this->collapse(ref_e);
+        return true;
+      }
+
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+        if(coarse_e->sons[i] != NULL && !this->collapse_changed(coarse_e->sons[i], ref_e->sons[i]))
+          return false;
+      return true;
+    }
+
+    void Mesh::ReferenceMeshCreator::refine_changed(Element* coarse_e, Element* ref_e)
+    {
+      if(coarse_e->active)
+      {
+        if(ref_e->active)
+          this->refine_ref_layer(ref_e);
+        return;
+      }
+
+      if(ref_e->active)
+      {
+        int son_ids[H2D_MAX_ELEMENT_SONS];
+        int count = 0;
+        for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+          if(coarse_e->sons[i] != NULL)
+            son_ids[count++] = coarse_e->sons[i]->id;
+        this->refine_with_ids(ref_e, get_son_refinement(coarse_e), son_ids, count);
+      }
+
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+        if(coarse_e->sons[i] != NULL)
+          this->refine_changed(coarse_e->sons[i], ref_e->sons[i]);
+    }
+
+    void Mesh::ReferenceMeshCreator::collapse(Element* ref_e)
+    {
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+        if(ref_e->sons[i] != NULL && !ref_e->sons[i]->active)
+          this->collapse(ref_e->sons[i]);
+
+      // The son pointers are gone after the unrefinement.
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+        if(ref_e->sons[i] != NULL && ref_e->sons[i]->id >= this->ref_base)
+          this->ref_free_ids.push_back(ref_e->sons[i]->id);
+
+      this->ref_mesh->unrefine_element_internal(ref_e);
+      this->ref_mesh->seq = g_mesh_seq++;
+    }
+
+    void Mesh::ReferenceMeshCreator::refine_ref_layer(Element* ref_e)
+    {
+      int son_ids[H2D_MAX_ELEMENT_SONS];
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+      {
+        if(this->ref_free_ids.empty())
+          son_ids[i] = this->ref_next_id++;
+        else
+        {
+          son_ids[i] = this->ref_free_ids.back();
+          this->ref_free_ids.pop_back();
+        }
+      }
+      this->refine_with_ids(ref_e, this->refinement, son_ids, H2D_MAX_ELEMENT_SONS);
+    }
+
+    void Mesh::ReferenceMeshCreator::refine_with_ids(Element* ref_e, int refinement, const int* son_ids, int count)
+    {
+      for (int i = count - 1; i >= 0; i--)
+        this->ref_mesh->forced_element_ids.push_back(son_ids[i]);
+
+      this->ref_mesh->refine_element(ref_e, refinement);
+
+      // Ids not used by refinements with less sons.
+      while(!this->ref_mesh->forced_element_ids.empty())
+      {
+        if(this->ref_mesh->forced_element_ids.back() >= this->ref_base)
+          this->ref_free_ids.push_back(this->ref_mesh->forced_element_ids.back());
+        this->ref_mesh->forced_element_ids.pop_back();
+      }
+    }
+
     void Mesh::initial_single_check()
     {
       RefMap r;
@@ -498,6 +715,24 @@ namespace Hermes
       this->seq = seq;
     }
 
+    unsigned Mesh::get_elements_seq() const
+    {
+      return elements_seq;
+    }
+
+    const ElementIndex* Mesh::get_element_index() const
+    {
+#pragma omp critical (mesh_element_index)
+      {
+        if(this->element_index == NULL || this->element_index->get_mesh_seq() != this->seq)
+        {
+          delete this->element_index;
+          this->element_index = new ElementIndex(this);
+        }
+      }
+      return this->element_index;
+    }
+
     Element* Mesh::get_element_fast(int id) const
     {
       return &(elements[id]);
@@ -529,10 +764,19 @@ namespace Hermes
       return 2;
     }
 
+    Element* Mesh::add_element()
+    {
+      if(this->forced_element_ids.empty())
+        return elements.add();
+      int id = this->forced_element_ids.back();
+      this->forced_element_ids.pop_back();
+      return elements.add_at(id);
+    }
+
     Element* Mesh::create_triangle(int marker, Node* v0, Node* v1, Node* v2, CurvMap* cm, int id)
     {
       // create a new element
-      Element* e = elements.add();
+      Element* e = add_element();
 
       if(id != -1)
         e->id = id;
@@ -567,7 +811,7 @@ namespace Hermes
       CurvMap* cm, int id)
     {
       // create a new element
-      Element* e = elements.add();
+      Element* e = add_element();
 
       if(id != -1)
         e->id = id;
@@ -1489,6 +1733,9 @@ namespace Hermes
       this->element_markers_conversion.conversion_table_inverse.clear();
       this->refinements.clear();
       this->seq = -1;
+      this->elements_seq = g_mesh_elements_seq++;
+      delete this->element_index;
+      this->element_index = NULL;
     }
 
     void Mesh::copy_converted(Mesh* mesh)
@@ -0,0 +1,438 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#include "mesh.h"
+#include "mesh_reader_binary.h"
+#include "binary_io.h"
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    static const char* H2D_MESH_BINARY_MAGIC = "H2DMESH_";
+    static const unsigned int H2D_MESH_BINARY_VERSION = 1;
+
+    /// Counts in the header of the file.
+    enum MeshBinaryHeader
+    {
+      H2D_MESH_BINARY_VERTICES = 0,
+      H2D_MESH_BINARY_ELEMENTS,
+      H2D_MESH_BINARY_ELEMENT_MARKERS,
+      H2D_MESH_BINARY_BOUNDARY_MARKERS,
+      H2D_MESH_BINARY_EDGES,
+      H2D_MESH_BINARY_CURVES,
+      H2D_MESH_BINARY_CURVE_DOUBLES,
+      H2D_MESH_BINARY_REFINEMENTS,
+      H2D_MESH_BINARY_HEADER_SIZE
+    };
+
+    /// Items per element (four vertices, -1 as the fourth one of triangles, and the marker)
+    /// and per curve (end points, arc flag, degree, number of control points, knot vector length).
+    static const int H2D_MESH_BINARY_ELEMENT_ITEMS = 5;
+    static const int H2D_MESH_BINARY_CURVE_ITEMS = 6;
+
+    template<typename T>
+    static const T* section_data(const Hermes::vector<T>& v)
+    {
+      return v.empty() ? NULL : &v[0];
+    }
+
+    /// Writes the user markers for the given internal ones: pairs (internal marker, length), then all the characters.
+    static void save_markers(BinaryWriter& writer, const std::map<int, std::string>& markers)
+    {
+      Hermes::vector<int> marker_ints;
+      Hermes::vector<char> marker_chars;
+      for(std::map<int, std::string>::const_iterator it = markers.begin(); it != markers.end(); it++)
+      {
+        marker_ints.push_back(it->first);
+        marker_ints.push_back(it->second.length());
+        marker_chars.insert(marker_chars.end(), it->second.begin(), it->second.end());
+      }
+      writer.write_ints(section_data(marker_ints), marker_ints.size());
+      writer.write_section(section_data(marker_chars), sizeof(char), marker_chars.size());
+    }
+
+    MeshReaderBinary::MeshReaderBinary() : memory_map(true)
+    {
+    }
+
+    MeshReaderBinary::~MeshReaderBinary()
+    {
+    }
+
+    void MeshReaderBinary::set_memory_map(bool memory_map)
+    {
+      this->memory_map = memory_map;
+    }
+
+    bool MeshReaderBinary::is_binary_file(const char *filename)
+    {
+      return BinaryReader::is_binary_file(filename, H2D_MESH_BINARY_MAGIC);
+    }
+
+    bool MeshReaderBinary::save(const char *filename, Mesh *mesh, bool compress)
+    {
+      int header[H2D_MESH_BINARY_HEADER_SIZE];
+      memset(header, 0, sizeof(header));
+      header[H2D_MESH_BINARY_VERTICES] = mesh->ntopvert;
+      header[H2D_MESH_BINARY_ELEMENTS] = mesh->get_num_base_elements();
+
+      // vertices
+      Hermes::vector<double> vertices(2 * mesh->ntopvert);
+      for (int i = 0; i < mesh->ntopvert; i++)
+      {
+        vertices[2 * i] = mesh->nodes[i].x;
+        vertices[2 * i + 1] = mesh->nodes[i].y;
+      }
+
+      // elements, unused slots are kept so that the element ids (and the refinements) stay valid
+      Hermes::vector<int> elements(H2D_MESH_BINARY_ELEMENT_ITEMS * header[H2D_MESH_BINARY_ELEMENTS], -1);
+      std::map<int, std::string> element_markers;
+      for (int i = 0; i < header[H2D_MESH_BINARY_ELEMENTS]; i++)
+      {
+        Element* e = mesh->get_element_fast(i);
+        if(!e->used)
+          continue;
+        for (unsigned int j = 0; j < e->get_nvert(); j++)
+          elements[H2D_MESH_BINARY_ELEMENT_ITEMS * i + j] = e->vn[j]->id;
+        elements[H2D_MESH_BINARY_ELEMENT_ITEMS * i + 4] = e->marker;
+        element_markers[e->marker] = mesh->get_element_markers_conversion().get_user_marker(e->marker).marker;
+      }
+      header[H2D_MESH_BINARY_ELEMENT_MARKERS] = element_markers.size();
+
+      // boundary markers, every edge only once
+      Hermes::vector<int> edges;
+      std::map<int, std::string> boundary_markers;
+      std::set<std::pair<int, int> > edges_saved;
+      Element* e;
+      for_all_base_elements(e, mesh)
+        for (unsigned i = 0; i < e->get_nvert(); i++)
+        {
+          int marker = mesh->get_base_edge_node(e, i)->marker;
+          if(!marker)
+            continue;
+          int v1 = e->vn[i]->id, v2 = e->vn[e->next_vert(i)]->id;
+          if(!edges_saved.insert(std::pair<int, int>(std::min(v1, v2), std::max(v1, v2))).second)
+            continue;
+          edges.push_back(v1);
+          edges.push_back(v2);
+          edges.push_back(marker);
+          boundary_markers[marker] = mesh->boundary_markers_conversion.get_user_marker(marker).marker;
+        }
+      header[H2D_MESH_BINARY_BOUNDARY_MARKERS] = boundary_markers.size();
+      header[H2D_MESH_BINARY_EDGES] = edges.size() / 3;
+
+      // curved edges, the control points and knot vectors are stored as they are
+      Hermes::vector<int> curve_ints;
+      Hermes::vector<double> curve_doubles;
+      for_all_base_elements(e, mesh)
+        if(e->is_curved())
+          for (unsigned i = 0; i < e->get_nvert(); i++)
+            if(e->cm->nurbs[i] != NULL && !is_twin_nurbs(e, i))
+            {
+              Nurbs* nurbs = e->cm->nurbs[i];
+              curve_ints.push_back(e->vn[i]->id);
+              curve_ints.push_back(e->vn[e->next_vert(i)]->id);
+              curve_ints.push_back(nurbs->arc ? 1 : 0);
+              curve_ints.push_back(nurbs->degree);
+              curve_ints.push_back(nurbs->np);
+              curve_ints.push_back(nurbs->nk);
+              curve_doubles.push_back(nurbs->angle);
+              for (int j = 0; j < nurbs->np; j++)
+                for (int k = 0; k < 3; k++)
+                  curve_doubles.push_back(nurbs->pt[j][k]);
+              curve_doubles.insert(curve_doubles.end(), nurbs->kv, nurbs->kv + nurbs->nk);
+            }
+      header[H2D_MESH_BINARY_CURVES] = curve_ints.size() / H2D_MESH_BINARY_CURVE_ITEMS;
+      header[H2D_MESH_BINARY_CURVE_DOUBLES] = curve_doubles.size();
+
+      // refinements
+      Hermes::vector<int> refinements;
+      for(unsigned int refinement_i = 0; refinement_i < mesh->refinements.size(); refinement_i++)
+      {
+        refinements.push_back(mesh->refinements[refinement_i].first);
+        refinements.push_back(mesh->refinements[refinement_i].second);
+      }
+      header[H2D_MESH_BINARY_REFINEMENTS] = mesh->refinements.size();
+
+      BinaryWriter writer(filename, H2D_MESH_BINARY_MAGIC, H2D_MESH_BINARY_VERSION, compress);
+      writer.write_ints(header, H2D_MESH_BINARY_HEADER_SIZE);
+      writer.write_section(section_data(vertices), sizeof(double), vertices.size());
+      writer.write_ints(section_data(elements), elements.size());
+      save_markers(writer, element_markers);
+      save_markers(writer, boundary_markers);
+      writer.write_ints(section_data(edges), edges.size());
+      writer.write_ints(section_data(curve_ints), curve_ints.size());
+      writer.write_section(section_data(curve_doubles), sizeof(double), curve_doubles.size());
+      writer.write_ints(section_data(refinements), refinements.size());
+      writer.close();
+
+      return true;
+    }
+
+    template<typename T>
+    T* MeshReaderBinary::get_section(BinaryReader& reader, unsigned long long count, Hermes::vector<T>& storage, const char *filename)
+    {
+      if(reader.next_section_count(sizeof(T)) != count)
+        throw Hermes::Exceptions::MeshLoadFailureException("Corrupted mesh file %s.", filename);
+      T* data = (T*)reader.map_section();
+      if(data == NULL)
+      {
+        storage.resize(count);
+        data = storage.empty() ? NULL : &storage[0];
+        reader.read_section(data);
+      }
+      return data;
+    }
+
+    bool MeshReaderBinary::load(const char *filename, Mesh *mesh)
+    {
+      mesh->free();
+
+      try
+      {
+        // The mapping (if any) is only needed until the mesh is constructed, it is unmapped with the reader.
+        BinaryReader reader(filename, H2D_MESH_BINARY_MAGIC, H2D_MESH_BINARY_VERSION, this->memory_map);
+
+        int header[H2D_MESH_BINARY_HEADER_SIZE];
+        reader.read_ints(header, H2D_MESH_BINARY_HEADER_SIZE);
+        for (int i = 0; i < H2D_MESH_BINARY_HEADER_SIZE; i++)
+          if(header[i] < 0)
+            throw Hermes::Exceptions::MeshLoadFailureException("Corrupted mesh file %s.", filename);
+        int vertices_count = header[H2D_MESH_BINARY_VERTICES];
+        int element_count = header[H2D_MESH_BINARY_ELEMENTS];
+
+        Hermes::vector<double> vertices_storage;
+        double* vertices = get_section(reader, 2 * (unsigned long long)vertices_count, vertices_storage, filename);
+        Hermes::vector<int> elements_storage;
+        int* elements = get_section(reader, H2D_MESH_BINARY_ELEMENT_ITEMS * (unsigned long long)element_count, elements_storage, filename);
+
+        // Markers, the internal ones in the file are translated to the ones of this mesh.
+        std::map<int, int> element_markers;
+        std::map<int, int> boundary_markers;
+        for (int conversion_i = 0; conversion_i < 2; conversion_i++)
+        {
+          Mesh::MarkersConversion& conversion = conversion_i == 0 ? (Mesh::MarkersConversion&)mesh->element_markers_conversion : (Mesh::MarkersConversion&)mesh->boundary_markers_conversion;
+          std::map<int, int>& markers = conversion_i == 0 ? element_markers : boundary_markers;
+          int markers_count = header[conversion_i == 0 ? H2D_MESH_BINARY_ELEMENT_MARKERS : H2D_MESH_BINARY_BOUNDARY_MARKERS];
+
+          Hermes::vector<int> marker_ints(2 * markers_count);
+          reader.read_ints(marker_ints.empty() ? NULL : &marker_ints[0], marker_ints.size());
+          Hermes::vector<char> marker_chars;
+          char* chars = get_section(reader, reader.next_section_count(sizeof(char)), marker_chars, filename);
+
+          unsigned long long position = 0;
+          for (int i = 0; i < markers_count; i++)
+          {
+            std::string user_marker(chars + position, marker_ints[2 * i + 1]);
+            position += marker_ints[2 * i + 1];
+            conversion.insert_marker(conversion.min_marker_unused, user_marker);
+            markers[marker_ints[2 * i]] = conversion.get_internal_marker(user_marker).marker;
+          }
+        }
+
+        Hermes::vector<int> edges(3 * header[H2D_MESH_BINARY_EDGES]);
+        Hermes::vector<int> curve_ints(H2D_MESH_BINARY_CURVE_ITEMS * header[H2D_MESH_BINARY_CURVES]);
+        Hermes::vector<double> curve_doubles(header[H2D_MESH_BINARY_CURVE_DOUBLES]);
+        Hermes::vector<int> refinements(2 * header[H2D_MESH_BINARY_REFINEMENTS]);
+        reader.read_ints(edges.empty() ? NULL : &edges[0], edges.size());
+        reader.read_ints(curve_ints.empty() ? NULL : &curve_ints[0], curve_ints.size());
+        if(reader.next_section_count(sizeof(double)) != curve_doubles.size())
+          throw Hermes::Exceptions::MeshLoadFailureException("Corrupted mesh file %s.", filename);
+        reader.read_section(curve_doubles.empty() ? NULL : &curve_doubles[0]);
+        reader.read_ints(refinements.empty() ? NULL : &refinements[0], refinements.size());
+
+        // Initialize mesh, all the pages of nodes and elements are allocated at once.
+        // There are about as many edges as vertices and elements together.
+        int size = HashTable::H2D_DEFAULT_HASH_SIZE;
+        while (size < 8 * vertices_count)
+          size *= 2;
+        mesh->init(size);
+        mesh->nodes.reserve(2 * vertices_count + element_count);
+        mesh->elements.reserve(element_count);
+
+        // Create top-level vertex nodes.
+        for (int vertex_i = 0; vertex_i < vertices_count; vertex_i++)
+        {
+          Node* node = mesh->nodes.add();
+          assert(node->id == vertex_i);
+          node->ref = TOP_LEVEL_REF;
+          node->type = HERMES_TYPE_VERTEX;
+          node->bnd = 0;
+          node->p1 = node->p2 = -1;
+          node->next_hash = NULL;
+          node->x = vertices[2 * vertex_i];
+          node->y = vertices[2 * vertex_i + 1];
+        }
+        mesh->ntopvert = vertices_count;
+
+        // Elements //
+        int used_element_count = 0;
+        for (int element_i = 0; element_i < element_count; element_i++)
+        {
+          int* element = elements + H2D_MESH_BINARY_ELEMENT_ITEMS * element_i;
+          if(element[0] == -1)
+          {
+            mesh->elements.skip_slot();
+            continue;
+          }
+
+          int nvert = element[3] == -1 ? 3 : 4;
+          for (int j = 0; j < nvert; j++)
+            if(element[j] < 0 || element[j] >= vertices_count)
+              throw Hermes::Exceptions::MeshLoadFailureException("Element #%d refers to a nonexistent vertex in %s.", element_i, filename);
+          if(element_markers.find(element[4]) == element_markers.end())
+            throw Hermes::Exceptions::MeshLoadFailureException("Element #%d has an unknown marker in %s.", element_i, filename);
+          int marker = element_markers.find(element[4])->second;
+
+          if(nvert == 3)
+            mesh->create_triangle(marker, &mesh->nodes[element[0]], &mesh->nodes[element[1]], &mesh->nodes[element[2]], NULL);
+          else
+            mesh->create_quad(marker, &mesh->nodes[element[0]], &mesh->nodes[element[1]], &mesh->nodes[element[2]], &mesh->nodes[element[3]], NULL);
+          used_element_count++;
+        }
+        mesh->nbase = element_count;
+        mesh->nactive = mesh->ninitial = used_element_count;
+
+        // Boundaries //
+        for (int edge_i = 0; edge_i < header[H2D_MESH_BINARY_EDGES]; edge_i++)
+        {
+          int v1 = edges[3 * edge_i], v2 = edges[3 * edge_i + 1];
+          if(v1 < 0 || v1 >= vertices_count || v2 < 0 || v2 >= vertices_count)
+            throw Hermes::Exceptions::MeshLoadFailureException("Boundary data #%d: edge %d-%d does not exist.", edge_i, v1, v2);
+          Node* en = mesh->peek_edge_node(v1, v2);
+          if(en == NULL)
+            throw Hermes::Exceptions::MeshLoadFailureException("Boundary data #%d: edge %d-%d does not exist.", edge_i, v1, v2);
+          if(boundary_markers.find(edges[3 * edge_i + 2]) == boundary_markers.end())
+            throw Hermes::Exceptions::MeshLoadFailureException("Boundary data #%d has an unknown marker in %s.", edge_i, filename);
+
+          int marker = boundary_markers.find(edges[3 * edge_i + 2])->second;
+          en->marker = marker;
+
+          // Negative boundary markers are reserved for the inner edges in DG.
+          if(marker > 0)
+          {
+            mesh->nodes[v1].bnd = 1;
+            mesh->nodes[v2].bnd = 1;
+            en->bnd = 1;
+          }
+        }
+
+        // check that all boundary edges have a marker assigned
+        Node* en;
+        for_all_edge_nodes(en, mesh)
+          if(en->ref < 2 && en->marker == 0)
+            this->warn("Boundary edge node does not have a boundary marker.");
+
+        // Curves //
+        unsigned int curve_doubles_position = 0;
+        for (int curves_i = 0; curves_i < header[H2D_MESH_BINARY_CURVES]; curves_i++)
+        {
+          int* curve = &curve_ints[H2D_MESH_BINARY_CURVE_ITEMS * curves_i];
+          int p1 = curve[0], p2 = curve[1];
+          if(p1 < 0 || p1 >= vertices_count || p2 < 0 || p2 >= vertices_count || curve[4] < 0 || curve[5] < 0
+            || curve_doubles_position + 1 + 3 * curve[4] + curve[5] > curve_doubles.size())
+            throw Hermes::Exceptions::MeshLoadFailureException("Curve #%d is corrupted in %s.", curves_i, filename);
+
+          Node* en = mesh->peek_edge_node(p1, p2);
+          if(en == NULL)
+            throw Hermes::Exceptions::MeshLoadFailureException("Curve #%d: edge %d-%d does not exist.", curves_i, p1, p2);
+
+          Nurbs* nurbs = new Nurbs;
+          nurbs->arc = curve[2] != 0;
+          nurbs->degree = curve[3];
+          nurbs->np = curve[4];
+          nurbs->nk = curve[5];
+          nurbs->angle = curve_doubles[curve_doubles_position++];
+          nurbs->pt = new double3[nurbs->np];
+          for (int j = 0; j < nurbs->np; j++)
+            for (int k = 0; k < 3; k++)
+              nurbs->pt[j][k] = curve_doubles[curve_doubles_position++];
+          nurbs->kv = new double[nurbs->nk];
+          for (int j = 0; j < nurbs->nk; j++)
+            nurbs->kv[j] = curve_doubles[curve_doubles_position++];
+          nurbs->ref = 0;
+
+          // assign the curve to the elements sharing the edge node
+          for (unsigned int node_i = 0; node_i < 2; node_i++)
+          {
+            Element* e = en->elem[node_i];
+            if(e == NULL) continue;
+
+            if(e->cm == NULL)
+            {
+              e->cm = new CurvMap;
+              memset(e->cm, 0, sizeof(CurvMap));
+              e->cm->toplevel = 1;
+              e->cm->order = 4;
+            }
+
+            int idx = -1;
+            for (unsigned j = 0; j < e->get_nvert(); j++)
+              if(e->en[j] == en) { idx = j; break; }
+            assert(idx >= 0);
+
+            if(e->vn[idx]->id == p1)
+            {
+              e->cm->nurbs[idx] = nurbs;
+              nurbs->ref++;
+            }
+            else
+            {
+              Nurbs* nurbs_rev = mesh->reverse_nurbs(nurbs);
+              e->cm->nurbs[idx] = nurbs_rev;
+              nurbs_rev->ref++;
+            }
+          }
+          if(!nurbs->ref) delete nurbs;
+        }
+
+        // update refmap coeffs of curvilinear elements
+        Element* e;
+        for_all_elements(e, mesh)
+          if(e->cm != NULL)
+            e->cm->update_refmap_coeffs(e);
+
+        mesh->seq = g_mesh_seq++;
+
+        // refinements.
+        for (int i = 0; i < header[H2D_MESH_BINARY_REFINEMENTS]; i++)
+        {
+          int element_id = refinements[2 * i];
+          int refinement_type = refinements[2 * i + 1];
+          if(refinement_type == -1)
+            mesh->unrefine_element_id(element_id);
+          else
+            mesh->refine_element_id(element_id, refinement_type);
+        }
+
+        mesh->initial_single_check();
+      }
+      catch(Hermes::Exceptions::MeshLoadFailureException&)
+      {
+        throw;
+      }
+      catch(Hermes::Exceptions::Exception& e)
+      {
+        throw Hermes::Exceptions::MeshLoadFailureException("%s", e.what());
+      }
+
+      return true;
+    }
+  }
+}
@@ -16,6 +16,7 @@
 #include "mesh.h"
 #include "api2d.h"
 #include "mesh_reader_h2d_xml.h"
+#include "mesh_reader_binary.h"
 #include <iostream>
 
 using namespace std;
@@ -34,6 +35,12 @@ namespace Hermes
 
     bool MeshReaderH2DXML::load(const char *filename, Mesh *mesh)
     {
+      if(MeshReaderBinary::is_binary_file(filename))
+      {
+        MeshReaderBinary reader;
+        return reader.load(filename, mesh);
+      }
+
       mesh->free();
 
       std::map<unsigned int, unsigned int> vertex_is;
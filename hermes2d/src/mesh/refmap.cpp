@@ -16,6 +16,7 @@
 #include "global.h"
 #include "mesh.h"
 #include "refmap.h"
+#include "element_index.h"
 
 namespace Hermes
 {
@@ -783,14 +784,37 @@ namespace Hermes
 
 
     Element* RefMap::element_on_physical_coordinates(const Mesh* mesh, double x, double y, double* x_reference, double* y_reference)
+    {
+      const ElementIndex* element_index = mesh->get_element_index();
+      int count;
+      Element** candidates = element_index->get_candidates(x, y, count);
+      Element* found = element_on_physical_coordinates(candidates, count, x, y, x_reference, y_reference);
+
+      // The enlarged bounding boxes of curved elements may still miss a point, search all the elements then.
+      if(found == NULL && element_index->has_curved_elements())
+      {
+        Hermes::vector<Element*> all_elements;
+        Element* e;
+        for_all_active_elements(e, mesh)
+          all_elements.push_back(e);
+        found = element_on_physical_coordinates(&all_elements.front(), all_elements.size(), x, y, x_reference, y_reference);
+      }
+
+      if(found == NULL)
+        Hermes::Mixins::Loggable::Static::warn("Point (%g, %g) does not lie in any element.", x, y);
+      return found;
+    }
+
+    Element* RefMap::element_on_physical_coordinates(Element** elements, int count, double x, double y, double* x_reference, double* y_reference)
     {
       // go through all elements
       double xi1, xi2;
       Element *e;
       // vector for curved elements that do not have the point in them when considering straight edges.
       Hermes::vector<Element*> improbable_curved_elements;
-      for_all_active_elements(e, mesh)
+      for(int element_i = 0; element_i < count; element_i++)
       {
+        e = elements[element_i];
         bool is_triangle = e->is_triangle();
         bool is_curved = e->is_curved();
 
@@ -913,7 +937,6 @@ namespace Hermes
         }
       }
 
-      Hermes::Mixins::Loggable::Static::warn("Point (%g, %g) does not lie in any element.", x, y);
       return NULL;
     }
 
@@ -515,6 +515,44 @@ namespace Hermes
       this->finish();
     }
 
+    Traverse::State* Traverse::get_states(Hermes::vector<const Mesh*> meshes, int& states_count)
+    {
+      if(!this->master)
+        throw Hermes::Exceptions::Exception("Traverse::get_states() has to be called on a master Traverse.");
+
+      Hermes::vector<State*> states;
+
+      this->begin(meshes.size(), &meshes.front());
+      State* current_state;
+      while((current_state = this->get_next_state()) != NULL)
+      {
+        State* state = new State();
+        *state = current_state;
+        states.push_back(state);
+      }
+      this->finish();
+
+      states_count = states.size();
+      State* result = new State[states_count > 0 ? states_count : 1];
+      for(int state_i = 0; state_i < states_count; state_i++)
+      {
+        result[state_i] = states[state_i];
+        delete states[state_i];
+      }
+
+      return result;
+    }
+
+    void Traverse::set_state_transforms(State* state, Transformable** fn)
+    {
+      for (int i = 0; i < state->num; i++)
+        if(state->e[i] != NULL)
+        {
+          fn[i]->set_active_element(state->e[i]);
+          fn[i]->set_transform(state->sub_idx[i]);
+        }
+    }
+
     Traverse::State* Traverse::get_next_state(int* top_by_ref, int* id_by_ref)
     {
       // Serial / parallel code.
@@ -605,14 +643,9 @@ namespace Hermes
         if(leaf)
         {
           if(fn != NULL)
-            for (i = 0; i < num; i++)
-              if(s->e[i] != NULL)
-              {
-                fn[i]->set_active_element(s->e[i]);
-                fn[i]->set_transform(s->sub_idx[i]);
-              }
-              set_boundary_info(s);
-              return s;
+            set_state_transforms(s, fn);
+          set_boundary_info(s);
+          return s;
         }
 
         // Triangle: push son states
@@ -68,6 +68,7 @@ namespace Hermes
       this->newton_tol = 1e-8;
       this->newton_max_iter = 15;
       this->residual_as_function = false;
+      this->fused_assembly = true;
       this->max_allowed_residual_norm = 1E9;
       this->min_allowed_damping_coeff = 1E-4;
       this->currentDampingCofficient = 1.0;
@@ -76,6 +77,11 @@ namespace Hermes
       this->initial_auto_damping_ratio = 1.0;
       this->sufficient_improvement_factor = 0.95;
       this->necessary_successful_steps_to_increase = 1;
+      this->max_steps_with_reused_jacobian = 0;
+      this->sufficient_improvement_factor_jacobian = 0.5;
+      this->inexact_newton = false;
+      this->initial_forcing_term = 0.5;
+      this->max_forcing_term = 0.9;
     }
 
     template<typename Scalar>
@@ -114,6 +120,56 @@ namespace Hermes
       this->min_allowed_damping_coeff = min_allowed_damping_coeff_to_set;
     }
 
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_fused_assembly(bool onOff)
+    {
+      this->fused_assembly = onOff;
+    }
+
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_max_steps_with_reused_jacobian(unsigned int steps)
+    {
+      this->max_steps_with_reused_jacobian = steps;
+    }
+
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_sufficient_improvement_factor_jacobian(double ratio)
+    {
+      if(ratio <= 0.0)
+        throw Exceptions::ValueException("ratio", ratio, 0.0);
+      this->sufficient_improvement_factor_jacobian = ratio;
+    }
+
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_inexact_newton(bool onOff, double initial_forcing_term, double max_forcing_term)
+    {
+      if(initial_forcing_term <= 0.0 || initial_forcing_term >= 1.0)
+        throw Exceptions::ValueException("initial_forcing_term", initial_forcing_term, 0.0, 1.0);
+      if(max_forcing_term <= 0.0 || max_forcing_term >= 1.0)
+        throw Exceptions::ValueException("max_forcing_term", max_forcing_term, 0.0, 1.0);
+      this->inexact_newton = onOff;
+      this->initial_forcing_term = initial_forcing_term;
+      this->max_forcing_term = max_forcing_term;
+    }
+
+    template<typename Scalar>
+    double NewtonSolver<Scalar>::calculate_forcing_term(double forcing_term, double residual_norm, double last_residual_norm) const
+    {
+      // Choice 2 of Eisenstat and Walker, gamma = 0.9, alpha = 2.
+      double ratio = residual_norm / last_residual_norm;
+      double new_forcing_term = 0.9 * ratio * ratio;
+
+      // Do not decrease the forcing term too fast if the previous one was large.
+      double safeguard = 0.9 * forcing_term * forcing_term;
+      if(safeguard > 0.1)
+        new_forcing_term = std::max(new_forcing_term, safeguard);
+
+      // Do not solve more exactly than the nonlinear tolerance requires.
+      new_forcing_term = std::max(new_forcing_term, 0.5 * this->newton_tol / residual_norm);
+
+      return std::min(new_forcing_term, this->max_forcing_term);
+    }
+
     template<typename Scalar>
     void NewtonSolver<Scalar>::set_residual_as_function()
     {
@@ -293,14 +349,33 @@ namespace Hermes
       int it = 1;
       int successfulSteps = 0;
 
+      // Jacobian reuse, the residual has to be known before deciding whether to assemble the jacobian.
+      bool jacobian_reuse = this->max_steps_with_reused_jacobian > 0;
+      bool fused_assembly = this->fused_assembly && !jacobian_reuse;
+      bool jacobian_factorized = false;
+      unsigned int steps_with_reused_jacobian = 0;
+
+      // Inexact Newton.
+      Hermes::Solvers::IterSolver<Scalar>* iter_solver = NULL;
+      double forcing_term = this->initial_forcing_term;
+      if(this->inexact_newton)
+      {
+        iter_solver = dynamic_cast<Hermes::Solvers::IterSolver<Scalar>*>(linear_solver);
+        if(iter_solver == NULL)
+          this->warn("Inexact Newton's method turned on without an iterative solver present.");
+      }
+
       this->on_initialization();
 
       while (true)
       {
         this->on_step_begin();
 
-        // Assemble just the residual vector.
-        this->dp->assemble(coeff_vec, residual);
+        // Assemble the residual vector, together with the jacobian if they are assembled in one pass.
+        if(fused_assembly)
+          this->dp->assemble(coeff_vec, jacobian, residual);
+        else
+          this->dp->assemble(coeff_vec, residual);
         if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
         {
           char* fileName = new char[this->RhsFilename.length() + 5];
@@ -322,6 +397,9 @@ namespace Hermes
         // Measure the residual norm.
         if(residual_as_function)
         {
+          if(it > 1)
+            last_residual_norm = residual_norm;
+
           // Prepare solutions for measuring residual norm.
           Hermes::vector<Solution<Scalar>*> solutions;
           Hermes::vector<bool> dir_lift_false;
@@ -335,6 +413,8 @@ namespace Hermes
 
           // Calculate the norm.
           residual_norm = Global<Scalar>::calc_norms(solutions);
+          if(it == 1)
+            last_residual_norm = residual_norm;
 
           // Clean up.
           for (unsigned int i = 0; i < static_cast<DiscreteProblem<Scalar>*>(this->dp)->get_spaces().size(); i++)
@@ -436,20 +516,39 @@ namespace Hermes
           return;
         }
 
-        // Assemble just the jacobian.
-        this->dp->assemble(coeff_vec, jacobian);
-        if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
+        // Reuse the jacobian (and its factorization) if the residual norm still decreases sufficiently.
+        if(jacobian_reuse && jacobian_factorized && steps_with_reused_jacobian < this->max_steps_with_reused_jacobian
+          && residual_norm < last_residual_norm * this->sufficient_improvement_factor_jacobian)
         {
-          char* fileName = new char[this->matrixFilename.length() + 5];
-          if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
-          else
-            sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
-          FILE* matrix_file = fopen(fileName, "w+");
+          steps_with_reused_jacobian++;
+          linear_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+          this->info("\tNewton: reusing the jacobian, step %d.", steps_with_reused_jacobian);
+        }
+        else
+        {
+          // Assemble just the jacobian (unless already done together with the residual).
+          if(!fused_assembly)
+            this->dp->assemble(coeff_vec, jacobian);
+          if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
+          {
+            char* fileName = new char[this->matrixFilename.length() + 5];
+            if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
+              sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
+            else
+              sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
+            FILE* matrix_file = fopen(fileName, "w+");
 
-          jacobian->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
-          fclose(matrix_file);
-          delete [] fileName;
+            jacobian->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
+            fclose(matrix_file);
+            delete [] fileName;
+          }
+
+          // The sparsity structure is the same within one solve(), only the first jacobian needs the reordering.
+          // The scheme is only driven here when the jacobian is reused, otherwise the one set by the user stays.
+          if(jacobian_reuse)
+            linear_solver->set_factorization_scheme(jacobian_factorized ? HERMES_REUSE_MATRIX_REORDERING : HERMES_FACTORIZE_FROM_SCRATCH);
+          jacobian_factorized = true;
+          steps_with_reused_jacobian = 0;
         }
 
         this->on_step_end();
@@ -458,6 +557,14 @@ namespace Hermes
         // equation reads J(Y^n) \deltaY^{n + 1} = -F(Y^n).
         residual->change_sign();
 
+        // Tolerance of the iterative solver relative to the current residual.
+        if(iter_solver != NULL)
+        {
+          if(it > 1)
+            forcing_term = calculate_forcing_term(forcing_term, residual_norm, last_residual_norm);
+          iter_solver->set_tolerance(forcing_term);
+        }
+
         // Solve the linear system.
         if(!linear_solver->solve())
           throw Exceptions::LinearMatrixSolverException();
@@ -578,6 +685,9 @@ namespace Hermes
         // Measure the residual norm.
         if(residual_as_function)
         {
+          if(it > 1)
+            last_residual_norm = residual_norm;
+
           // Prepare solutions for measuring residual norm.
           Hermes::vector<Solution<Scalar>* > solutions;
           Hermes::vector<bool> dir_lift_false;
@@ -590,6 +700,8 @@ namespace Hermes
 
           // Calculate the norm.
           residual_norm = Global<Scalar>::calc_norms(solutions);
+          if(it == 1)
+            last_residual_norm = residual_norm;
 
           // Clean up.
           for (unsigned int i = 0; i < static_cast<DiscreteProblem<Scalar>*>(this->dp)->get_spaces().size(); i++)
@@ -708,6 +820,7 @@ namespace Hermes
           delete linear_solver;
           // Create new matrix solver with correct matrix.
           linear_solver = create_linear_solver<Scalar>(kept_jacobian, residual);
+          set_iterative_settings();
 
           this->dp->assemble(coeff_vec, kept_jacobian);
 
@@ -782,24 +895,47 @@ namespace Hermes
     void NewtonSolver<Scalar>::set_iterative_method(const char* iterative_method_name)
     {
       NonlinearSolver<Scalar>::set_iterative_method(iterative_method_name);
-      // Set iterative method in case of iterative solver AztecOO.
-#ifdef HAVE_AZTECOO
-      dynamic_cast<Hermes::Solvers::AztecOOSolver<Scalar>*>(linear_solver)->set_solver(iterative_method_name);
-#else
-      this->warn("Trying to set iterative method without AztecOO present.");
-#endif
+      set_iterative_settings();
     }
 
     template<typename Scalar>
     void NewtonSolver<Scalar>::set_preconditioner(const char* preconditioner_name)
     {
       NonlinearSolver<Scalar>::set_preconditioner(preconditioner_name);
-      // Set preconditioner in case of iterative solver AztecOO.
+      set_iterative_settings();
+    }
+
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_iterative_settings()
+    {
+      if(this->iterative_method == NULL && this->preconditioner == NULL)
+        return;
+
+#ifdef WITH_UMFPACK
+      // Set iterative method and preconditioner in case of the in-tree iterative solver.
+      Hermes::Solvers::KrylovSolver<Scalar>* krylov_solver = dynamic_cast<Hermes::Solvers::KrylovSolver<Scalar>*>(linear_solver);
+      if(krylov_solver != NULL)
+      {
+        if(this->iterative_method != NULL)
+          krylov_solver->set_solver(this->iterative_method);
+        if(this->preconditioner != NULL)
+          krylov_solver->set_precond(this->preconditioner);
+        return;
+      }
+#endif
+      // Set iterative method and preconditioner in case of iterative solver AztecOO.
 #ifdef HAVE_AZTECOO
-      dynamic_cast<Hermes::Solvers::AztecOOSolver<Scalar> *>(linear_solver)->set_precond(preconditioner_name);
-#else
-      this->warn("Trying to set iterative method without AztecOO present.");
+      Hermes::Solvers::AztecOOSolver<Scalar>* aztec_solver = dynamic_cast<Hermes::Solvers::AztecOOSolver<Scalar>*>(linear_solver);
+      if(aztec_solver != NULL)
+      {
+        if(this->iterative_method != NULL)
+          aztec_solver->set_solver(this->iterative_method);
+        if(this->preconditioner != NULL)
+          aztec_solver->set_precond(this->preconditioner);
+        return;
+      }
 #endif
+      this->warn("Trying to set iterative method without an iterative solver present.");
     }
 
     template class HERMES_API NewtonSolver<double>;
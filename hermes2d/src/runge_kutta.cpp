@@ -25,7 +25,7 @@ namespace Hermes
     template<typename Scalar>
     RungeKutta<Scalar>::RungeKutta(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar> *> spaces, ButcherTable* bt)
       : wf(wf), bt(bt), num_stages(bt->get_size()), stage_wf_right(bt->get_size() * spaces.size()),
-      stage_wf_left(spaces.size()), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
+      stage_wf_left(spaces.size()), stage_wf_sequential(spaces.size()), sequential_stages(true), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
       freeze_jacobian(false), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
     {
       for(unsigned int i = 0; i < spaces.size(); i++)
@@ -47,6 +47,10 @@ namespace Hermes
       // Create matrix solver.
       solver = create_linear_solver(matrix_right, vector_right);
 
+      matrix_stage = create_matrix<Scalar>();
+      vector_stage = create_vector<Scalar>();
+      solver_stage = create_linear_solver(matrix_stage, vector_stage);
+
       // Vector K_vector of length num_stages * ndof. will represent
       // the 'K_i' vectors in the usual R-K notation.
       K_vector = new Scalar[num_stages * Space<Scalar>::get_num_dofs(this->spaces)];
@@ -59,12 +63,13 @@ namespace Hermes
 
       this->stage_dp_left = NULL;
       this->stage_dp_right = NULL;
+      this->stage_dp_sequential = NULL;
     }
 
     template<typename Scalar>
     RungeKutta<Scalar>::RungeKutta(const WeakForm<Scalar>* wf, const Space<Scalar>* space, ButcherTable* bt)
       : wf(wf), bt(bt), num_stages(bt->get_size()), stage_wf_right(bt->get_size() * 1),
-      stage_wf_left(1), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
+      stage_wf_left(1), stage_wf_sequential(1), sequential_stages(true), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
       freeze_jacobian(false), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
     {
       this->spaces.push_back(space);
@@ -81,6 +86,10 @@ namespace Hermes
       // Create matrix solver.
       solver = create_linear_solver(matrix_right, vector_right);
 
+      matrix_stage = create_matrix<Scalar>();
+      vector_stage = create_vector<Scalar>();
+      solver_stage = create_linear_solver(matrix_stage, vector_stage);
+
       // Vector K_vector of length num_stages * ndof. will represent
       // the 'K_i' vectors in the usual R-K notation.
       K_vector = new Scalar[num_stages * Space<Scalar>::get_num_dofs(spaces)];
@@ -93,6 +102,7 @@ namespace Hermes
 
       this->stage_dp_left = NULL;
       this->stage_dp_right = NULL;
+      this->stage_dp_sequential = NULL;
     }
 
     template<typename Scalar>
@@ -127,6 +137,8 @@ namespace Hermes
 
       if(this->stage_dp_left != NULL)
         static_cast<DiscreteProblem<Scalar>*>(this->stage_dp_left)->set_spaces(this->spaces);
+      if(this->stage_dp_sequential != NULL)
+        this->stage_dp_sequential->set_spaces(this->spaces);
     }
 
     template<typename Scalar>
@@ -157,6 +169,8 @@ namespace Hermes
 
       if(this->stage_dp_left != NULL)
         static_cast<DiscreteProblem<Scalar>*>(this->stage_dp_left)->set_space(space);
+      if(this->stage_dp_sequential != NULL)
+        this->stage_dp_sequential->set_space(space);
     }
 
     template<typename Scalar>
@@ -169,16 +183,19 @@ namespace Hermes
     void RungeKutta<Scalar>::init()
     {
       this->create_stage_wf(spaces.size(), block_diagonal_jacobian);
+      this->create_stage_wf_sequential(spaces.size());
 
       if(this->get_verbose_output())
       {
         this->stage_wf_left.set_verbose_output(true);
         this->stage_wf_right.set_verbose_output(true);
+        this->stage_wf_sequential.set_verbose_output(true);
       }
       else
       {
         this->stage_wf_left.set_verbose_output(false);
         this->stage_wf_right.set_verbose_output(false);
+        this->stage_wf_sequential.set_verbose_output(false);
       }
 
       // The tensor discrete problem is created in two parts. First, matrix_left is the Jacobian
@@ -203,6 +220,11 @@ namespace Hermes
 
       stage_dp_right->set_RK(spaces.size());
 
+      // One stage at a time: the stage vector K_i is the unknown, the previous time level solution
+      // is added to u_ext in the same way as in the coupled problem.
+      this->stage_dp_sequential = new DiscreteProblem<Scalar>(&stage_wf_sequential, spaces);
+      stage_dp_sequential->set_RK(spaces.size());
+
       // Prepare residuals of stage solutions.
       if(!residual_as_vector)
         for (unsigned int i = 0; i < num_stages; i++)
@@ -228,6 +250,12 @@ namespace Hermes
       this->block_diagonal_jacobian = true;
     }
 
+    template<typename Scalar>
+    void RungeKutta<Scalar>::set_sequential_stages(bool sequential_stages)
+    {
+      this->sequential_stages = sequential_stages;
+    }
+
     template<typename Scalar>
     void RungeKutta<Scalar>::set_freeze_jacobian()
     {
@@ -261,10 +289,15 @@ namespace Hermes
         delete stage_dp_left;
       if(stage_dp_right != NULL)
         delete stage_dp_right;
+      if(stage_dp_sequential != NULL)
+        delete stage_dp_sequential;
       delete solver;
       delete matrix_right;
       delete matrix_left;
       delete vector_right;
+      delete solver_stage;
+      delete matrix_stage;
+      delete vector_stage;
       delete [] K_vector;
       delete [] u_ext_vec;
       delete [] vector_left;
@@ -313,13 +346,20 @@ namespace Hermes
       if(this->stage_dp_left == NULL)
         this->init();
 
-      // Creates the stage weak formulation.
-      update_stage_wf(slns_time_prev);
-
       // Check whether the user provided a nonzero B2-row if he wants temporal error estimation.
       if(error_fns != Hermes::vector<Solution<Scalar>*>() && bt->is_embedded() == false)
         throw Hermes::Exceptions::Exception("rk_time_step_newton(): R-K method must be embedded if temporal error estimate is requested.");
 
+      // Lower triangular tables - the stages do not depend on the following ones.
+      if(sequential_stages && bt->is_diagonally_implicit())
+      {
+        rk_time_step_newton_sequential(slns_time_prev, slns_time_new, error_fns);
+        return;
+      }
+
+      // Creates the stage weak formulation.
+      update_stage_wf(slns_time_prev);
+
       info("\tRunge-Kutta: time step, time: %f, time step: %f", this->time, this->time_step);
 
       // Set the correct time to the essential boundary conditions.
@@ -383,17 +423,7 @@ namespace Hermes
         // Multiply the residual vector with -1 since the matrix
         // equation reads J(Y^n) \deltaY^{n + 1} = -F(Y^n).
         vector_right->change_sign();
-        if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
-        {
-          char* fileName = new char[this->RhsFilename.length() + 5];
-          if(this->RhsFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-            sprintf(fileName, "%s%i.m", this->RhsFilename.c_str(), it);
-          else
-            sprintf(fileName, "%s%i", this->RhsFilename.c_str(), it);
-          FILE* rhs_file = fopen(fileName, "w+");
-          vector_right->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
-          fclose(rhs_file);
-        }
+        output_rhs(vector_right, it);
 
         // Measure the residual norm.
         if(residual_as_vector)
@@ -439,18 +469,7 @@ namespace Hermes
           // resulting tensor Jacobian.
           matrix_right->add_sparse_to_diagonal_blocks(num_stages, matrix_left);
 
-          if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
-          {
-            char* fileName = new char[this->matrixFilename.length() + 5];
-            if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
-              sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
-            else
-              sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
-            FILE* matrix_file = fopen(fileName, "w+");
-
-            matrix_right->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
-            fclose(matrix_file);
-          }
+          output_matrix(matrix_right, it);
 
           matrix_right->finish();
         }
@@ -477,6 +496,185 @@ namespace Hermes
         throw Exceptions::ValueException("Newton iterations", it, newton_max_iter);
       }
 
+      calculate_time_level_solutions(slns_time_prev, slns_time_new, error_fns);
+
+      // Delete stage spaces.
+      for (unsigned int i = 0; i < num_stages * spaces.size(); i++)
+          delete stage_spaces_vector[i];
+
+      // Delete all residuals.
+      if(!residual_as_vector)
+        for (unsigned int i = 0; i < num_stages; i++)
+          delete residuals_vector[i];
+
+      iteration++;
+      this->tick();
+      this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::rk_time_step_newton_sequential(Hermes::vector<Solution<Scalar>*> slns_time_prev,
+                                          Hermes::vector<Solution<Scalar>*> slns_time_new,
+                                          Hermes::vector<Solution<Scalar>*> error_fns)
+    {
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
+      this->stage_dp_sequential->set_spaces(spaces);
+
+      info("\tRunge-Kutta: time step, time: %f, time step: %f, stages solved sequentially", this->time, this->time_step);
+
+      // Zero utility vectors.
+      if(start_from_zero_K_vector || !iteration)
+        memset(K_vector, 0, num_stages * ndof * sizeof(Scalar));
+      memset(u_ext_vec, 0, num_stages * ndof * sizeof(Scalar));
+
+      // Assemble the mass matrix M of size ndof times ndof.
+      stage_dp_left->assemble(matrix_left, NULL);
+
+      // Vector h\sum_{j = 1}^i a_{ij} K_j of the current stage, and M K_i.
+      Scalar* stage_u_ext = new Scalar[ndof];
+      Scalar* stage_vector_left = new Scalar[ndof];
+
+      // Residuals of the current stage if the residual is measured as solutions.
+      Hermes::vector<Solution<Scalar>*> stage_residuals;
+      if(!residual_as_vector)
+        for(unsigned int sln_i = 0; sln_i < spaces.size(); sln_i++)
+          stage_residuals.push_back(residuals_vector[sln_i]);
+
+      // The diagonal entry of the table the current factorization of matrix_stage belongs to.
+      bool factorization_valid = false;
+      double factorized_diagonal_entry = 0.0;
+
+      for (unsigned int stage_i = 0; stage_i < num_stages; stage_i++)
+      {
+        // Set the correct time to the essential boundary conditions.
+        Space<Scalar>::update_essential_bc_values(spaces_mutable, this->time + bt->get_C(stage_i)*this->time_step);
+
+        update_stage_wf_sequential(slns_time_prev, stage_i);
+
+        Scalar* stage_K = K_vector + stage_i * ndof;
+        double diagonal_entry = bt->get_A(stage_i, stage_i);
+
+        // The part of u_ext given by the previous stages: h\sum_{j = 1}^{i-1} a_{ij} K_j.
+        Scalar* stage_u_ext_known = u_ext_vec + stage_i * ndof;
+        for (unsigned int stage_j = 0; stage_j < stage_i; stage_j++)
+        {
+          double a_ij = bt->get_A(stage_i, stage_j);
+          if(a_ij == 0.0)
+            continue;
+          for (int i = 0; i < ndof; i++)
+            stage_u_ext_known[i] += this->time_step * a_ij * K_vector[stage_j * ndof + i];
+        }
+
+        // The Newton's loop for K_i.
+        double residual_norm;
+        int it = 1;
+        while (true)
+        {
+          for (int i = 0; i < ndof; i++)
+            stage_u_ext[i] = stage_u_ext_known[i] + this->time_step * diagonal_entry * stage_K[i];
+
+          // Reinitialize filters.
+          if(this->filters_to_reinit.size() > 0)
+          {
+            Solution<Scalar>::vector_to_solutions(stage_u_ext, spaces, slns_time_new);
+
+            for(unsigned int filters_i = 0; filters_i < this->filters_to_reinit.size(); filters_i++)
+              filters_to_reinit.at(filters_i)->reinit();
+          }
+
+          // Residual M K_i - F(t_i, Y_n + h\sum_{j = 1}^i a_{ij} K_j).
+          matrix_left->multiply_with_vector(stage_K, stage_vector_left);
+          bool force_diagonal_blocks = true;
+          stage_dp_sequential->assemble(stage_u_ext, NULL, vector_stage, force_diagonal_blocks);
+          vector_stage->add_vector(stage_vector_left);
+          vector_stage->change_sign();
+          output_rhs(vector_stage, it);
+
+          // Measure the residual norm.
+          if(residual_as_vector)
+            residual_norm = Global<Scalar>::get_l2_norm(vector_stage);
+          else
+          {
+            Solution<Scalar>::vector_to_solutions(vector_stage, spaces, stage_residuals, false);
+            residual_norm = Global<Scalar>::calc_norms(stage_residuals);
+          }
+
+          // Info for the user.
+          if(it == 1)
+            this->info("\tRunge-Kutta: stage %d, Newton initial residual norm: %g", stage_i, residual_norm);
+          else
+            this->info("\tRunge-Kutta: stage %d, Newton iteration %d, residual norm: %g", stage_i, it-1, residual_norm);
+
+          if(residual_norm > newton_max_allowed_residual_norm)
+          {
+            delete [] stage_u_ext;
+            delete [] stage_vector_left;
+            throw Exceptions::ValueException("residual norm", residual_norm, newton_max_allowed_residual_norm);
+          }
+
+          if((residual_norm < newton_tol || it > newton_max_iter) && it > 1)
+            break;
+
+          // The Jacobian M - h a_{ii} dF/dY. When frozen, it is also shared by the following stages
+          // with the same diagonal entry.
+          bool rhs_only = freeze_jacobian && factorization_valid && factorized_diagonal_entry == diagonal_entry;
+          if(!rhs_only)
+          {
+            stage_dp_sequential->assemble(stage_u_ext, matrix_stage, NULL, force_diagonal_blocks);
+            matrix_stage->add_sparse_to_diagonal_blocks(1, matrix_left);
+            output_matrix(matrix_stage, it);
+            matrix_stage->finish();
+            solver_stage->set_factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH);
+            factorization_valid = true;
+            factorized_diagonal_entry = diagonal_entry;
+          }
+          else
+            solver_stage->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+
+          // Solve the linear system.
+          if(!solver_stage->solve())
+          {
+            delete [] stage_u_ext;
+            delete [] stage_vector_left;
+            throw Exceptions::LinearMatrixSolverException();
+          }
+
+          // Add \deltaK_i^{n + 1} to K_i^n.
+          for (int i = 0; i < ndof; i++)
+            stage_K[i] += newton_damping_coeff * solver_stage->get_sln_vector()[i];
+
+          it++;
+        }
+
+        // If max number of iterations was exceeded, fail.
+        if(it >= newton_max_iter)
+        {
+          delete [] stage_u_ext;
+          delete [] stage_vector_left;
+          this->tick();
+          this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+          throw Exceptions::ValueException("Newton iterations", it, newton_max_iter);
+        }
+      }
+
+      delete [] stage_u_ext;
+      delete [] stage_vector_left;
+
+      calculate_time_level_solutions(slns_time_prev, slns_time_new, error_fns);
+
+      iteration++;
+      this->tick();
+      this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::calculate_time_level_solutions(Hermes::vector<Solution<Scalar>*> slns_time_prev,
+                                          Hermes::vector<Solution<Scalar>*> slns_time_new,
+                                          Hermes::vector<Solution<Scalar>*> error_fns)
+    {
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
       // Project previous time level solution on the stage space,
       // to be able to add them together. The result of the projection
       // will be stored in the vector coeff_vec.
@@ -494,17 +692,6 @@ namespace Hermes
         ogProjection.project_local(spaces, slns_time_prev, coeff_vec);
       }
 
-      if(do_global_projections)
-      {
-        OGProjection<Scalar> ogProjection;
-        ogProjection.project_global(spaces, slns_time_prev, coeff_vec);
-      }
-      else
-      {
-        LocalProjection<Scalar> ogProjection;
-        ogProjection.project_local(spaces, slns_time_prev, coeff_vec);
-      }
-
       // Calculate new time level solution in the stage space (u_{n + 1} = u_n + h \sum_{j = 1}^s b_j k_j).
       for (int i = 0; i < ndof; i++)
         for (unsigned int j = 0; j < num_stages; j++)
@@ -526,21 +713,42 @@ namespace Hermes
         Solution<Scalar>::vector_to_solutions_common_dir_lift(coeff_vec, spaces, error_fns);
       }
 
-      // Delete stage spaces.
-      for (unsigned int i = 0; i < num_stages * spaces.size(); i++)
-          delete stage_spaces_vector[i];
+      delete [] coeff_vec;
+    }
 
-      // Delete all residuals.
-      if(!residual_as_vector)
-        for (unsigned int i = 0; i < num_stages; i++)
-          delete residuals_vector[i];
+    template<typename Scalar>
+    void RungeKutta<Scalar>::output_matrix(SparseMatrix<Scalar>* matrix, int it)
+    {
+      if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
+      {
+        char* fileName = new char[this->matrixFilename.length() + 15];
+        if(this->matrixFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
+          sprintf(fileName, "%s%i.m", this->matrixFilename.c_str(), it);
+        else
+          sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
+        FILE* matrix_file = fopen(fileName, "w+");
 
-      // Clean up.
-      delete [] coeff_vec;
+        matrix->dump(matrix_file, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
+        fclose(matrix_file);
+        delete [] fileName;
+      }
+    }
 
-      iteration++;
-      this->tick();
-      this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+    template<typename Scalar>
+    void RungeKutta<Scalar>::output_rhs(Vector<Scalar>* rhs, int it)
+    {
+      if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
+      {
+        char* fileName = new char[this->RhsFilename.length() + 15];
+        if(this->RhsFormat == Hermes::Algebra::DF_MATLAB_SPARSE)
+          sprintf(fileName, "%s%i.m", this->RhsFilename.c_str(), it);
+        else
+          sprintf(fileName, "%s%i", this->RhsFilename.c_str(), it);
+        FILE* rhs_file = fopen(fileName, "w+");
+        rhs->dump(rhs_file, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
+        fclose(rhs_file);
+        delete [] fileName;
+      }
     }
 
     template<typename Scalar>
@@ -765,6 +973,77 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void RungeKutta<Scalar>::create_stage_wf_sequential(unsigned int size)
+    {
+      stage_wf_sequential.delete_all();
+
+      // The forms of the original weak formulation, the Jacobian forms are scaled
+      // by -h a_{ii} in update_stage_wf_sequential().
+      for (unsigned int m = 0; m < wf->mfvol.size(); m++)
+      {
+        MatrixFormVol<Scalar>* mfv = wf->mfvol[m]->clone();
+        mfv->u_ext_offset = 0;
+        stage_wf_sequential.add_matrix_form(mfv);
+      }
+
+      for (unsigned int m = 0; m < wf->mfsurf.size(); m++)
+      {
+        MatrixFormSurf<Scalar>* mfs = wf->mfsurf[m]->clone();
+        mfs->u_ext_offset = 0;
+        stage_wf_sequential.add_matrix_form_surf(mfs);
+      }
+
+      for (unsigned int m = 0; m < wf->vfvol.size(); m++)
+      {
+        VectorFormVol<Scalar>* vfv = wf->vfvol[m]->clone();
+        vfv->scaling_factor = -1.0;
+        vfv->u_ext_offset = 0;
+        stage_wf_sequential.add_vector_form(vfv);
+      }
+
+      for (unsigned int m = 0; m < wf->vfsurf.size(); m++)
+      {
+        VectorFormSurf<Scalar>* vfs = wf->vfsurf[m]->clone();
+        vfs->scaling_factor = -1.0;
+        vfs->u_ext_offset = 0;
+        stage_wf_sequential.add_vector_form_surf(vfs);
+      }
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::update_stage_wf_sequential(Hermes::vector<Solution<Scalar>*> slns_time_prev, unsigned int stage_i)
+    {
+      if(this->wf->global_integration_order_set)
+      {
+        this->stage_wf_left.set_global_integration_order(this->wf->global_integration_order);
+        this->stage_wf_sequential.set_global_integration_order(this->wf->global_integration_order);
+      }
+
+      // The previous time level solution is expected at the back of ext.
+      stage_wf_sequential.ext.clear();
+      for(unsigned int slns_time_prev_i = 0; slns_time_prev_i < slns_time_prev.size(); slns_time_prev_i++)
+        stage_wf_sequential.ext.push_back(slns_time_prev[slns_time_prev_i]);
+
+      double stage_time = this->time + bt->get_C(stage_i) * this->time_step;
+      double scaling_factor = -this->time_step * bt->get_A(stage_i, stage_i);
+
+      for (unsigned int m = 0; m < stage_wf_sequential.mfvol.size(); m++)
+      {
+        stage_wf_sequential.mfvol[m]->scaling_factor = scaling_factor;
+        stage_wf_sequential.mfvol[m]->set_current_stage_time(stage_time);
+      }
+      for (unsigned int m = 0; m < stage_wf_sequential.mfsurf.size(); m++)
+      {
+        stage_wf_sequential.mfsurf[m]->scaling_factor = scaling_factor;
+        stage_wf_sequential.mfsurf[m]->set_current_stage_time(stage_time);
+      }
+      for (unsigned int m = 0; m < stage_wf_sequential.vfvol.size(); m++)
+        stage_wf_sequential.vfvol[m]->set_current_stage_time(stage_time);
+      for (unsigned int m = 0; m < stage_wf_sequential.vfsurf.size(); m++)
+        stage_wf_sequential.vfsurf[m]->set_current_stage_time(stage_time);
+    }
+
     template<typename Scalar>
     void RungeKutta<Scalar>::prepare_u_ext_vec()
     {
@@ -31,6 +31,9 @@ namespace Hermes
       assert(num_components == 1 || num_components == 2);
       update_max_index();
       set_quad_2d(&g_quad_2d_std);
+      points = tensor_points = tensor_factors = NULL;
+      points_size = 0;
+      tensor_np = -1;
     }
 
     PrecalcShapeset::PrecalcShapeset(PrecalcShapeset* pss) : Function<double>()
@@ -42,6 +45,9 @@ namespace Hermes
       num_components = pss->num_components;
       update_max_index();
       set_quad_2d(&g_quad_2d_std);
+      points = tensor_points = tensor_factors = NULL;
+      points_size = 0;
+      tensor_np = -1;
     }
 
     void PrecalcShapeset::update_max_index()
@@ -111,6 +117,27 @@ namespace Hermes
       int newmask = mask | oldmask;
       Node* node = new_node(newmask, np);
 
+      // transform the integration points only once for all the tables
+      reserve_points(np);
+      double* x = points;
+      double* y = points + np;
+      for (i = 0; i < np; i++)
+      {
+        x[i] = ctm->m[0] * pt[i][0] + ctm->t[0];
+        y[i] = ctm->m[1] * pt[i][1] + ctm->t[1];
+      }
+
+      // the 1D factors of tensor-product quad functions are shared by all the shape functions on the same points
+      bool tensor = element->get_mode() == HERMES_MODE_QUAD && shapeset->quad_tensor_table != NULL && index >= 0;
+      int factors_size = 3 * (shapeset->get_max_order() + 1) * np;
+      if(tensor && (tensor_np != np || memcmp(tensor_points, points, 2 * np * sizeof(double))))
+      {
+        shapeset->get_tensor_factors(np, x, tensor_factors);
+        shapeset->get_tensor_factors(np, y, tensor_factors + factors_size);
+        memcpy(tensor_points, points, 2 * np * sizeof(double));
+        tensor_np = np;
+      }
+
       // precalculate all required tables
       for (j = 0; j < num_components; j++)
       {
@@ -120,10 +147,10 @@ namespace Hermes
           {
             if(oldmask & idx2mask[k][j])
               memcpy(node->values[j][k], cur_node->values[j][k], np * sizeof(double));
+            else if(tensor)
+              shapeset->get_tensor_values(k, index, np, tensor_factors, tensor_factors + factors_size, node->values[j][k]);
             else
-              for (i = 0; i < np; i++)
-                node->values[j][k][i] = shapeset->get_value(k, index, ctm->m[0] * pt[i][0] + ctm->t[0],
-                ctm->m[1] * pt[i][1] + ctm->t[1], j, element->get_mode());
+              shapeset->get_values(k, index, np, x, y, j, node->values[j][k], element->get_mode());
           }
         }
       }
@@ -136,6 +163,21 @@ namespace Hermes
       cur_node = node;
     }
 
+    void PrecalcShapeset::reserve_points(int np)
+    {
+      if(np <= points_size)
+        return;
+
+      delete [] points;
+      delete [] tensor_points;
+      delete [] tensor_factors;
+      points = new double[2 * np];
+      tensor_points = new double[2 * np];
+      tensor_factors = new double[2 * 3 * (shapeset->get_max_order() + 1) * np];
+      points_size = np;
+      tensor_np = -1;
+    }
+
     void PrecalcShapeset::free()
     {
       if(master_pss != NULL) return;
@@ -167,6 +209,9 @@ namespace Hermes
     PrecalcShapeset::~PrecalcShapeset()
     {
       free();
+      delete [] points;
+      delete [] tensor_points;
+      delete [] tensor_factors;
     }
 
     void PrecalcShapeset::push_transform(int son)
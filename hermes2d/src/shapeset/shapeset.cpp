@@ -165,6 +165,33 @@ namespace Hermes
       return sum;
     }
 
+    void Shapeset::get_constrained_values(int n, int index, int np, const double* x, const double* y, int component, double* result, ElementMode2D mode)
+    {
+      index = -1 - index;
+
+      int part = (unsigned) index >> 7;
+      int order = (index >> 3) & 15;
+      int edge = (index >> 1) & 3;
+      int ori = index & 1;
+
+      int i, j, nc;
+      double *comb = get_constrained_edge_combination(order, part, ori, nc, mode);
+
+      memset(result, 0, np * sizeof(double));
+      shape_fn_t* table = shape_table[n][mode][component];
+      for (i = 0; i < nc; i++)
+      {
+        shape_fn_t fn = table[get_edge_index(edge, ori, i + ebias, mode)];
+        double coef = comb[i];
+        for (j = 0; j < np; j++)
+          result[j] += coef * fn(x[j], y[j]);
+      }
+    }
+
+    Shapeset::Shapeset() : quad_tensor_table(NULL), quad_tensor_lobatto(false)
+    {
+    }
+
     Shapeset::~Shapeset() { free_constrained_edge_combinations(); }
 
     int Shapeset::get_max_order() const { return max_order; }
@@ -250,6 +277,117 @@ namespace Hermes
         return get_constrained_value(n, index, x, y, component, mode);
     }
 
+    void Shapeset::get_values(int n, int index, int np, const double* x, const double* y, int component, double* result, ElementMode2D mode)
+    {
+      if(np <= 0)
+        return;
+
+      if(index >= 0)
+      {
+        Shapeset::shape_fn_t** shape_expansion = shape_table[n][mode];
+        if(shape_expansion == NULL)
+        {
+          // Same behavior as get_value(), that also takes care of the warning.
+          double value = get_value(n, index, x[0], y[0], component, mode);
+          for (int i = 0; i < np; i++)
+            result[i] = value;
+        }
+        else
+        {
+          shape_fn_t fn = shape_expansion[component][index];
+          for (int i = 0; i < np; i++)
+            result[i] = fn(x[i], y[i]);
+        }
+      }
+      else
+        get_constrained_values(n, index, np, x, y, component, result, mode);
+    }
+
+    void Shapeset::get_tensor_factors(int np, const double* x, double* factors) const
+    {
+      assert(quad_tensor_table != NULL);
+      double p_prev2[H2D_SHAPESET_BATCH_BLOCK], p_prev[H2D_SHAPESET_BATCH_BLOCK], p[H2D_SHAPESET_BATCH_BLOCK];
+      double dp_prev[H2D_SHAPESET_BATCH_BLOCK], dp[H2D_SHAPESET_BATCH_BLOCK], ddp[H2D_SHAPESET_BATCH_BLOCK];
+
+      for (int start = 0; start < np; start += H2D_SHAPESET_BATCH_BLOCK)
+      {
+        int nb = std::min(np - start, H2D_SHAPESET_BATCH_BLOCK);
+        const double* xb = x + start;
+        int i, k;
+
+        // P_0 = 1, P_{-1} = 0
+        for (i = 0; i < nb; i++)
+        {
+          p_prev2[i] = p_prev[i] = dp_prev[i] = 0.0;
+          p[i] = 1.0;
+          dp[i] = ddp[i] = 0.0;
+        }
+
+        for (k = 0; k <= max_order; k++)
+        {
+          // k P_k = (2k-1) x P_{k-1} - (k-1) P_{k-2},  P'_k = k P_{k-1} + x P'_{k-1},  P''_k = (k+1) P'_{k-1} + x P''_{k-1}
+          if(k > 0)
+          {
+            double a = (2 * k - 1) / (double) k, b = (k - 1) / (double) k;
+            for (i = 0; i < nb; i++)
+            {
+              double p_next = a * xb[i] * p[i] - b * p_prev[i];
+              ddp[i] = (k + 1) * dp[i] + xb[i] * ddp[i];
+              dp_prev[i] = dp[i];
+              dp[i] = k * p[i] + xb[i] * dp[i];
+              p_prev2[i] = p_prev[i];
+              p_prev[i] = p[i];
+              p[i] = p_next;
+            }
+          }
+
+          double* f = factors + 3 * k * np + start;
+          double* df = f + np;
+          double* ddf = df + np;
+          if(!quad_tensor_lobatto)
+          {
+            memcpy(f, p, nb * sizeof(double));
+            memcpy(df, dp, nb * sizeof(double));
+            memcpy(ddf, ddp, nb * sizeof(double));
+          }
+          // Lobatto l0 = (1 - x) / 2, l1 = (1 + x) / 2
+          else if(k < 2)
+          {
+            double s = (k == 0) ? -0.5 : 0.5;
+            for (i = 0; i < nb; i++)
+            {
+              f[i] = 0.5 + s * xb[i];
+              df[i] = s;
+              ddf[i] = 0.0;
+            }
+          }
+          // Lobatto l_k = (P_k - P_{k-2}) / sqrt(2(2k-1)),  l_k' = sqrt((2k-1)/2) P_{k-1}
+          else
+          {
+            double c = 1.0 / std::sqrt(2.0 * (2 * k - 1)), d = std::sqrt((2 * k - 1) / 2.0);
+            for (i = 0; i < nb; i++)
+            {
+              f[i] = c * (p[i] - p_prev2[i]);
+              df[i] = d * p_prev[i];
+              ddf[i] = d * dp_prev[i];
+            }
+          }
+        }
+      }
+    }
+
+    void Shapeset::get_tensor_values(int n, int index, int np, const double* factors_x, const double* factors_y, double* result) const
+    {
+      // orders of the derivatives in x and y of the expansions FN, DX, DY, DXX, DYY, DXY
+      static const int derivatives[6][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 2, 0 }, { 0, 2 }, { 1, 1 } };
+
+      const double* fx = factors_x + (3 * quad_tensor_table[index][0] + derivatives[n][0]) * np;
+      const double* fy = factors_y + (3 * quad_tensor_table[index][1] + derivatives[n][1]) * np;
+      double sign = quad_tensor_table[index][2];
+      for (int i = 0; i < np; i++)
+        result[i] = sign * fx[i] * fy[i];
+    }
+
     double Shapeset::get_fn_value (int index, double x, double y, int component, ElementMode2D mode)  { return get_value(0, index, x, y, component, mode); }
     double Shapeset::get_dx_value (int index, double x, double y, int component, ElementMode2D mode)  { return get_value(1, index, x, y, component, mode); }
     double Shapeset::get_dy_value (int index, double x, double y, int component, ElementMode2D mode)  { return get_value(2, index, x, y, component, mode); }
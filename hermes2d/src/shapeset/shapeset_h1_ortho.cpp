@@ -17009,6 +17009,9 @@ namespace Hermes
       ebias = 2;
 
       comb_table = NULL;
+
+      quad_tensor_table = simple_quad_tensor_table;
+      quad_tensor_lobatto = true;
     }
 
     const int H1ShapesetOrtho::max_index[2] = { 77, 136 };
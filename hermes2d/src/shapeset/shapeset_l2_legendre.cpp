@@ -4016,6 +4016,32 @@ namespace Hermes
       oo(10, 0),   oo(10, 1),   oo(10, 2),   oo(10, 3),   oo(10, 4),   oo(10, 5),   oo(10, 6),   oo(10, 7),   oo(10, 8),   oo(10, 9),   oo(10, 10),
     };
 
+    /// Shape function index -> { degree of the Legendre polynomial in x, in y, sign }, see Shapeset::quad_tensor_table.
+    static int leg_quad_tensor_table[][3] =
+    {
+      { 0, 0,  1 }, { 0, 1,  1 }, { 0, 2,  1 }, { 0, 3,  1 }, { 0, 4,  1 }, { 0, 5,  1 },
+      { 0, 6,  1 }, { 0, 7,  1 }, { 0, 8,  1 }, { 0, 9,  1 }, { 0, 10,  1 }, { 1, 0,  1 },
+      { 1, 1,  1 }, { 1, 2,  1 }, { 1, 3,  1 }, { 1, 4,  1 }, { 1, 5,  1 }, { 1, 6,  1 },
+      { 1, 7,  1 }, { 1, 8,  1 }, { 1, 9,  1 }, { 1, 10,  1 }, { 2, 0,  1 }, { 2, 1,  1 },
+      { 2, 2,  1 }, { 2, 3,  1 }, { 2, 4,  1 }, { 2, 5,  1 }, { 2, 6,  1 }, { 2, 7,  1 },
+      { 2, 8,  1 }, { 2, 9,  1 }, { 2, 10,  1 }, { 3, 0,  1 }, { 3, 1,  1 }, { 3, 2,  1 },
+      { 3, 3,  1 }, { 3, 4,  1 }, { 3, 5,  1 }, { 3, 6,  1 }, { 3, 7,  1 }, { 3, 8,  1 },
+      { 3, 9,  1 }, { 3, 10,  1 }, { 4, 0,  1 }, { 4, 1,  1 }, { 4, 2,  1 }, { 4, 3,  1 },
+      { 4, 4,  1 }, { 4, 5,  1 }, { 4, 6,  1 }, { 4, 7,  1 }, { 4, 8,  1 }, { 4, 9,  1 },
+      { 4, 10,  1 }, { 5, 0,  1 }, { 5, 1,  1 }, { 5, 2,  1 }, { 5, 3,  1 }, { 5, 4,  1 },
+      { 5, 5,  1 }, { 5, 6,  1 }, { 5, 7,  1 }, { 5, 8,  1 }, { 5, 9,  1 }, { 5, 10,  1 },
+      { 6, 0,  1 }, { 6, 1,  1 }, { 6, 2,  1 }, { 6, 3,  1 }, { 6, 4,  1 }, { 6, 5,  1 },
+      { 6, 6,  1 }, { 6, 7,  1 }, { 6, 8,  1 }, { 6, 9,  1 }, { 6, 10,  1 }, { 7, 0,  1 },
+      { 7, 1,  1 }, { 7, 2,  1 }, { 7, 3,  1 }, { 7, 4,  1 }, { 7, 5,  1 }, { 7, 6,  1 },
+      { 7, 7,  1 }, { 7, 8,  1 }, { 7, 9,  1 }, { 7, 10,  1 }, { 8, 0,  1 }, { 8, 1,  1 },
+      { 8, 2,  1 }, { 8, 3,  1 }, { 8, 4,  1 }, { 8, 5,  1 }, { 8, 6,  1 }, { 8, 7,  1 },
+      { 8, 8,  1 }, { 8, 9,  1 }, { 8, 10,  1 }, { 9, 0,  1 }, { 9, 1,  1 }, { 9, 2,  1 },
+      { 9, 3,  1 }, { 9, 4,  1 }, { 9, 5,  1 }, { 9, 6,  1 }, { 9, 7,  1 }, { 9, 8,  1 },
+      { 9, 9,  1 }, { 9, 10,  1 }, { 10, 0,  1 }, { 10, 1,  1 }, { 10, 2,  1 }, { 10, 3,  1 },
+      { 10, 4,  1 }, { 10, 5,  1 }, { 10, 6,  1 }, { 10, 7,  1 }, { 10, 8,  1 }, { 10, 9,  1 },
+      { 10, 10,  1 },
+    };
+
     //// triangle legendre shapeset /////////////////////////////////////////////////////////////////
 
     static double leg_tri_l0_l0(double x, double y)
@@ -8230,6 +8256,9 @@ namespace Hermes
       ebias = 2;
 
       comb_table = NULL;
+
+      quad_tensor_table = leg_quad_tensor_table;
+      quad_tensor_lobatto = false;
     }
     
     const int L2ShapesetLegendre::max_index[2] = { 66, 120 };
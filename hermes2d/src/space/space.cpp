@@ -22,6 +22,7 @@
 #include "space_hcurl.h"
 #include "space_hdiv.h"
 #include "space_h2d_xml.h"
+#include "binary_io.h"
 #include "api2d.h"
 #include <iostream>
 
@@ -29,6 +30,10 @@ namespace Hermes
 {
   namespace Hermes2D
   {
+    /// Identification and version of the binary space format.
+    static const char* H2D_SPACE_BINARY_MAGIC = "H2DSPACE";
+    static const unsigned int H2D_SPACE_BINARY_VERSION = 1;
+
     unsigned g_space_seq = 0;
 
 		template<>
@@ -615,10 +620,16 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    Space<Scalar>::ReferenceSpaceCreator::ReferenceSpaceCreator(const Space<Scalar>* coarse_space, const Mesh* ref_mesh, unsigned int order_increase) : coarse_space(coarse_space), ref_mesh(ref_mesh), order_increase(order_increase)
+    Space<Scalar>::ReferenceSpaceCreator::ReferenceSpaceCreator(const Space<Scalar>* coarse_space, const Mesh* ref_mesh, unsigned int order_increase) : coarse_space(coarse_space), ref_mesh(ref_mesh), order_increase(order_increase), ref_space(NULL)
     {
     }
 
+    template<typename Scalar>
+    Space<Scalar>::ReferenceSpaceCreator::~ReferenceSpaceCreator()
+    {
+      delete this->ref_space;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::ReferenceSpaceCreator::handle_orders(Space<Scalar>* ref_space)
     {
@@ -695,6 +706,37 @@ namespace Hermes
       return ref_space;
     }
 
+    template<typename Scalar>
+    Space<Scalar>* Space<Scalar>::ReferenceSpaceCreator::update_ref_space(bool assign_dofs)
+    {
+      if(this->ref_space == NULL)
+      {
+        this->ref_space = this->create_ref_space(assign_dofs);
+        return this->ref_space;
+      }
+
+      // The mesh may have grown since the last call.
+      this->ref_space->resize_tables();
+
+      /// Call to the OVERRIDABLE handling method.
+      this->handle_orders(this->ref_space);
+
+      this->finish_construction(this->ref_space);
+
+      if(assign_dofs)
+      {
+        this->ref_space->assign_dofs();
+
+        // assign_dofs() marks all the elements as changed.
+        Element* e;
+        for_all_active_elements(e, this->ref_space->get_mesh())
+          this->ref_space->edata[e->id].changed_in_last_adaptation = false;
+        this->mark_changed_elements(this->ref_space);
+      }
+
+      return this->ref_space;
+    }
+
     template<typename Scalar>
     L2Space<Scalar>* Space<Scalar>::ReferenceSpaceCreator::init_construction_l2()
     {
@@ -744,6 +786,12 @@ namespace Hermes
     {
       ref_space->seq = g_space_seq++;
 
+      this->mark_changed_elements(ref_space);
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::ReferenceSpaceCreator::mark_changed_elements(Space<Scalar>* ref_space)
+    {
       Element *e;
       for_all_active_elements(e, coarse_space->get_mesh())
       {
@@ -920,6 +968,9 @@ namespace Hermes
       assign_edge_dofs();
       assign_bubble_dofs();
 
+      if(Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::dofOrdering) == HERMES_DOF_ORDERING_RCM)
+        renumber_dofs_rcm();
+
       free_bc_data();
       update_essential_bc_values();
       update_constraints();
@@ -933,6 +984,206 @@ namespace Hermes
       check();
     }
 
+    template<typename Scalar>
+    void Space<Scalar>::renumber_dofs_rcm()
+    {
+      int num_dofs = (next_dof - first_dof) / stride;
+      if(num_dofs == 0)
+        return;
+
+      // DOF blocks, identified by their first local DOF (DOF number - first_dof) / stride.
+      // block_fields are the NodeData::dof / ElementData::bdof fields holding the first DOF, block_sizes the numbers of DOFs.
+      int* block_ids = new int[num_dofs];
+      for (int i = 0; i < num_dofs; i++)
+        block_ids[i] = -1;
+      Hermes::vector<int*> block_fields;
+      Hermes::vector<int> block_sizes;
+
+      // Blocks of every active element.
+      Hermes::vector<int> element_starts;
+      Hermes::vector<int> element_blocks;
+
+      Element* e;
+      for_all_active_elements(e, mesh)
+      {
+        element_starts.push_back(element_blocks.size());
+        for (unsigned int i = 0; i < 2 * e->get_nvert() + 1; i++)
+        {
+          int* field;
+          int n;
+          if(i < e->get_nvert())
+          {
+            // Constrained vertex nodes do not have DOFs, NodeData holds the constraint instead.
+            if(e->vn[i]->is_constrained_vertex())
+              continue;
+            field = &ndata[e->vn[i]->id].dof;
+            n = ndata[e->vn[i]->id].n;
+          }
+          else if(i < 2 * e->get_nvert())
+          {
+            field = &ndata[e->en[i - e->get_nvert()]->id].dof;
+            n = ndata[e->en[i - e->get_nvert()]->id].n;
+          }
+          else
+          {
+            field = &edata[e->id].bdof;
+            n = edata[e->id].n;
+          }
+
+          // Essential BC DOFs, constrained edge nodes, nodes without DOFs.
+          if(n <= 0 || *field < first_dof)
+            continue;
+
+          int local_dof = (*field - first_dof) / stride;
+          if(block_ids[local_dof] == -1)
+          {
+            block_ids[local_dof] = block_fields.size();
+            block_fields.push_back(field);
+            block_sizes.push_back(n);
+          }
+          element_blocks.push_back(block_ids[local_dof]);
+        }
+      }
+      element_starts.push_back(element_blocks.size());
+      delete [] block_ids;
+
+      int num_blocks = block_fields.size();
+      int num_elements = element_starts.size() - 1;
+
+      int total_size = 0;
+      for (int block_i = 0; block_i < num_blocks; block_i++)
+        total_size += block_sizes[block_i];
+      if(total_size != num_dofs)
+      {
+        this->warn("DOF blocks do not cover all the DOFs in Space::renumber_dofs_rcm(), keeping the native ordering.");
+        return;
+      }
+
+      // Elements of every block.
+      int* block_element_starts = new int[num_blocks + 1];
+      memset(block_element_starts, 0, (num_blocks + 1) * sizeof(int));
+      for (unsigned int i = 0; i < element_blocks.size(); i++)
+        block_element_starts[element_blocks[i] + 1]++;
+      for (int block_i = 0; block_i < num_blocks; block_i++)
+        block_element_starts[block_i + 1] += block_element_starts[block_i];
+      int* block_elements = new int[element_blocks.size() > 0 ? element_blocks.size() : 1];
+      int* fill = new int[num_blocks > 0 ? num_blocks : 1];
+      memcpy(fill, block_element_starts, num_blocks * sizeof(int));
+      for (int element_i = 0; element_i < num_elements; element_i++)
+        for (int i = element_starts[element_i]; i < element_starts[element_i + 1]; i++)
+          block_elements[fill[element_blocks[i]]++] = element_i;
+      delete [] fill;
+
+      // Adjacency of the blocks.
+      Hermes::vector<int> adjacency_starts;
+      Hermes::vector<int> adjacency;
+      int* marker = new int[num_blocks > 0 ? num_blocks : 1];
+      for (int block_i = 0; block_i < num_blocks; block_i++)
+        marker[block_i] = -1;
+      for (int block_i = 0; block_i < num_blocks; block_i++)
+      {
+        adjacency_starts.push_back(adjacency.size());
+        marker[block_i] = block_i;
+        for (int i = block_element_starts[block_i]; i < block_element_starts[block_i + 1]; i++)
+        {
+          int element_i = block_elements[i];
+          for (int j = element_starts[element_i]; j < element_starts[element_i + 1]; j++)
+            if(marker[element_blocks[j]] != block_i)
+            {
+              marker[element_blocks[j]] = block_i;
+              adjacency.push_back(element_blocks[j]);
+            }
+        }
+      }
+      adjacency_starts.push_back(adjacency.size());
+      delete [] marker;
+      delete [] block_element_starts;
+      delete [] block_elements;
+
+      // Cuthill-McKee ordering of every connected component, started from a pseudo-peripheral block (George-Liu).
+      int* order = new int[num_blocks > 0 ? num_blocks : 1];
+      int* level = new int[num_blocks > 0 ? num_blocks : 1];
+      bool* numbered = new bool[num_blocks > 0 ? num_blocks : 1];
+      for (int block_i = 0; block_i < num_blocks; block_i++)
+      {
+        level[block_i] = -1;
+        numbered[block_i] = false;
+      }
+      Hermes::vector<std::pair<int, int> > neighbors_by_degree;
+      int ordered = 0;
+      for (int seed = 0; seed < num_blocks; seed++)
+      {
+        if(numbered[seed])
+          continue;
+
+        // Level structures, the unnumbered part of order serves as the queue.
+        int root = seed;
+        int eccentricity = -1;
+        for (int iteration = 0; iteration < 10; iteration++)
+        {
+          int head = ordered, tail = ordered;
+          order[tail++] = root;
+          level[root] = 0;
+          while(head < tail)
+          {
+            int block_i = order[head++];
+            for (int i = adjacency_starts[block_i]; i < adjacency_starts[block_i + 1]; i++)
+              if(!numbered[adjacency[i]] && level[adjacency[i]] == -1)
+              {
+                level[adjacency[i]] = level[block_i] + 1;
+                order[tail++] = adjacency[i];
+              }
+          }
+
+          // Block of minimal degree in the last level.
+          int last_level = level[order[tail - 1]];
+          int candidate = order[tail - 1];
+          for (int i = tail - 1; i >= ordered && level[order[i]] == last_level; i--)
+            if(adjacency_starts[order[i] + 1] - adjacency_starts[order[i]] <= adjacency_starts[candidate + 1] - adjacency_starts[candidate])
+              candidate = order[i];
+
+          for (int i = ordered; i < tail; i++)
+            level[order[i]] = -1;
+
+          if(last_level <= eccentricity)
+            break;
+          eccentricity = last_level;
+          root = candidate;
+        }
+
+        // Breadth-first search, neighbors in the order of increasing degree.
+        int head = ordered;
+        order[ordered++] = root;
+        numbered[root] = true;
+        while(head < ordered)
+        {
+          int block_i = order[head++];
+          neighbors_by_degree.clear();
+          for (int i = adjacency_starts[block_i]; i < adjacency_starts[block_i + 1]; i++)
+            if(!numbered[adjacency[i]])
+            {
+              numbered[adjacency[i]] = true;
+              neighbors_by_degree.push_back(std::pair<int, int>(adjacency_starts[adjacency[i] + 1] - adjacency_starts[adjacency[i]], adjacency[i]));
+            }
+          std::sort(neighbors_by_degree.begin(), neighbors_by_degree.end());
+          for (unsigned int i = 0; i < neighbors_by_degree.size(); i++)
+            order[ordered++] = neighbors_by_degree[i].second;
+        }
+      }
+
+      // Reversed order, the DOFs of each block stay consecutive.
+      int local_dof = 0;
+      for (int i = num_blocks - 1; i >= 0; i--)
+      {
+        *block_fields[order[i]] = first_dof + local_dof * stride;
+        local_dof += block_sizes[order[i]];
+      }
+
+      delete [] order;
+      delete [] level;
+      delete [] numbered;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::reset_dof_assignment()
     {
@@ -1183,120 +1434,147 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    Space<Scalar>* Space<Scalar>::load(const char *filename, Mesh* mesh, bool validate, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    Space<Scalar>* Space<Scalar>::create_for_load(SpaceType type, Mesh* mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset, const char* filename)
     {
-      try
+      Space<Scalar>* space;
+
+      switch(type)
       {
-				Space<Scalar>* space;
+      case HERMES_H1_SPACE:
+        {
+          space = new H1Space<Scalar>();
+          space->mesh = mesh;
 
-        ::xml_schema::flags parsing_flags = 0;
+          if(shapeset == NULL)
+          {
+            space->shapeset = new H1Shapeset;
+            space->own_shapeset = true;
+          }
+          else
+          {
+            if(shapeset->get_space_type() != HERMES_H1_SPACE)
+              throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Space file %s in Space::load.", filename);
+            else
+              space->shapeset = shapeset;
+          }
 
-        if(!validate)
-          parsing_flags = xml_schema::flags::dont_validate;
+          space->precalculate_projection_matrix(2, space->proj_mat, space->chol_p);
+        }
+        break;
+      case HERMES_HCURL_SPACE:
+        {
+          space = new HcurlSpace<Scalar>();
+          space->mesh = mesh;
 
-        std::auto_ptr<XMLSpace::space> parsed_xml_space (XMLSpace::space_(filename, parsing_flags));
+          if(shapeset == NULL)
+          {
+            space->shapeset = new HcurlShapeset;
+            space->own_shapeset = true;
+          }
+          else
+          {
+            if(shapeset->get_num_components() < 2)
+              throw Hermes::Exceptions::Exception("HcurlSpace requires a vector shapeset in Space::load.");
+            if(shapeset->get_space_type() != HERMES_HCURL_SPACE)
+              throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Space file %s in Space::load.", filename);
+            else
+              space->shapeset = shapeset;
+          }
 
-				if(!strcmp(parsed_xml_space->spaceType().get().c_str(),"h1"))
-				{
-					space = new H1Space<Scalar>();
-					space->mesh = mesh;
+          space->precalculate_projection_matrix(0, space->proj_mat, space->chol_p);
+        }
+        break;
+      case HERMES_HDIV_SPACE:
+        {
+          space = new HdivSpace<Scalar>();
+          space->mesh = mesh;
 
-					if(shapeset == NULL)
-					{
-						space->shapeset = new H1Shapeset;
-						space->own_shapeset = true;
-					}
-					else
-					{
-						if(shapeset->get_space_type() != HERMES_H1_SPACE)
-							throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Solution XML file %s in Space::load.", filename);
-						else
-							space->shapeset = shapeset;
-					}
+          if(shapeset == NULL)
+          {
+            space->shapeset = new HdivShapeset;
+            space->own_shapeset = true;
+          }
+          else
+          {
+            if(shapeset->get_num_components() < 2)
+              throw Hermes::Exceptions::Exception("HdivSpace requires a vector shapeset in Space::load.");
+            if(shapeset->get_space_type() != HERMES_HDIV_SPACE)
+              throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Space file %s in Space::load.", filename);
+            else
+              space->shapeset = shapeset;
+          }
 
-					space->precalculate_projection_matrix(2, space->proj_mat, space->chol_p);
-				}
-				else if (!strcmp(parsed_xml_space->spaceType().get().c_str(),"hcurl"))
-				{
-					space = new HcurlSpace<Scalar>();
-					space->mesh = mesh;
+          space->precalculate_projection_matrix(0, space->proj_mat, space->chol_p);
+        }
+        break;
+      case HERMES_L2_SPACE:
+        {
+          space = new L2Space<Scalar>();
+          space->mesh = mesh;
 
-					if(shapeset == NULL)
-					{
-						space->shapeset = new HcurlShapeset;
-						space->own_shapeset = true;
-					}
-				else
-					{
-						if(shapeset->get_num_components() < 2)
-							throw Hermes::Exceptions::Exception("HcurlSpace requires a vector shapeset in Space::load.");
-						if(shapeset->get_space_type() != HERMES_HCURL_SPACE)
-							throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Solution XML file %s in Space::load.", filename);
-						else
-							space->shapeset = shapeset;
-					}
+          if(shapeset == NULL)
+          {
+            space->shapeset = new L2Shapeset;
+            space->own_shapeset = true;
+          }
+          else
+          {
+            if(shapeset->get_space_type() != HERMES_L2_SPACE)
+              throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Space file %s in Space::load.", filename);
+            else
+              space->shapeset = shapeset;
+          }
 
-					space->precalculate_projection_matrix(0, space->proj_mat, space->chol_p);
-				}
-				else if(!!strcmp(parsed_xml_space->spaceType().get().c_str(),"hdiv"))
-				{
-					space = new HdivSpace<Scalar>();
-					space->mesh = mesh;
+          static_cast<L2Space<Scalar>*>(space)->ldata = NULL;
+          static_cast<L2Space<Scalar>*>(space)->lsize = 0;
+        }
+        break;
+      default:
+        throw Exceptions::SpaceLoadFailureException("Wrong spaceType in the Space file %s in Space::load.", filename);
+        return NULL;
+      }
 
-					if(shapeset == NULL)
-					{
-						space->shapeset = new HdivShapeset;
-						space->own_shapeset = true;
-					}
-					else
-					{
-						if(shapeset->get_num_components() < 2)
-							throw Hermes::Exceptions::Exception("HdivSpace requires a vector shapeset in Space::load.");
-						if(shapeset->get_space_type() != HERMES_HDIV_SPACE)
-							throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Solution XML file %s in Space::load.", filename);
-						else
-							space->shapeset = shapeset;
-					}
+      space->essential_bcs = essential_bcs;
+      space->mesh_seq = space->mesh->get_seq();
 
-					space->precalculate_projection_matrix(0, space->proj_mat, space->chol_p);
-				}
-				else if(strcmp(parsed_xml_space->spaceType().get().c_str(),"l2"))
-				{
-					space = new L2Space<Scalar>();
-					space->mesh = mesh;
+      // L2 space does not have any (strong) essential BCs.
+      if(essential_bcs != NULL && type != HERMES_L2_SPACE)
+        for(typename Hermes::vector<EssentialBoundaryCondition<Scalar>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
+          for(unsigned int i = 0; i < (*it)->markers.size(); i++)
+            if(space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.find((*it)->markers.at(i)) == space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.end())
+              throw Hermes::Exceptions::Exception("A boundary condition defined on a non-existent marker.");
 
-					if(shapeset == NULL)
-					{
-						space->shapeset = new L2Shapeset;
-						space->own_shapeset = true;
-					}
-					{
-						if(shapeset->get_space_type() != HERMES_L2_SPACE)
-							throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in the Solution XML file %s in Space::load.", filename);
-						else
-							space->shapeset = shapeset;
-					}
+      space->resize_tables();
 
-					static_cast<L2Space<Scalar>*>(space)->ldata = NULL;
-					static_cast<L2Space<Scalar>*>(space)->lsize = 0;
-				}
-				else
-				{
-					throw Exceptions::SpaceLoadFailureException("Wrong spaceType in the Solution XML file %s in Space::load.", filename);
-					return NULL;
-				}
+      return space;
+    }
 
-				space->essential_bcs = essential_bcs;
-				space->mesh_seq = space->mesh->get_seq();
+    template<typename Scalar>
+    Space<Scalar>* Space<Scalar>::load(const char *filename, Mesh* mesh, bool validate, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    {
+      if(BinaryReader::is_binary_file(filename, H2D_SPACE_BINARY_MAGIC))
+        return load_binary(filename, mesh, essential_bcs, shapeset);
 
-				// L2 space does not have any (strong) essential BCs.
-				if(essential_bcs != NULL && parsed_xml_space->spaceType().get().c_str() != "l2")
-					for(typename Hermes::vector<EssentialBoundaryCondition<Scalar>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
-						for(unsigned int i = 0; i < (*it)->markers.size(); i++)
-							if(space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.find((*it)->markers.at(i)) == space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.end())
-								throw Hermes::Exceptions::Exception("A boundary condition defined on a non-existent marker.");
+      try
+      {
+        ::xml_schema::flags parsing_flags = 0;
 
-				space->resize_tables();
+        if(!validate)
+          parsing_flags = xml_schema::flags::dont_validate;
+
+        std::auto_ptr<XMLSpace::space> parsed_xml_space (XMLSpace::space_(filename, parsing_flags));
+
+        SpaceType type = HERMES_INVALID_SPACE;
+        if(!strcmp(parsed_xml_space->spaceType().get().c_str(),"h1"))
+          type = HERMES_H1_SPACE;
+        else if(!strcmp(parsed_xml_space->spaceType().get().c_str(),"hcurl"))
+          type = HERMES_HCURL_SPACE;
+        else if(!strcmp(parsed_xml_space->spaceType().get().c_str(),"hdiv"))
+          type = HERMES_HDIV_SPACE;
+        else if(!strcmp(parsed_xml_space->spaceType().get().c_str(),"l2"))
+          type = HERMES_L2_SPACE;
+
+        Space<Scalar>* space = create_for_load(type, mesh, essential_bcs, shapeset, filename);
 
         // Element data //
         unsigned int elem_data_count = parsed_xml_space->element_data().size();
@@ -1320,6 +1598,134 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    bool Space<Scalar>::save_binary(const char *filename, bool compress) const
+    {
+      this->check();
+
+      if(this->get_type() != HERMES_H1_SPACE && this->get_type() != HERMES_HCURL_SPACE && this->get_type() != HERMES_HDIV_SPACE && this->get_type() != HERMES_L2_SPACE)
+        return false;
+
+      // Element data of all elements, as in save().
+      int count = 0;
+      Element *e;
+      for_all_elements(e, this->get_mesh())
+        count++;
+
+      int* ids = new int[count];
+      int* orders = new int[count];
+      int* bdofs = new int[count];
+      int* ns = new int[count];
+      char* changed = new char[count];
+
+      int i = 0;
+      for_all_elements(e, this->get_mesh())
+      {
+        ids[i] = e->id;
+        orders[i] = this->edata[e->id].order;
+        bdofs[i] = this->edata[e->id].bdof;
+        ns[i] = this->edata[e->id].n;
+        changed[i] = this->edata[e->id].changed_in_last_adaptation ? 1 : 0;
+        i++;
+      }
+
+      try
+      {
+        BinaryWriter writer(filename, H2D_SPACE_BINARY_MAGIC, H2D_SPACE_BINARY_VERSION, compress);
+        int header[2] = { this->get_type(), count };
+        writer.write_ints(header, 2);
+        writer.write_ints(ids, count);
+        writer.write_ints(orders, count);
+        writer.write_ints(bdofs, count);
+        writer.write_ints(ns, count);
+        writer.write_section(changed, sizeof(char), count);
+        writer.close();
+      }
+      catch(Hermes::Exceptions::Exception& e)
+      {
+        delete [] ids;
+        delete [] orders;
+        delete [] bdofs;
+        delete [] ns;
+        delete [] changed;
+        throw;
+      }
+
+      delete [] ids;
+      delete [] orders;
+      delete [] bdofs;
+      delete [] ns;
+      delete [] changed;
+
+      return true;
+    }
+
+    template<typename Scalar>
+    Space<Scalar>* Space<Scalar>::load_binary(const char *filename, Mesh* mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    {
+      int* ids = NULL;
+      int* orders = NULL;
+      int* bdofs = NULL;
+      int* ns = NULL;
+      char* changed = NULL;
+      Space<Scalar>* space = NULL;
+
+      try
+      {
+        BinaryReader reader(filename, H2D_SPACE_BINARY_MAGIC, H2D_SPACE_BINARY_VERSION);
+        int header[2];
+        reader.read_ints(header, 2);
+        int count = header[1];
+
+        ids = new int[count];
+        orders = new int[count];
+        bdofs = new int[count];
+        ns = new int[count];
+        changed = new char[count];
+        reader.read_ints(ids, count);
+        reader.read_ints(orders, count);
+        reader.read_ints(bdofs, count);
+        reader.read_ints(ns, count);
+        if(reader.next_section_count(sizeof(char)) != count)
+          throw Hermes::Exceptions::Exception("Wrong number of elements in %s.", filename);
+        reader.read_section(changed);
+
+        space = create_for_load((SpaceType)header[0], mesh, essential_bcs, shapeset, filename);
+
+        for (int i = 0; i < count; i++)
+        {
+          if(ids[i] < 0 || ids[i] >= space->esize)
+            throw Hermes::Exceptions::Exception("Element id %d in %s does not exist in the mesh.", ids[i], filename);
+          space->edata[ids[i]].order = orders[i];
+          space->edata[ids[i]].bdof = bdofs[i];
+          space->edata[ids[i]].n = ns[i];
+          space->edata[ids[i]].changed_in_last_adaptation = (changed[i] != 0);
+        }
+      }
+      catch(Hermes::Exceptions::Exception& e)
+      {
+        delete [] ids;
+        delete [] orders;
+        delete [] bdofs;
+        delete [] ns;
+        delete [] changed;
+        delete space;
+        throw Hermes::Exceptions::SpaceLoadFailureException("%s", e.what());
+      }
+
+      delete [] ids;
+      delete [] orders;
+      delete [] bdofs;
+      delete [] ns;
+      delete [] changed;
+
+      space->seq = g_space_seq++;
+
+      space->assign_dofs();
+
+      return space;
+    }
+
     template class HERMES_API Space<double>;
     template class HERMES_API Space<std::complex<double> >;
   }
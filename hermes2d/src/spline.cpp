@@ -14,6 +14,7 @@
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "spline.h"
+#include <algorithm>
 
 using namespace Hermes::Algebra::DenseMatrixOperations;
 namespace Hermes
@@ -26,12 +27,12 @@ namespace Hermes
       bool extrapolate_der_left, bool extrapolate_der_right) : Hermes::Hermes1DFunction<double>(), points(points), values(values),
       bc_left(bc_left), bc_right(bc_right), first_der_left(first_der_left),
       first_der_right(first_der_right), extrapolate_der_left(extrapolate_der_left),
-      extrapolate_der_right(extrapolate_der_right)
+      extrapolate_der_right(extrapolate_der_right), uniform_grid(false), inv_grid_step(0.0)
     {
       this->is_const = false;
     }
 
-    CubicSpline::CubicSpline(double const_value) : Hermes::Hermes1DFunction<double>(const_value)
+    CubicSpline::CubicSpline(double const_value) : Hermes::Hermes1DFunction<double>(const_value), uniform_grid(false), inv_grid_step(0.0)
     {
     }
 
@@ -113,6 +114,50 @@ namespace Hermes
       return get_derivative_from_interval(x, m);
     };
 
+    void CubicSpline::value(int n, const double* x, double* result) const
+    {
+      // For simple constant case.
+      if(this->is_const)
+      {
+        for (int i = 0; i < n; i++)
+          result[i] = const_value;
+        return;
+      }
+
+      // Constant extension is a linear one with zero slope.
+      double slope_left = extrapolate_der_left ? derivative_left : 0.0;
+      double slope_right = extrapolate_der_right ? derivative_right : 0.0;
+
+      for (int i = 0; i < n; i++)
+      {
+        double x_in = std::min(std::max(x[i], point_left), point_right);
+        double value_inside = get_value_from_interval(x_in, get_interval(x_in));
+        result[i] = x[i] < point_left ? extrapolate_value(point_left, value_left, slope_left, x[i])
+          : (x[i] > point_right ? extrapolate_value(point_right, value_right, slope_right, x[i]) : value_inside);
+      }
+    }
+
+    void CubicSpline::derivative(int n, const double* x, double* result) const
+    {
+      // For simple constant case.
+      if(this->is_const)
+      {
+        for (int i = 0; i < n; i++)
+          result[i] = 0.0;
+        return;
+      }
+
+      double slope_left = extrapolate_der_left ? derivative_left : 0.0;
+      double slope_right = extrapolate_der_right ? derivative_right : 0.0;
+
+      for (int i = 0; i < n; i++)
+      {
+        double x_in = std::min(std::max(x[i], point_left), point_right);
+        double derivative_inside = get_derivative_from_interval(x_in, get_interval(x_in));
+        result[i] = x[i] < point_left ? slope_left : (x[i] > point_right ? slope_right : derivative_inside);
+      }
+    }
+
     double CubicSpline::extrapolate_value(double point_end, double value_end,
       double derivative_end, double x_in) const
     {
@@ -144,17 +189,23 @@ namespace Hermes
       if(x_in < points[i_left]) return false;
       if(x_in > points[i_right]) return false;
 
-      while (i_left + 1 < i_right)
-      {
-        int i_mid = (i_left + i_right) / 2;
-        if(points[i_mid] < x_in) i_left = i_mid;
-        else i_right = i_mid;
-      }
-
-      m = i_left;
+      m = get_interval(x_in);
       return true;
     };
 
+    int CubicSpline::get_interval(double x_in) const
+    {
+      int m;
+      if(uniform_grid)
+        m = (int)((x_in - point_left) * inv_grid_step);
+      else
+      {
+        // The last point smaller than x_in (the first one for x_in == point_left).
+        m = (int)(std::lower_bound(points.begin(), points.end(), x_in) - points.begin()) - 1;
+      }
+      return std::max(0, std::min(m, (int)coeffs.size() - 1));
+    }
+
     void CubicSpline::plot(const char* filename, double extension, bool plot_derivative, int subdiv) const
     {
       FILE *f = fopen(filename, "wb");
@@ -387,6 +438,14 @@ namespace Hermes
       value_right = values[values.size() - 1];
       derivative_right = get_derivative_from_interval(point_right, points.size() - 2);
 
+      // Equidistant points (up to rounding) allow a direct interval lookup.
+      double grid_step = (point_right - point_left) / nelem;
+      uniform_grid = true;
+      for (int i = 1; i < nelem; i++)
+        if(std::abs(points[i] - (point_left + i * grid_step)) > 1e-12 * (point_right - point_left))
+          uniform_grid = false;
+      inv_grid_step = 1.0 / grid_step;
+
       // Free the matrix and rhs vector.
       delete [] matrix;
       delete [] rhs;
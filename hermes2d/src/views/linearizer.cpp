@@ -613,38 +613,29 @@ namespace Hermes
             trfs[i][xdisp == NULL ? 1 : 2] = fns[i][xdisp == NULL ? 1 : 2];
         }
 
-        Traverse trav_masterMax(true);
-        unsigned int num_states = trav_masterMax.get_num_states(meshes);
-
-        trav_masterMax.begin(meshes.size(), &(meshes.front()));
-
-        Traverse* trav = new Traverse[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
-
-        for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
-        {
-          trav[i].begin(meshes.size(), &(meshes.front()), trfs[i]);
-          trav[i].stack = trav_masterMax.stack;
-        }
+        // Union mesh states, materialized once for both passes below.
+        int num_states;
+        Traverse trav_master(true);
+        Traverse::State* states = trav_master.get_states(meshes, num_states);
 
         int state_i;
 
 #define CHUNKSIZE 1
         int num_threads_used = Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads);
-#pragma omp parallel shared(trav_masterMax) private(state_i) num_threads(num_threads_used)
+#pragma omp parallel shared(states) private(state_i) num_threads(num_threads_used)
         {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
           for(state_i = 0; state_i < num_states; state_i++)
           {
             try
             {
-              Traverse::State current_state;
-#pragma omp critical(get_next_state)
-              current_state = trav[omp_get_thread_num()].get_next_state(&trav_masterMax.top, &trav_masterMax.id);
+              Traverse::State* current_state = states + state_i;
+              Traverse::set_state_transforms(current_state, trfs[omp_get_thread_num()]);
 
               fns[omp_get_thread_num()][0]->set_quad_order(0, this->item);
               double* val = fns[omp_get_thread_num()][0]->get_values(component, value_type);
 
-              for (unsigned int i = 0; i < current_state.e[0]->get_nvert(); i++)
+              for (unsigned int i = 0; i < current_state->e[0]->get_nvert(); i++)
               {
                 double f = val[i];
 #pragma omp critical (max)
@@ -665,27 +656,9 @@ namespace Hermes
           }
         }
 
-        trav_masterMax.finish();
-        for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
-          trav[i].finish();
-        delete [] trav;
-
-        Traverse trav_master(true);
-        num_states = trav_master.get_num_states(meshes);
-
-        trav_master.begin(meshes.size(), &(meshes.front()));
-
-        trav = new Traverse[Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads)];
-
-        for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
-        {
-          trav[i].begin(meshes.size(), &(meshes.front()), trfs[i]);
-          trav[i].stack = trav_master.stack;
-        }
-
-#pragma omp parallel shared(trav_master) private(state_i) num_threads(num_threads_used)
+#pragma omp parallel shared(states) private(state_i) num_threads(num_threads_used)
         {
-#pragma omp for schedule(static, CHUNKSIZE)
+#pragma omp for schedule(dynamic, CHUNKSIZE)
           for(state_i = 0; state_i < num_states; state_i++)
           {
             if(this->caughtException != NULL)
@@ -693,16 +666,13 @@ namespace Hermes
 
             try
             {
-              Traverse::State current_state;
-
-#pragma omp critical (get_next_state)
-              current_state = trav[omp_get_thread_num()].get_next_state(&trav_master.top, &trav_master.id);
+              Traverse::State* current_state = states + state_i;
+              Traverse::set_state_transforms(current_state, trfs[omp_get_thread_num()]);
 
               fns[omp_get_thread_num()][0]->set_quad_order(0, this->item);
               double* val = fns[omp_get_thread_num()][0]->get_values(component, value_type);
               if(val == NULL)
               {
-                delete [] trav;
                 throw Hermes::Exceptions::Exception("Item not defined in the solution in Linearizer::process_solution.");
               }
 
@@ -719,7 +689,7 @@ namespace Hermes
                 dy = fns[omp_get_thread_num()][xdisp == NULL ? 1 : 2]->get_fn_values();
 
               int iv[H2D_MAX_NUMBER_VERTICES];
-              for (unsigned int i = 0; i < current_state.e[0]->get_nvert(); i++)
+              for (unsigned int i = 0; i < current_state->e[0]->get_nvert(); i++)
               {
                 double f = val[i];
                 double x_disp = fns[omp_get_thread_num()][0]->get_refmap()->get_phys_x(0)[i];
@@ -736,13 +706,13 @@ namespace Hermes
               }
 
               // recur to sub-elements
-              if(current_state.e[0]->is_triangle())
-                process_triangle(fns[omp_get_thread_num()], iv[0], iv[1], iv[2], 0, NULL, NULL, NULL, NULL, current_state.e[0]->is_curved());
+              if(current_state->e[0]->is_triangle())
+                process_triangle(fns[omp_get_thread_num()], iv[0], iv[1], iv[2], 0, NULL, NULL, NULL, NULL, current_state->e[0]->is_curved());
               else
-                process_quad(fns[omp_get_thread_num()], iv[0], iv[1], iv[2], iv[3], 0, NULL, NULL, NULL, NULL, current_state.e[0]->is_curved());
+                process_quad(fns[omp_get_thread_num()], iv[0], iv[1], iv[2], iv[3], 0, NULL, NULL, NULL, NULL, current_state->e[0]->is_curved());
 
-              for (unsigned int i = 0; i < current_state.e[0]->get_nvert(); i++)
-                process_edge(iv[i], iv[current_state.e[0]->next_vert(i)], current_state.e[0]->en[i]->marker);
+              for (unsigned int i = 0; i < current_state->e[0]->get_nvert(); i++)
+                process_edge(iv[i], iv[current_state->e[0]->next_vert(i)], current_state->e[0]->en[i]->marker);
             }
             catch(Hermes::Exceptions::Exception& e)
             {
@@ -757,10 +727,9 @@ namespace Hermes
           }
         }
 
-        trav_master.finish();
+        delete [] states;
         for(unsigned int i = 0; i < Hermes2DApi.get_integral_param_value(Hermes::Hermes2D::numThreads); i++)
         {
-          trav[i].finish();
           for(unsigned int j = 0; j < (1 + (xdisp != NULL? 1 : 0) + (ydisp != NULL ? 1 : 0)); j++)
             delete fns[i][j];
           delete [] fns[i];
@@ -768,7 +737,6 @@ namespace Hermes
         }
         delete [] fns;
         delete [] trfs;
-        delete [] trav;
 
         // for contours, without regularization.
         this->tris_contours = (int3*) realloc(this->tris_contours, sizeof(int3) * this->triangle_count);
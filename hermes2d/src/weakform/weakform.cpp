@@ -278,6 +278,21 @@ namespace Hermes
       return Hermes::Ord();
     }
 
+    template<typename Scalar>
+    void MatrixForm<Scalar>::value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+      Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const
+    {
+      for(int i = 0; i < n_v; i++)
+        for(int j = sym ? i : 0; j < n_u; j++)
+          result[i][j] = this->value(n, wt, u_ext, u[j], v[i], e, ext);
+    }
+
+    template<typename Scalar>
+    bool MatrixForm<Scalar>::has_value_local_matrix() const
+    {
+      return false;
+    }
+
     template<typename Scalar>
     MatrixFormVol<Scalar>::MatrixFormVol(unsigned int i, unsigned int j) :
     MatrixForm<Scalar>(i, j)
@@ -131,6 +131,51 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      void DefaultMatrixFormVol<Scalar>::value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+        Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const
+      {
+        // A custom quadrature with more points than the buffers, evaluated pair by pair.
+        if(n > g_max_quad_points)
+        {
+          MatrixFormVol<Scalar>::value_local_matrix(n, wt, u_ext, n_u, u, n_v, v, e, ext, result, sym);
+          return;
+        }
+
+        // Weights with the coefficient and the geometry, evaluated once for all the pairs.
+        Scalar coeff_wt[g_max_quad_points];
+        coeff->value(n, e->x, e->y, coeff_wt);
+        for (int i = 0; i < n; i++)
+        {
+          coeff_wt[i] *= wt[i];
+          if(gt == HERMES_AXISYM_X)
+            coeff_wt[i] *= e->y[i];
+          else if(gt != HERMES_PLANAR)
+            coeff_wt[i] *= e->x[i];
+        }
+
+        // result = V * diag(coeff_wt) * U^T.
+        Scalar weighted_v[g_max_quad_points];
+        for (int v_i = 0; v_i < n_v; v_i++)
+        {
+          for (int i = 0; i < n; i++)
+            weighted_v[i] = coeff_wt[i] * v[v_i]->val[i];
+          for (int u_i = sym ? v_i : 0; u_i < n_u; u_i++)
+          {
+            Scalar result_ij = 0;
+            for (int i = 0; i < n; i++)
+              result_ij += weighted_v[i] * u[u_i]->val[i];
+            result[v_i][u_i] = result_ij;
+          }
+        }
+      }
+
+      template<typename Scalar>
+      bool DefaultMatrixFormVol<Scalar>::has_value_local_matrix() const
+      {
+        return true;
+      }
+
       template<typename Scalar>
       MatrixFormVol<Scalar>* DefaultMatrixFormVol<Scalar>::clone() const
       {
@@ -239,6 +284,61 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      void DefaultJacobianDiffusion<Scalar>::value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+        Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const
+      {
+        // A custom quadrature with more points than the buffers, evaluated pair by pair.
+        if(n > g_max_quad_points)
+        {
+          MatrixFormVol<Scalar>::value_local_matrix(n, wt, u_ext, n_u, u, n_v, v, e, ext, result, sym);
+          return;
+        }
+
+        // Coefficient and its derivative in u_ext, evaluated once for all the pairs.
+        Scalar derivative_wt[g_max_quad_points];
+        Scalar value_wt[g_max_quad_points];
+        coeff->derivative(n, u_ext[idx_j]->val, derivative_wt);
+        coeff->value(n, u_ext[idx_j]->val, value_wt);
+        for (int i = 0; i < n; i++)
+        {
+          double geom_wt = wt[i];
+          if(gt == HERMES_AXISYM_X)
+            geom_wt *= e->y[i];
+          else if(gt != HERMES_PLANAR)
+            geom_wt *= e->x[i];
+          derivative_wt[i] *= geom_wt;
+          value_wt[i] *= geom_wt;
+        }
+
+        // Test function parts multiplied by the weights, so that each pair is a plain dot product.
+        Scalar weighted_v_val[g_max_quad_points];
+        Scalar weighted_v_dx[g_max_quad_points];
+        Scalar weighted_v_dy[g_max_quad_points];
+        for (int v_i = 0; v_i < n_v; v_i++)
+        {
+          for (int i = 0; i < n; i++)
+          {
+            weighted_v_val[i] = derivative_wt[i] * (u_ext[idx_j]->dx[i] * v[v_i]->dx[i] + u_ext[idx_j]->dy[i] * v[v_i]->dy[i]);
+            weighted_v_dx[i] = value_wt[i] * v[v_i]->dx[i];
+            weighted_v_dy[i] = value_wt[i] * v[v_i]->dy[i];
+          }
+          for (int u_i = sym ? v_i : 0; u_i < n_u; u_i++)
+          {
+            Scalar result_ij = 0;
+            for (int i = 0; i < n; i++)
+              result_ij += weighted_v_val[i] * u[u_i]->val[i] + weighted_v_dx[i] * u[u_i]->dx[i] + weighted_v_dy[i] * u[u_i]->dy[i];
+            result[v_i][u_i] = result_ij;
+          }
+        }
+      }
+
+      template<typename Scalar>
+      bool DefaultJacobianDiffusion<Scalar>::has_value_local_matrix() const
+      {
+        return true;
+      }
+
       template<typename Scalar>
       MatrixFormVol<Scalar>* DefaultJacobianDiffusion<Scalar>::clone() const
       {
@@ -328,6 +428,53 @@ namespace Hermes
         return result;
       }
 
+      template<typename Scalar>
+      void DefaultMatrixFormDiffusion<Scalar>::value_local_matrix(int n, double *wt, Func<Scalar> *u_ext[], int n_u, Func<double> **u, int n_v, Func<double> **v,
+        Geom<double> *e, Func<Scalar> **ext, Scalar **result, bool sym) const
+      {
+        // A custom quadrature with more points than the buffers, evaluated pair by pair.
+        if(n > g_max_quad_points)
+        {
+          MatrixFormVol<Scalar>::value_local_matrix(n, wt, u_ext, n_u, u, n_v, v, e, ext, result, sym);
+          return;
+        }
+
+        // Weights with the geometry, evaluated once for all the pairs.
+        double geom_wt[g_max_quad_points];
+        for (int i = 0; i < n; i++)
+        {
+          geom_wt[i] = wt[i];
+          if(gt == HERMES_AXISYM_X)
+            geom_wt[i] *= e->y[i];
+          else if(gt != HERMES_PLANAR)
+            geom_wt[i] *= e->x[i];
+        }
+
+        double weighted_v_dx[g_max_quad_points];
+        double weighted_v_dy[g_max_quad_points];
+        for (int v_i = 0; v_i < n_v; v_i++)
+        {
+          for (int i = 0; i < n; i++)
+          {
+            weighted_v_dx[i] = geom_wt[i] * v[v_i]->dx[i];
+            weighted_v_dy[i] = geom_wt[i] * v[v_i]->dy[i];
+          }
+          for (int u_i = sym ? v_i : 0; u_i < n_u; u_i++)
+          {
+            double result_ij = 0.;
+            for (int i = 0; i < n; i++)
+              result_ij += weighted_v_dx[i] * u[u_i]->dx[i] + weighted_v_dy[i] * u[u_i]->dy[i];
+            result[v_i][u_i] = result_ij;
+          }
+        }
+      }
+
+      template<typename Scalar>
+      bool DefaultMatrixFormDiffusion<Scalar>::has_value_local_matrix() const
+      {
+        return true;
+      }
+
       template<typename Scalar>
       MatrixFormVol<Scalar>* DefaultMatrixFormDiffusion<Scalar>::clone() const
       {
@@ -620,28 +767,35 @@ namespace Hermes
       Scalar DefaultResidualDiffusion<Scalar>::value(int n, double *wt, Func<Scalar> *u_ext[], Func<double> *v,
         Geom<double> *e, Func<Scalar> **ext) const
       {
+        // Coefficient in all the points at once, on the stack for the standard quadrature rules.
+        Scalar coeff_values_stack[g_max_quad_points];
+        Scalar* coeff_values = n <= g_max_quad_points ? coeff_values_stack : new Scalar[n];
+        coeff->value(n, u_ext[idx_i]->val, coeff_values);
+
         Scalar result = 0;
         if(gt == HERMES_PLANAR) {
           for (int i = 0; i < n; i++) {
-            result += wt[i] * coeff->value(u_ext[idx_i]->val[i])
+            result += wt[i] * coeff_values[i]
               * (u_ext[idx_i]->dx[i] * v->dx[i] + u_ext[idx_i]->dy[i] * v->dy[i]);
           }
         }
         else {
           if(gt == HERMES_AXISYM_X) {
             for (int i = 0; i < n; i++) {
-              result += wt[i] * e->y[i] * coeff->value(u_ext[idx_i]->val[i])
+              result += wt[i] * e->y[i] * coeff_values[i]
                 * (u_ext[idx_i]->dx[i] * v->dx[i] + u_ext[idx_i]->dy[i] * v->dy[i]);
             }
           }
           else {
             for (int i = 0; i < n; i++) {
-              result += wt[i] * e->x[i] * coeff->value(u_ext[idx_i]->val[i])
+              result += wt[i] * e->x[i] * coeff_values[i]
                 * (u_ext[idx_i]->dx[i] * v->dx[i] + u_ext[idx_i]->dy[i] * v->dy[i]);
             }
           }
         }
 
+        if(coeff_values != coeff_values_stack)
+          delete [] coeff_values;
         return result;
       }
 
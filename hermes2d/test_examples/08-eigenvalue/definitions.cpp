@@ -1,17 +1,17 @@
 #include "definitions.h"
 
-WeakFormEigenLeft::WeakFormEigenLeft() : WeakForm(1) 
+WeakFormEigenLeft::WeakFormEigenLeft() : Hermes::Hermes2D::WeakForm<double>(1)
 {
-  add_matrix_form(new WeakFormsH1::DefaultJacobianDiffusion<double>(0, 0));
+  add_matrix_form(new Hermes::Hermes2D::WeakFormsH1::DefaultJacobianDiffusion<double>(0, 0));
   add_matrix_form(new MatrixFormPotential(0, 0));
 }
 
 template<typename Real, typename Scalar>
-Scalar WeakFormEigenLeft::MatrixFormPotential::matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, 
-                                                           Func<Real> *v, Geom<Real> *e, ExtData<Scalar> *ext) const 
+Scalar WeakFormEigenLeft::MatrixFormPotential::matrix_form(int n, double *wt, Hermes::Hermes2D::Func<Scalar> *u_ext[], Hermes::Hermes2D::Func<Real> *u,
+                                                           Hermes::Hermes2D::Func<Real> *v, Hermes::Hermes2D::Geom<Real> *e, Hermes::Hermes2D::Func<Scalar> **ext) const
 {
-  Scalar result = 0;
-  for (int i = 0; i < n; i++) 
+  Scalar result = Scalar(0);
+  for (int i = 0; i < n; i++)
   {
     Real x = e->x[i];
     Real y = e->y[i];
@@ -20,21 +20,24 @@ Scalar WeakFormEigenLeft::MatrixFormPotential::matrix_form(int n, double *wt, Fu
   return result;
 }
 
-double WeakFormEigenLeft::MatrixFormPotential::value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, 
-                                                     Func<double> *v, Geom<double> *e, ExtData<double> *ext) const 
+double WeakFormEigenLeft::MatrixFormPotential::value(int n, double *wt, Hermes::Hermes2D::Func<double> *u_ext[], Hermes::Hermes2D::Func<double> *u,
+                                                     Hermes::Hermes2D::Func<double> *v, Hermes::Hermes2D::Geom<double> *e, Hermes::Hermes2D::Func<double> **ext) const
 {
   return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
 }
 
-Ord WeakFormEigenLeft::MatrixFormPotential::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, 
-                                                Func<Ord> *v, Geom<Ord> *e, ExtData<Ord> *ext) const 
+Hermes::Ord WeakFormEigenLeft::MatrixFormPotential::ord(int n, double *wt, Hermes::Hermes2D::Func<Hermes::Ord> *u_ext[], Hermes::Hermes2D::Func<Hermes::Ord> *u,
+                                                        Hermes::Hermes2D::Func<Hermes::Ord> *v, Hermes::Hermes2D::Geom<Hermes::Ord> *e, Hermes::Hermes2D::Func<Hermes::Ord> **ext) const
 {
-  return matrix_form<Ord, Ord>(n, wt, u_ext, u, v, e, ext);
+  return matrix_form<Hermes::Ord, Hermes::Ord>(n, wt, u_ext, u, v, e, ext);
 }
 
-
-WeakFormEigenRight::WeakFormEigenRight() : WeakForm(1) 
+Hermes::Hermes2D::MatrixFormVol<double>* WeakFormEigenLeft::MatrixFormPotential::clone() const
 {
-  add_matrix_form(new WeakFormsH1::DefaultMatrixFormVol<double>(0, 0));
+  return new MatrixFormPotential(*this);
 }
 
+WeakFormEigenRight::WeakFormEigenRight() : Hermes::Hermes2D::WeakForm<double>(1)
+{
+  add_matrix_form(new Hermes::Hermes2D::WeakFormsH1::DefaultMatrixFormVol<double>(0, 0));
+}
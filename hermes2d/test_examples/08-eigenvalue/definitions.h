@@ -1,33 +1,36 @@
 #include "hermes2d.h"
 
 /* Weak forms */
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
 
-class WeakFormEigenLeft : public WeakForm<double>
+class WeakFormEigenLeft : public Hermes::Hermes2D::WeakForm<double>
 {
 public:
   WeakFormEigenLeft();
 
 private:
-  class MatrixFormPotential : public MatrixFormVol<double>
+  class MatrixFormPotential : public Hermes::Hermes2D::MatrixFormVol<double>
   {
   public:
-    MatrixFormPotential(int i, int j) : MatrixFormVol<double>(i, j) {};
+    MatrixFormPotential(int i, int j) : Hermes::Hermes2D::MatrixFormVol<double>(i, j) {};
 
     template<typename Real, typename Scalar>
-    Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, 
-                       Func<Real> *v, Geom<Real> *e, ExtData<Scalar> *ext) const;
+    Scalar matrix_form(int n, double *wt, Hermes::Hermes2D::Func<Scalar> *u_ext[], Hermes::Hermes2D::Func<Real> *u,
+                       Hermes::Hermes2D::Func<Real> *v, Hermes::Hermes2D::Geom<Real> *e, Hermes::Hermes2D::Func<Scalar> **ext) const;
 
-    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, 
-                         Func<double> *v, Geom<double> *e, ExtData<double> *ext) const;
+    virtual double value(int n, double *wt, Hermes::Hermes2D::Func<double> *u_ext[], Hermes::Hermes2D::Func<double> *u,
+                         Hermes::Hermes2D::Func<double> *v, Hermes::Hermes2D::Geom<double> *e, Hermes::Hermes2D::Func<double> **ext) const;
 
-    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, 
-                    Func<Ord> *v, Geom<Ord> *e, ExtData<Ord> *ext) const;
+    virtual Hermes::Ord ord(int n, double *wt, Hermes::Hermes2D::Func<Hermes::Ord> *u_ext[], Hermes::Hermes2D::Func<Hermes::Ord> *u,
+                            Hermes::Hermes2D::Func<Hermes::Ord> *v, Hermes::Hermes2D::Geom<Hermes::Ord> *e, Hermes::Hermes2D::Func<Hermes::Ord> **ext) const;
+
+    virtual Hermes::Hermes2D::MatrixFormVol<double>* clone() const;
   };
 };
 
-class WeakFormEigenRight : public WeakForm<double>
+class WeakFormEigenRight : public Hermes::Hermes2D::WeakForm<double>
 {
 public:
   WeakFormEigenRight();
 };
-
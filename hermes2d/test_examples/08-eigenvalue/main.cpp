@@ -1,14 +1,9 @@
-#define HERMES_REPORT_ALL
-#define HERMES_REPORT_FILE "application.log"
 #include "definitions.h"
 #include <stdio.h>
 
-using namespace RefinementSelectors;
-using Teuchos::RCP;
-using Teuchos::rcp;
-
-//  This example solves a simple eigenproblem in a square. 
-//  Python and Pysparse must be installed. 
+//  This example solves a simple eigenproblem in a square.
+//  The eigenpairs are computed by the shift-invert Lanczos method
+//  of Hermes::Solvers::EigenSolver.
 //
 //  PDE: -Laplace u + (x*x + y*y)u = lambda_k u,
 //  where lambda_0, lambda_1, ... are the eigenvalues.
@@ -19,81 +14,91 @@ using Teuchos::rcp;
 //
 //  The following parameters can be changed:
 
+const bool HERMES_VISUALIZATION = true;           // Set to "false" to suppress Hermes OpenGL visualization.
 const int NUMBER_OF_EIGENVALUES = 50;             // Desired number of eigenvalues.
 const int P_INIT = 4;                             // Uniform polynomial degree of mesh elements.
 const int INIT_REF_NUM = 3;                       // Number of initial mesh refinements.
-const double TARGET_VALUE = 2.0;                  // PySparse parameter: Eigenvalues in the vicinity of 
-                                                  // this number will be computed. 
-const double TOL = 1e-10;                         // Pysparse parameter: Error tolerance.
-const int MAX_ITER = 1000;                        // PySparse parameter: Maximum number of iterations.
+const double TARGET_VALUE = 2.0;                  // Eigenvalues in the vicinity of this number will be computed.
+const double TOL = 1e-10;                         // Eigensolver parameter: Error tolerance.
+const int MAX_ITER = 1000;                        // Eigensolver parameter: Maximum number of iterations.
+
+// Solver used for the shifted systems (A - TARGET_VALUE * B) x = y, the shifted matrix
+// is in general indefinite, so a direct solver is recommended.
+Hermes::MatrixSolverType matrix_solver_type = Hermes::SOLVER_UMFPACK;
 
 int main(int argc, char* argv[])
 {
-  info("Desired number of eigenvalues: %d.", NUMBER_OF_EIGENVALUES);
+  Hermes::HermesCommonApi.set_integral_param_value(Hermes::matrixSolverType, matrix_solver_type);
 
   // Load the mesh.
-  Mesh mesh;
-  MeshReaderH2D mloader;
+  Hermes::Hermes2D::Mesh mesh;
+  Hermes::Hermes2D::MeshReaderH2D mloader;
   mloader.load("domain.mesh", &mesh);
 
   // Perform initial mesh refinements (optional).
-  for (int i = 0; i < INIT_REF_NUM; i++) mesh.refine_all_elements();
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
 
-  // Initialize boundary conditions. 
-  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
-  EssentialBCs<double> bcs(&bc_essential);
+  // Initialize boundary conditions.
+  Hermes::Hermes2D::DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  Hermes::Hermes2D::EssentialBCs<double> bcs(&bc_essential);
 
   // Create an H1 space with default shapeset.
-  H1Space<double> space(&mesh, &bcs, P_INIT);
+  Hermes::Hermes2D::H1Space<double> space(&mesh, &bcs, P_INIT);
   int ndof = space.get_num_dofs();
-  info("ndof: %d.", ndof);
+  Hermes::Mixins::Loggable::Static::info("ndof: %d.", ndof);
 
   // Initialize the weak formulation.
   WeakFormEigenLeft wf_left;
   WeakFormEigenRight wf_right;
 
-  // Initialize matrices.
-  RCP<SparseMatrix<double> > matrix_left = rcp(new CSCMatrix<double>());
-  RCP<SparseMatrix<double> > matrix_right = rcp(new CSCMatrix<double>());
-
   // Assemble the matrices.
-  DiscreteProblem<double> dp_left(&wf_left, &space);
-  dp_left.assemble(matrix_left.get());
-  DiscreteProblem<double> dp_right(&wf_right, &space);
-  dp_right.assemble(matrix_right.get());
-
-  EigenSolver<double> es(matrix_left, matrix_right);
-  info("Calling Pysparse...");
-  es.solve(NUMBER_OF_EIGENVALUES, TARGET_VALUE, TOL, MAX_ITER);
-  info("Pysparse finished.");
+  Hermes::Algebra::CSCMatrix<double> matrix_left;
+  Hermes::Algebra::CSCMatrix<double> matrix_right;
+  Hermes::Hermes2D::DiscreteProblem<double> dp_left(&wf_left, &space);
+  dp_left.assemble(&matrix_left);
+  Hermes::Hermes2D::DiscreteProblem<double> dp_right(&wf_right, &space);
+  dp_right.assemble(&matrix_right);
+
+  // Compute the eigenpairs.
+  Hermes::Solvers::EigenSolver<double> es(&matrix_left, &matrix_right);
+  try
+  {
+    es.solve(NUMBER_OF_EIGENVALUES, TARGET_VALUE, TOL, MAX_ITER);
+  }
+  catch(Hermes::Exceptions::Exception& e)
+  {
+    e.print_msg();
+    return -1;
+  }
   es.print_eigenvalues();
 
-  // Initializing solution vector, solution and ScalarView.
-  double* coeff_vec;
-  Solution<double> sln;
-  Views::ScalarView<double> view("Solution", new Views::WinGeom(0, 0, 440, 350));
-
   // Reading solution vectors and visualizing.
-  double* eigenval = new double[NUMBER_OF_EIGENVALUES];
+  Hermes::Hermes2D::Solution<double> sln;
+  Hermes::Hermes2D::Views::ScalarView view("Solution", new Hermes::Hermes2D::Views::WinGeom(0, 0, 440, 350));
   int neig = es.get_n_eigs();
-  if (neig != NUMBER_OF_EIGENVALUES) error("Mismatched number of eigenvectors in the eigensolver output file.");  
-  for (int ieig = 0; ieig < neig; ieig++) {
-    eigenval[ieig] = es.get_eigenvalue(ieig);
+  for (int ieig = 0; ieig < neig; ieig++)
+  {
+    double eigenval = es.get_eigenvalue(ieig);
+    double* coeff_vec;
     int n;
     es.get_eigenvector(ieig, &coeff_vec, &n);
+
     // Convert coefficient vector into a Solution.
-    Solution<double>::vector_to_solution(coeff_vec, &space, &sln);
+    Hermes::Hermes2D::Solution<double>::vector_to_solution(coeff_vec, &space, &sln);
 
     // Visualize the solution.
-    char title[100];
-    sprintf(title, "Solution %d, val = %g", ieig, eigenval[ieig]);
-    view.set_title(title);
-    view.show(&sln);
-
-    // Wait for keypress.
-    Views::View::wait(Views::HERMES_WAIT_KEYPRESS);
+    if(HERMES_VISUALIZATION)
+    {
+      char title[100];
+      sprintf(title, "Solution %d, val = %g", ieig, eigenval);
+      view.set_title(title);
+      view.show(&sln);
+
+      // Wait for keypress.
+      Hermes::Hermes2D::Views::View::wait(Hermes::Hermes2D::Views::HERMES_WAIT_KEYPRESS);
+    }
   }
 
-  return 0; 
-};
-
+  return 0;
+}
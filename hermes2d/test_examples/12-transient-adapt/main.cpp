@@ -159,6 +159,11 @@ int main(int argc, char* argv[])
   // Initialize Runge-Kutta time stepping.
   RungeKutta<double> runge_kutta(&wf, &space, &bt);
 
+  // Reference meshes and spaces, updated in every adaptivity step instead of being created again.
+  // The ones of the previous time step are kept, sln_time_prev is defined on them.
+  Mesh::ReferenceMeshCreator* ref_mesh_creator_prev = NULL;
+  Space<double>::ReferenceSpaceCreator* ref_space_creator_prev = NULL;
+
   // Time stepping loop.
   double current_time = 0; int ts = 1;
   do
@@ -183,17 +188,18 @@ int main(int argc, char* argv[])
       ndof_coarse = Space<double>::get_num_dofs(&space);
     }
 
+    Mesh::ReferenceMeshCreator* ref_mesh_creator = new Mesh::ReferenceMeshCreator(&mesh);
+    Space<double>::ReferenceSpaceCreator* ref_space_creator = new Space<double>::ReferenceSpaceCreator(&space, ref_mesh_creator->update_ref_mesh());
+
     // Spatial adaptivity loop. Note: sln_time_prev must not be changed
     // during spatial adaptivity.
     bool done = false; int as = 1;
     do {
       Hermes::Mixins::Loggable::Static::info("Time step %d, adaptivity step %d:", ts, as);
 
-      // Construct globally refined reference mesh and setup reference space.
-      Mesh::ReferenceMeshCreator ref_mesh_creator(&mesh);
-      Mesh* ref_mesh = ref_mesh_creator.create_ref_mesh();
-      Space<double>::ReferenceSpaceCreator ref_space_creator(&space, ref_mesh);
-      Space<double>* ref_space = ref_space_creator.create_ref_space();
+      // Update globally refined reference mesh and reference space.
+      ref_mesh_creator->update_ref_mesh();
+      Space<double>* ref_space = ref_space_creator->update_ref_space();
       int ndof_ref = Space<double>::get_num_dofs(ref_space);
 
       // Perform one Runge-Kutta time step according to the selected Butcher's table.
@@ -254,14 +260,14 @@ int main(int argc, char* argv[])
 
       // Clean up.
       delete adaptivity;
-      if(!done) {
-        delete ref_space;
-        delete sln_time_new.get_mesh();
-      }
     }
     while (done == false);
 
     sln_time_prev.copy(&sln_time_new);
+    delete ref_space_creator_prev;
+    delete ref_mesh_creator_prev;
+    ref_space_creator_prev = ref_space_creator;
+    ref_mesh_creator_prev = ref_mesh_creator;
 
     // Increase current time and counter of time steps.
     current_time += time_step;
@@ -272,5 +278,8 @@ int main(int argc, char* argv[])
   // Wait for all views to be closed.
   if(HERMES_VISUALIZATION)
     View::wait();
+
+  delete ref_space_creator_prev;
+  delete ref_mesh_creator_prev;
   return 0;
 }
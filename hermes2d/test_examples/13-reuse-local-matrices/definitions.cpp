@@ -0,0 +1,46 @@
+#include "definitions.h"
+
+int CountingMatrixFormDiffusion::evaluations = 0;
+
+CountingMatrixFormDiffusion::CountingMatrixFormDiffusion(int i, int j) : MatrixFormVol<double>(i, j)
+{
+}
+
+double CountingMatrixFormDiffusion::value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+  Geom<double> *e, Func<double> **ext) const
+{
+  evaluations++;
+  return int_grad_u_grad_v<double, double>(n, wt, u, v);
+}
+
+Ord CountingMatrixFormDiffusion::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+  Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return int_grad_u_grad_v<Ord, Ord>(n, wt, u, v);
+}
+
+MatrixFormVol<double>* CountingMatrixFormDiffusion::clone() const
+{
+  return new CountingMatrixFormDiffusion(*this);
+}
+
+CustomRightHandSide::CustomRightHandSide(double x0, double y0, double alpha) : Hermes2DFunction<double>(), x0(x0), y0(y0), alpha(alpha)
+{
+  this->is_const = false;
+}
+
+double CustomRightHandSide::value(double x, double y) const
+{
+  return -std::exp(-alpha * ((x - x0) * (x - x0) + (y - y0) * (y - y0)));
+}
+
+Ord CustomRightHandSide::value(Ord x, Ord y) const
+{
+  return Ord(8);
+}
+
+CustomWeakFormPoisson::CustomWeakFormPoisson(Hermes2DFunction<double>* f) : WeakForm<double>(1)
+{
+  add_matrix_form(new CountingMatrixFormDiffusion(0, 0));
+  add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, f));
+}
@@ -0,0 +1,45 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+/* Diffusion form counting its evaluations */
+
+class CountingMatrixFormDiffusion : public MatrixFormVol<double>
+{
+public:
+  CountingMatrixFormDiffusion(int i, int j);
+
+  virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+    Geom<double> *e, Func<double> **ext) const;
+
+  virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+    Geom<Ord> *e, Func<Ord> **ext) const;
+
+  virtual MatrixFormVol<double>* clone() const;
+
+  /// Number of calls to value() since the last reset (the example runs on a single thread).
+  static int evaluations;
+};
+
+/* Right-hand side with a sharp peak, so that the adaptivity refines only a part of the mesh */
+
+class CustomRightHandSide : public Hermes2DFunction<double>
+{
+public:
+  CustomRightHandSide(double x0, double y0, double alpha);
+
+  virtual double value(double x, double y) const;
+
+  virtual Ord value(Ord x, Ord y) const;
+
+protected:
+  double x0, y0, alpha;
+};
+
+class CustomWeakFormPoisson : public WeakForm<double>
+{
+public:
+  CustomWeakFormPoisson(Hermes2DFunction<double>* f);
+};
@@ -0,0 +1,174 @@
+#define HERMES_REPORT_ALL
+#include "definitions.h"
+
+using namespace RefinementSelectors;
+
+//  This test example shows the reuse of the element matrices of the linear assembling
+//  (DiscreteProblemLinear::set_reuse_local_matrices()) during an adaptivity loop.
+//
+//  PDE: Poisson equation -Laplace u - f = 0, f having a sharp peak.
+//
+//  Domain: square (-10, 10)^2.
+//
+//  BC: Homogeneous Dirichlet.
+//
+//  The reference mesh and space are updated in place, so the elements the adaptivity did not touch
+//  keep their cached data. In every adaptivity step the matrix assembled by the discrete problem
+//  that reuses its element matrices is compared entry by entry with the one assembled from scratch,
+//  and the matrix form evaluations of both are counted.
+//
+//  The following parameters can be changed:
+
+// Number of initial uniform mesh refinements.
+const int INIT_REF_NUM = 3;
+// Initial polynomial degree of all mesh elements.
+const int P_INIT = 2;
+// Number of adaptivity steps.
+const int NUM_ADAPT_STEPS = 4;
+// Adaptivity parameters, see 12-transient-adapt.
+const double THRESHOLD = 0.3;
+const int STRATEGY = 0;
+const CandList CAND_LIST = H2D_HP_ANISO;
+const int MESH_REGULARITY = -1;
+
+// Problem parameters.
+const double PEAK_X = 5.0;
+const double PEAK_Y = 5.0;
+const double PEAK_ALPHA = 10.0;
+
+// Compares the two matrices and the two right-hand sides, true if they are identical.
+bool identical(UMFPackMatrix<double>* mat, UMFPackVector<double>* rhs, UMFPackMatrix<double>* mat_ref, UMFPackVector<double>* rhs_ref)
+{
+  if(mat->get_size() != mat_ref->get_size() || mat->get_nnz() != mat_ref->get_nnz())
+    return false;
+  for(unsigned int i = 0; i <= mat->get_size(); i++)
+    if(mat->get_Ap()[i] != mat_ref->get_Ap()[i])
+      return false;
+  for(unsigned int i = 0; i < mat->get_nnz(); i++)
+    if(mat->get_Ai()[i] != mat_ref->get_Ai()[i] || mat->get_Ax()[i] != mat_ref->get_Ax()[i])
+      return false;
+  for(unsigned int i = 0; i < mat->get_size(); i++)
+    if(rhs->get(i) != rhs_ref->get(i))
+      return false;
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  // The evaluations are counted in a plain static variable.
+  Hermes2DApi.set_integral_param_value(numThreads, 1);
+
+  // Load the mesh.
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", &mesh);
+
+  // Perform initial mesh refinements.
+  for(int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  // Initialize boundary conditions.
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+
+  // Create an H1 space with default shapeset.
+  H1Space<double> space(&mesh, &bcs, P_INIT);
+
+  // Initialize the weak formulation.
+  CustomRightHandSide rhs_function(PEAK_X, PEAK_Y, PEAK_ALPHA);
+  CustomWeakFormPoisson wf(&rhs_function);
+
+  // Initialize refinement selector.
+  H1ProjBasedSelector<double> selector(CAND_LIST);
+
+  Mesh::ReferenceMeshCreator ref_mesh_creator(&mesh);
+  Space<double>::ReferenceSpaceCreator ref_space_creator(&space, ref_mesh_creator.update_ref_mesh());
+  Space<double>* ref_space = ref_space_creator.update_ref_space();
+
+  // The discrete problem reusing the element matrices lives through the whole adaptivity loop.
+  DiscreteProblemLinear<double> dp(&wf, ref_space);
+  dp.set_reuse_local_matrices(true);
+
+  bool success = true;
+  int evaluations_reused = 0, evaluations_fresh = 0;
+  for(int as = 1; as <= NUM_ADAPT_STEPS; as++)
+  {
+    if(as > 1)
+    {
+      ref_mesh_creator.update_ref_mesh();
+      ref_space = ref_space_creator.update_ref_space();
+    }
+    dp.set_space(ref_space);
+
+    // Assemble with the reuse of the element matrices.
+    UMFPackMatrix<double> matrix;
+    UMFPackVector<double> rhs;
+    CountingMatrixFormDiffusion::evaluations = 0;
+    dp.assemble(&matrix, &rhs);
+    int step_evaluations_reused = CountingMatrixFormDiffusion::evaluations;
+
+    // Nothing has changed since, all the element matrices must be reused.
+    UMFPackMatrix<double> matrix_again;
+    UMFPackVector<double> rhs_again;
+    CountingMatrixFormDiffusion::evaluations = 0;
+    dp.assemble(&matrix_again, &rhs_again);
+    if(CountingMatrixFormDiffusion::evaluations != 0)
+    {
+      Hermes::Mixins::Loggable::Static::error("Step %d: %d evaluations in the repeated assembling.", as, CountingMatrixFormDiffusion::evaluations);
+      success = false;
+    }
+
+    // Assemble from scratch.
+    DiscreteProblemLinear<double> dp_fresh(&wf, ref_space);
+    UMFPackMatrix<double> matrix_fresh;
+    UMFPackVector<double> rhs_fresh;
+    CountingMatrixFormDiffusion::evaluations = 0;
+    dp_fresh.assemble(&matrix_fresh, &rhs_fresh);
+    int step_evaluations_fresh = CountingMatrixFormDiffusion::evaluations;
+
+    if(!identical(&matrix, &rhs, &matrix_fresh, &rhs_fresh) || !identical(&matrix_again, &rhs_again, &matrix_fresh, &rhs_fresh))
+    {
+      Hermes::Mixins::Loggable::Static::error("Step %d: the matrices differ.", as);
+      success = false;
+    }
+
+    Hermes::Mixins::Loggable::Static::info("Step %d: ndof_ref: %d, evaluations reused: %d, from scratch: %d.",
+      as, ref_space->get_num_dofs(), step_evaluations_reused, step_evaluations_fresh);
+    if(as > 1)
+    {
+      evaluations_reused += step_evaluations_reused;
+      evaluations_fresh += step_evaluations_fresh;
+    }
+
+    // Solve the reference problem.
+    UMFPackLinearMatrixSolver<double> solver(&matrix_fresh, &rhs_fresh);
+    solver.solve();
+    Solution<double> ref_sln, sln;
+    Solution<double>::vector_to_solution(solver.get_sln_vector(), ref_space, &ref_sln);
+
+    // Project the fine mesh solution onto the coarse mesh and adapt.
+    OGProjection<double> ogProjection;
+    ogProjection.project_global(&space, &ref_sln, &sln);
+    Adapt<double> adaptivity(&space);
+    adaptivity.calc_err_est(&sln, &ref_sln);
+    adaptivity.adapt(&selector, THRESHOLD, STRATEGY, MESH_REGULARITY);
+  }
+
+  // Only the elements changed by the adaptivity are evaluated again.
+  if(evaluations_reused >= evaluations_fresh)
+  {
+    Hermes::Mixins::Loggable::Static::error("No element matrix reused: %d evaluations, %d from scratch.", evaluations_reused, evaluations_fresh);
+    success = false;
+  }
+
+  if(success)
+  {
+    printf("Success!\n");
+    return 0;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return -1;
+  }
+}
@@ -15,6 +15,7 @@
 #cmakedefine WITH_PETSC
 #cmakedefine WITH_HDF5
 #cmakedefine WITH_EXODUSII
+#cmakedefine WITH_ZLIB
 #cmakedefine WITH_MPI
 
 // stacktrace
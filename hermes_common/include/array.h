@@ -114,9 +114,12 @@ namespace Hermes
       TYPE* add()
       {
         TYPE* item;
+        // Items taken by add_at() may still be listed as unused.
+        while (!unused.empty() && get(unused.back()).used)
+          unused.pop_back();
         if (unused.empty() || append_only)
         {
-          if (!(size & HERMES_PAGE_MASK))
+          if ((size >> HERMES_PAGE_BITS) == (int)pages.size())
           {
             TYPE* new_page = new TYPE[HERMES_PAGE_SIZE];
             pages.push_back(new_page);
@@ -136,6 +139,35 @@ namespace Hermes
         return item;
       }
 
+      /// Adds a new item with the given id number, which must not be in use.
+      /// If the id is beyond the end of the array, the array is extended
+      /// and the skipped items are registered as unused.
+      /// \return A reference to the newly allocated item of the array.
+      TYPE* add_at(int id)
+      {
+        assert(id >= 0);
+        while (size <= id)
+        {
+          if ((size >> HERMES_PAGE_BITS) == (int)pages.size())
+          {
+            TYPE* new_page = new TYPE[HERMES_PAGE_SIZE];
+            pages.push_back(new_page);
+          }
+          TYPE* item = pages[size >> HERMES_PAGE_BITS] + (size & HERMES_PAGE_MASK);
+          item->id = size;
+          item->used = 0;
+          if (size < id)
+            unused.push_back(size);
+          size++;
+        }
+        TYPE* item = pages[id >> HERMES_PAGE_BITS] + (id & HERMES_PAGE_MASK);
+        assert(!item->used);
+        item->id = id;
+        item->used = 1;
+        nitems++;
+        return item;
+      }
+
       /// Removes the given item from the array, ie., marks it as unused.
       /// Note that the array is never physically shrinked. This should not
       /// be a problem, since meshes tend to grow rather than become smaller.
@@ -245,6 +277,17 @@ namespace Hermes
         this->size = pages.size() * HERMES_PAGE_SIZE;
       }
 
+      /// Allocates the pages for up to 'count' items in advance, so that
+      /// adding a known number of items does not allocate them one by one.
+      /// The items already in the array are kept.
+      void reserve(int count)
+      {
+        int num_pages = (count + HERMES_PAGE_SIZE - 1) >> HERMES_PAGE_BITS;
+        pages.reserve(num_pages);
+        while ((int)pages.size() < num_pages)
+          pages.push_back(new TYPE[HERMES_PAGE_SIZE]);
+      }
+
       /// Counts the items in the array and registers unused items.
       /// This is a special-purpose function, used after loading the array
       /// from file.
@@ -260,7 +303,7 @@ namespace Hermes
       /// This is a special-purpose function used to create empty element slots.
       void skip_slot()
       {
-        if (!(size & HERMES_PAGE_MASK))
+        if ((size >> HERMES_PAGE_BITS) == (int)pages.size())
         {
           TYPE* new_page = new TYPE[HERMES_PAGE_SIZE];
           pages.push_back(new_page);
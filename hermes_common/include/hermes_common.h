@@ -29,6 +29,7 @@
 #include "solvers/newton_solver_nox.h"
 #include "solvers/petsc_solver.h"
 #include "solvers/umfpack_solver.h"
+#include "solvers/krylov_solver.h"
 #include "solvers/superlu_solver.h"
 #include "solvers/precond.h"
 #include "solvers/precond_ifpack.h"
@@ -60,6 +60,14 @@ namespace Hermes
     /// One-dimensional function derivative integration order.
     virtual Hermes::Ord derivative(Hermes::Ord x) const;
 
+    /// One-dimensional function values in n points (e.g. all integration points of an element).
+    /// The default calls value(Scalar) for each point, override it where one call can do better.
+    virtual void value(int n, const Scalar* x, Scalar* result) const;
+
+    /// One-dimensional function derivative values in n points.
+    /// The default calls derivative(Scalar) for each point.
+    virtual void derivative(int n, const Scalar* x, Scalar* result) const;
+
     /// The function is constant.
     /// Returns the value of is_const.
     bool is_constant() const;
@@ -105,6 +113,10 @@ namespace Hermes
     virtual Hermes::Ord derivative_x(Hermes::Ord x, Hermes::Ord y) const;
     virtual Hermes::Ord derivative_y(Hermes::Ord x, Hermes::Ord y) const;
 
+    /// Two-dimensional function values in n points given by their (real) coordinates, e.g. the integration points of an element.
+    /// The default calls value(Scalar, Scalar) for each point, override it where one call can do better.
+    virtual void value(int n, const double* x, const double* y, Scalar* result) const;
+
     /// The function is constant.
     /// Returns the value of is_const.
     bool is_constant() const;
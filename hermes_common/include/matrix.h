@@ -36,7 +36,8 @@ namespace Hermes
     SOLVER_MUMPS,
     SOLVER_SUPERLU,
     SOLVER_AMESOS,
-    SOLVER_AZTECOO
+    SOLVER_AZTECOO,
+    SOLVER_KRYLOV
   };
 
   /// \brief Namespace containing classes for vector / matrix operations.
@@ -276,6 +277,67 @@ namespace Hermes
       DF_MATRIX_MARKET ///< Matrix Market which can be read by pysparse library
     };
 
+    /// \brief Nonzero structure of a square sparse matrix in the compressed-column format (Ap, Ai).
+    ///
+    /// Built from element DOF lists, possibly added by several OpenMP threads at once (each into its own buffers),
+    /// and compressed in parallel over columns in finish(). One instance can then be used to allocate
+    /// any number of matrices via SparseMatrix::alloc_from_pattern(), without the Page lists of pre_add_ij().
+    class HERMES_API SparsityPattern
+    {
+    public:
+      SparsityPattern();
+      ~SparsityPattern();
+
+      /// Start (re)building the pattern.
+      /// @param[in] size - size of the matrix
+      /// @param[in] num_threads - number of threads that will call add_block()
+      void begin(unsigned int size, int num_threads);
+
+      /// Register all the entries (rows[i], cols[j]) as nonzero. Negative indices are skipped.
+      /// Different threads may call this at the same time with different thread_number.
+      /// @param[in] thread_number - number of the calling thread, 0 <= thread_number < num_threads
+      void add_block(int thread_number, int n_rows, const int* rows, int n_cols, const int* cols);
+
+      /// Sort the row indices in every column, remove duplicities and fill in Ap, Ai.
+      void finish();
+
+      /// Size of the matrix.
+      unsigned int get_size() const { return this->size; }
+
+      /// Number of nonzero entries, valid after finish().
+      unsigned int get_nnz() const { return this->nnz; }
+
+      /// Index to Ai where each column starts (size + 1 entries), valid after finish().
+      const int* get_Ap() const { return this->Ap; }
+
+      /// Row indices (sorted within each column), valid after finish().
+      const int* get_Ai() const { return this->Ai; }
+
+    protected:
+      /// Free everything.
+      void free();
+
+      /// Block of entries registered by add_block(), the indices are stored in the buffer dofs of the thread.
+      struct Block
+      {
+        int rows_offset;
+        int n_rows;
+        int cols_offset;
+        int n_cols;
+      };
+
+      unsigned int size;
+      int num_threads;
+
+      /// Per-thread index buffers and blocks.
+      Hermes::vector<int>* dofs;
+      Hermes::vector<Block>* blocks;
+
+      unsigned int nnz;
+      int* Ap;
+      int* Ai;
+    };
+
     /// \brief General (abstract) matrix representation in Hermes.
     template<typename Scalar>
     class HERMES_API Matrix : public Hermes::Mixins::Loggable
@@ -364,9 +426,34 @@ namespace Hermes
       /// @param[in] col  - column index
       virtual void pre_add_ij(unsigned int row, unsigned int col);
 
+      /// Allocate the matrix with the nonzero structure given by a pattern, replaces prealloc(), pre_add_ij() and alloc().
+      /// The default implementation feeds the pattern through pre_add_ij().
+      /// @param[in] pattern - finished pattern
+      virtual void alloc_from_pattern(const SparsityPattern* pattern);
+
       /// Finish manipulation with matrix (called before solving)
       virtual void finish() { }
 
+      /// Thread-local assembling.
+      /// Until finish() is called, add() writes into one of num_buffers copies of the values, the one selected
+      /// by the calling thread with set_thread_local_buffer() (no atomics / critical sections in add()),
+      /// finish() then sums the copies up in the order of the buffers. If the caller assigns the contributions
+      /// to the buffers independently of the threads, the result does not depend on the number of threads.
+      /// @param[in] num_buffers - number of copies of the values
+      /// @param[in] num_threads - number of threads that will call add()
+      /// @return false if the matrix type does not support it (add() then takes care of thread safety on its own)
+      virtual bool begin_thread_local_assembling(int num_buffers, int num_threads) { return false; }
+
+      /// Selects the buffer the calling thread adds into, see begin_thread_local_assembling().
+      /// No two threads may use one buffer at the same time.
+      virtual void set_thread_local_buffer(int buffer) { }
+
+      /// Conflict-free assembling.
+      /// The caller guarantees that (until switched off) no two threads add() to the same entry at the same time,
+      /// e.g. because the assembled elements are colored so that no two elements of one color share a DOF.
+      /// Matrix types may then skip atomics / critical sections in add().
+      virtual void set_conflict_free_assembling(bool to_set) { }
+
       virtual unsigned int get_size() { return this->size; }
 
       /// Add matrix
@@ -493,6 +580,18 @@ namespace Hermes
       /// finish the assembly of the vector
       virtual void finish() { }
 
+      /// Thread-local assembling, see SparseMatrix::begin_thread_local_assembling().
+      /// @param[in] num_buffers - number of copies of the values
+      /// @param[in] num_threads - number of threads that will call add()
+      /// @return false if the vector type does not support it
+      virtual bool begin_thread_local_assembling(int num_buffers, int num_threads) { return false; }
+
+      /// Selects the buffer the calling thread adds into, see SparseMatrix::set_thread_local_buffer().
+      virtual void set_thread_local_buffer(int buffer) { }
+
+      /// Conflict-free assembling, see SparseMatrix::set_conflict_free_assembling().
+      virtual void set_conflict_free_assembling(bool to_set) { }
+
       /// Get the value from a position
       /// @return the value form the specified index
       /// @param[in] idx - index which to obtain the value from
@@ -17,74 +17,93 @@
 // along with Hermes2D; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 /*! \file eigensolver.h
-    \brief class for solving Eigenproblems. Currently using Python.
+    \brief class for solving generalized Eigenproblems.
 */
 #ifndef __HERMES_EIGENSOLVER_H
 #define __HERMES_EIGENSOLVER_H
 
 #include "config.h"
-#ifdef WITH_PYTHON
+#ifdef WITH_UMFPACK
 
 #include "matrix.h"
-
-#include "python_API/python_api.h"
-
-// RCP
-#ifndef WITH_TRILINOS
-#include "Teuchos_RCP.hpp"
-#else
-#include "Teuchos_RCP.hpp"
-#endif
+#include "mixins.h"
+#include "umfpack_solver.h"
 
 namespace Hermes
 {
-
-using Teuchos::RCP;
-using Teuchos::Ptr;
-using Teuchos::rcp;
-using Teuchos::null;
-
-
-template <typename Scalar>
-class HERMES_API EigenSolver
-{
-public:
-    EigenSolver(const RCP<Algebra::Matrix<Scalar> > &A, const RCP<Algebra::Matrix<Scalar> > &B);
-
-
-    // Solves for 'n_eigs' eigenvectors, around the 'target_value'. Use
-    // 'get_eigenvalue' and 'get_eigenvector' to retrieve the
-    // eigenvalues/eigenvectors:
-    void solve(int n_eigs = 4, double target_value = -1, double tol = 1e-6,
-            int max_iter = 150);
-
-    // Returns the number of calculated eigenvalues
-    int get_n_eigs()
+  namespace Solvers
+  {
+    /// \brief Solver of the generalized eigenproblem A x = lambda B x for symmetric A and symmetric positive definite B.
+    ///
+    /// Uses the thick-restart Lanczos method (equivalent to Krylov-Schur for symmetric problems) in the B-inner product,
+    /// applied to the shift-inverted operator (A - target_value B)^{-1} B. The shifted matrix is assembled into a matrix
+    /// of the type given by Hermes::matrixSolverType and factorized once by the corresponding solver
+    /// (see create_linear_solver()), the factorization is then reused for all the iterations.
+    ///
+    /// Eigenvectors are normalized so that x^T B x = 1.
+    template <typename Scalar>
+    class HERMES_API EigenSolver : public Hermes::Mixins::Loggable
     {
+    public:
+      EigenSolver(CSCMatrix<Scalar>* A, CSCMatrix<Scalar>* B);
+      ~EigenSolver();
+
+      /// Solves for 'n_eigs' eigenvectors, around the 'target_value'. Use
+      /// 'get_eigenvalue' and 'get_eigenvector' to retrieve the
+      /// eigenvalues/eigenvectors (sorted by the eigenvalues in ascending order).
+      /// \param[in] tol Relative tolerance for the residuals of the eigenpairs.
+      /// \param[in] max_iter Maximum number of restarts of the Lanczos process.
+      void solve(int n_eigs = 4, double target_value = -1, double tol = 1e-6,
+        int max_iter = 150);
+
+      /// Returns the number of calculated eigenvalues
+      int get_n_eigs()
+      {
         return this->n_eigs;
-    }
-    // Returns the i-th eigenvalue
-    double get_eigenvalue(int i);
-    // Returns the i-th eigenvector. A pointer will be returned into an
-    // internal array, as well as the size of the vector. You don't own the
-    // memory and it will be deallocated once the EigenSolver() class is
-    // deleted. You need to make a copy of it if you want to store it
-    // permanently.
-    void get_eigenvector(int i, double **vec, int *n);
-
-    void print_eigenvalues()
-    {
+      }
+      /// Returns the i-th eigenvalue
+      double get_eigenvalue(int i);
+      /// Returns the i-th eigenvector. A pointer will be returned into an
+      /// internal array, as well as the size of the vector. You don't own the
+      /// memory and it will be deallocated once the EigenSolver() class is
+      /// deleted. You need to make a copy of it if you want to store it
+      /// permanently.
+      void get_eigenvector(int i, double **vec, int *n);
+
+      void print_eigenvalues()
+      {
         printf("Eigenvalues:\n");
         for (int i = 0; i < this->get_n_eigs(); i++)
-            printf("%3d: %f\n", i, this->get_eigenvalue(i));
-    }
-
-private:
-    RCP<Algebra::Matrix<Scalar> > A, B;
-    int n_eigs;
-    Python p;
-};
-
+          printf("%3d: %f\n", i, this->get_eigenvalue(i));
+      }
+
+    private:
+      /// Frees the calculated eigenpairs.
+      void free();
+
+      /// w = (A - target_value B)^{-1} B v.
+      void apply_operator(Scalar* v, Scalar* w);
+
+      /// Orthogonalizes w against v[0], ..., v[count - 1] in the B-inner product (twice, classical Gram-Schmidt),
+      /// the coefficients are added to h. Returns the B-norm of the orthogonalized w.
+      double orthogonalize(Scalar** v, int count, Scalar* w, Scalar* h);
+
+      CSCMatrix<Scalar> *A, *B;
+      int n_eigs;
+      int size;
+      double* eigenvalues;
+      Scalar** eigenvectors;
+
+      /// Shifted matrix, its solver and right-hand side.
+      SparseMatrix<Scalar>* shifted_matrix;
+      Vector<Scalar>* shifted_rhs;
+      LinearMatrixSolver<Scalar>* shifted_solver;
+      bool shifted_factorized;
+
+      /// Work array for products with B.
+      Scalar* work;
+    };
+  }
 }
 
 #endif
@@ -0,0 +1,231 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file krylov_solver.h
+\brief KrylovSolver class, in-tree iterative solvers (CG, BiCGStab, GMRES) working on CSCMatrix.
+*/
+#ifndef __HERMES_COMMON_KRYLOV_SOLVER_H_
+#define __HERMES_COMMON_KRYLOV_SOLVER_H_
+#include "config.h"
+#ifdef WITH_UMFPACK
+#include "linear_matrix_solver.h"
+#include "umfpack_solver.h"
+
+using namespace Hermes::Algebra;
+
+namespace Hermes
+{
+  namespace Preconditioners
+  {
+    /// \brief Abstract class for preconditioners used by KrylovSolver.
+    ///
+    /// The preconditioners work on a row-wise (CSR) copy of the system matrix, made by KrylovSolver.
+    /// The arrays passed to compute() stay valid until the next call to compute().
+    ///
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API KrylovPrecond
+    {
+    public:
+      virtual ~KrylovPrecond() {};
+
+      /// Calculates the preconditioner.
+      /// @param[in] size size of the matrix
+      /// @param[in] Ap index to Ai/Ax, where each row starts (size is matrix size + 1)
+      /// @param[in] Ai column indices (sorted within each row)
+      /// @param[in] Ax values
+      virtual void compute(unsigned int size, int* Ap, int* Ai, Scalar* Ax) = 0;
+
+      /// Applies the inverse of the preconditioner: z = M^{-1} r.
+      virtual void apply(Scalar* r, Scalar* z) = 0;
+    };
+
+    /// \brief Block-Jacobi preconditioner, inverts diagonal blocks of consecutive DOFs.
+    /// Block size 1 is the standard (point) Jacobi preconditioner.
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API BlockJacobiKrylovPrecond : public KrylovPrecond<Scalar>
+    {
+    public:
+      BlockJacobiKrylovPrecond(int block_size = 1);
+      virtual ~BlockJacobiKrylovPrecond();
+      virtual void compute(unsigned int size, int* Ap, int* Ai, Scalar* Ax);
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      int block_size;
+      unsigned int size;
+      /// Inverted diagonal blocks, block_size * block_size entries per block (row-wise).
+      Scalar* inv_blocks;
+    };
+
+    /// \brief Symmetric successive over-relaxation preconditioner.
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API SSORKrylovPrecond : public KrylovPrecond<Scalar>
+    {
+    public:
+      SSORKrylovPrecond(double omega = 1.0);
+      virtual ~SSORKrylovPrecond();
+      virtual void compute(unsigned int size, int* Ap, int* Ai, Scalar* Ax);
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      double omega;
+      unsigned int size;
+      int* Ap;
+      int* Ai;
+      Scalar* Ax;
+      /// Positions of the diagonal entries in Ax.
+      int* diag;
+    };
+
+    /// \brief Incomplete LU factorization with zero fill-in.
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API ILU0KrylovPrecond : public KrylovPrecond<Scalar>
+    {
+    public:
+      ILU0KrylovPrecond();
+      virtual ~ILU0KrylovPrecond();
+      virtual void compute(unsigned int size, int* Ap, int* Ai, Scalar* Ax);
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      unsigned int size;
+      int* Ap;
+      int* Ai;
+      /// L (unit diagonal, strictly lower part) and U (upper part) factors in the sparsity pattern of the matrix.
+      Scalar* LU;
+      /// Positions of the diagonal entries in LU.
+      int* diag;
+    };
+  }
+
+  namespace Solvers
+  {
+    /// \brief In-tree Krylov subspace solvers operating directly on CSCMatrix / UMFPackVector.
+    ///
+    /// Does not need any third-party library besides what CSCMatrix needs, and its memory requirements
+    /// are linear in the number of nonzeros, as opposed to UMFPackLinearMatrixSolver.
+    /// The matrix-vector product and the vector operations are parallelized using OpenMP; dot products
+    /// are summed in a fixed order, so that the results do not depend on the number of threads.
+    ///
+    /// Use it by setting Hermes::matrixSolverType to SOLVER_KRYLOV.
+    ///
+    /// @ingroup solvers
+    template <typename Scalar>
+    class HERMES_API KrylovSolver : public IterSolver<Scalar>
+    {
+    public:
+      /// Constructor.
+      /// @param[in] m pointer to matrix
+      /// @param[in] rhs pointer to right hand side vector
+      KrylovSolver(CSCMatrix<Scalar> *m, UMFPackVector<Scalar> *rhs);
+      virtual ~KrylovSolver();
+      virtual bool solve();
+      virtual int get_matrix_size();
+      virtual int get_num_iters();
+      /// Relative residual norm ||b - Ax|| / ||b|| of the last solve.
+      virtual double get_residual();
+
+      /// Set the type of the solver.
+      /// @param[in] solver - name of the solver[ cg | bicgstab | gmres ]
+      void set_solver(const char *solver);
+
+      /// Set the number of GMRES iterations before a restart.
+      /// Default: 30.
+      void set_gmres_restart(int restart);
+
+      /// Set a built-in preconditioner.
+      /// @param[in] name - name of the preconditioner[ none | jacobi | block-jacobi | ssor | ilu ]
+      virtual void set_precond(const char *name);
+
+      /// Set a preconditioner not owned by the solver.
+      /// @param[in] pc - the preconditioner, NULL means no preconditioning
+      void set_precond(KrylovPrecond<Scalar> *pc);
+
+      /// Set the block size for the block-jacobi preconditioner.
+      /// Default: 4.
+      void set_block_size(int block_size);
+
+      /// With HERMES_REUSE_FACTORIZATION_COMPLETELY, the preconditioner (and the row-wise copy of the matrix)
+      /// from the previous solve is reused.
+      virtual void set_factorization_scheme(FactorizationScheme reuse_scheme);
+
+    protected:
+      /// Preconditioners of other packages can not be used.
+      virtual void set_precond(Precond<Scalar> *pc);
+
+      enum KrylovMethod
+      {
+        KRYLOV_CG,
+        KRYLOV_BICGSTAB,
+        KRYLOV_GMRES
+      };
+
+      /// Makes the row-wise copy of the matrix.
+      void setup_csr();
+      /// Frees the row-wise copy of the matrix.
+      void free_csr();
+
+      /// y = A x, parallel over rows.
+      void multiply(Scalar* x, Scalar* y);
+      /// z = M^{-1} r, copies r to z if there is no preconditioner.
+      void precondition(Scalar* r, Scalar* z);
+      /// Sum of conj(x_i) * y_i.
+      Scalar dot(Scalar* x, Scalar* y);
+      /// Euclidean norm.
+      double norm(Scalar* x);
+
+      int solve_cg(Scalar* b, Scalar* x, double b_norm);
+      int solve_bicgstab(Scalar* b, Scalar* x, double b_norm);
+      int solve_gmres(Scalar* b, Scalar* x, double b_norm);
+
+      CSCMatrix<Scalar> *m;
+      UMFPackVector<Scalar> *rhs;
+
+      KrylovMethod method;
+      int gmres_restart;
+      int block_size;
+
+      /// The preconditioner and whether it is owned by this instance.
+      KrylovPrecond<Scalar>* pc;
+      bool own_pc;
+      bool pc_computed;
+
+      unsigned int factorization_scheme;
+
+      /// Row-wise copy of the matrix.
+      unsigned int csr_size;
+      int* csr_Ap;
+      int* csr_Ai;
+      Scalar* csr_Ax;
+
+      /// Partial sums for the dot products.
+      Scalar* dot_partials;
+
+      int num_iters;
+      double residual;
+
+      template<typename T> friend LinearMatrixSolver<T>* create_linear_solver(Matrix<T>* matrix, Vector<T>* rhs);
+    };
+  }
+}
+#endif
+#endif
@@ -104,6 +104,8 @@ namespace Hermes
       virtual ~SuperLUMatrix();
 
       virtual void alloc();
+      /// Copies Ap, Ai from the pattern.
+      virtual void alloc_from_pattern(const SparsityPattern* pattern);
       virtual void free();
       virtual Scalar get(unsigned int m, unsigned int n);
       virtual void zero();
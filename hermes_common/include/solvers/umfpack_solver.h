@@ -62,6 +62,8 @@ namespace Hermes
       CSCMatrix(unsigned int size);
       virtual ~CSCMatrix();
       virtual void alloc();
+      /// Copies Ap, Ai from the pattern.
+      virtual void alloc_from_pattern(const SparsityPattern* pattern);
       virtual void free();
       virtual Scalar get(unsigned int m, unsigned int n);
       virtual void zero();
@@ -81,6 +83,12 @@ namespace Hermes
       /// @param[in] mat added matrix
       virtual void add_as_block(unsigned int i, unsigned int j, CSCMatrix<Scalar>* mat);
       virtual void add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols);
+      /// Allocates num_buffers zeroed copies of Ax, add() then writes into the copy selected by the calling thread.
+      virtual bool begin_thread_local_assembling(int num_buffers, int num_threads);
+      virtual void set_thread_local_buffer(int buffer);
+      /// Sums up the thread-local copies (if any) into Ax.
+      virtual void finish();
+      virtual void set_conflict_free_assembling(bool to_set);
       virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE, char* number_format = "%lf");
       virtual unsigned int get_matrix_size() const;
       virtual unsigned int get_nnz() const;
@@ -113,6 +121,17 @@ namespace Hermes
       int *Ap;
       /// Number of non-zero entries ( =  Ap[size]).
       unsigned int nnz;
+      /// Thread-local copies of Ax, see begin_thread_local_assembling().
+      Scalar **thread_local_Ax;
+      /// Number of thread-local copies.
+      int thread_local_count;
+      /// The copy each thread adds into, see set_thread_local_buffer().
+      int *thread_local_buffers;
+      int thread_local_threads;
+      /// Frees the thread-local copies.
+      void free_thread_local_values();
+      /// add() does not need to be thread-safe, see set_conflict_free_assembling().
+      bool conflict_free_assembling;
       template <typename T> friend class Hermes::Solvers::UMFPackLinearMatrixSolver;
       template <typename T> friend class Hermes::Solvers::UMFPackIterator;
       template<typename T> friend SparseMatrix<T>*  create_matrix();
@@ -148,6 +167,12 @@ namespace Hermes
       virtual void add(unsigned int n, unsigned int *idx, Scalar *y);
       virtual void add_vector(Vector<Scalar>* vec);
       virtual void add_vector(Scalar* vec);
+      /// Allocates num_buffers zeroed copies of v, add() then writes into the copy selected by the calling thread.
+      virtual bool begin_thread_local_assembling(int num_buffers, int num_threads);
+      virtual void set_thread_local_buffer(int buffer);
+      /// Sums up the thread-local copies (if any) into v.
+      virtual void finish();
+      virtual void set_conflict_free_assembling(bool to_set);
       virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE, char* number_format = "%lf");
 
       /// @return pointer to array with vector data
@@ -157,6 +182,17 @@ namespace Hermes
     protected:
       /// UMFPack specific data structures for storing the rhs.
       Scalar *v;
+      /// Thread-local copies of v, see begin_thread_local_assembling().
+      Scalar **thread_local_v;
+      /// Number of thread-local copies.
+      int thread_local_count;
+      /// The copy each thread adds into, see set_thread_local_buffer().
+      int *thread_local_buffers;
+      int thread_local_threads;
+      /// Frees the thread-local copies.
+      void free_thread_local_values();
+      /// add() does not need to be thread-safe, see set_conflict_free_assembling().
+      bool conflict_free_assembling;
       template <typename T> friend class Hermes::Solvers::UMFPackLinearMatrixSolver;
       template <typename T> friend class Hermes::Solvers::UMFPackIterator;
       template<typename T> friend Vector<T>* Hermes::Algebra::create_vector();
@@ -118,6 +118,28 @@ namespace Hermes
     }
   };
 
+  template<typename Scalar>
+  void Hermes1DFunction<Scalar>::value(int n, const Scalar* x, Scalar* result) const
+  {
+    if(this->is_const)
+      for(int i = 0; i < n; i++)
+        result[i] = const_value;
+    else
+      for(int i = 0; i < n; i++)
+        result[i] = this->value(x[i]);
+  };
+
+  template<typename Scalar>
+  void Hermes1DFunction<Scalar>::derivative(int n, const Scalar* x, Scalar* result) const
+  {
+    if(this->is_const)
+      for(int i = 0; i < n; i++)
+        result[i] = Scalar(0.0);
+    else
+      for(int i = 0; i < n; i++)
+        result[i] = this->derivative(x[i]);
+  };
+
   template<typename Scalar>
   Hermes2DFunction<Scalar>::Hermes2DFunction()
   {
@@ -237,6 +259,17 @@ namespace Hermes
     }
   };
 
+  template<typename Scalar>
+  void Hermes2DFunction<Scalar>::value(int n, const double* x, const double* y, Scalar* result) const
+  {
+    if(this->is_const)
+      for(int i = 0; i < n; i++)
+        result[i] = const_value;
+    else
+      for(int i = 0; i < n; i++)
+        result[i] = this->value(Scalar(x[i]), Scalar(y[i]));
+  };
+
   template<typename Scalar>
   Hermes3DFunction<Scalar>::Hermes3DFunction()
   {
@@ -117,6 +117,174 @@ void Hermes::Algebra::DenseMatrixOperations::choldc(double **a, int n, double p[
   }
 }
 
+Hermes::Algebra::SparsityPattern::SparsityPattern() : size(0), num_threads(0), dofs(NULL), blocks(NULL), nnz(0), Ap(NULL), Ai(NULL)
+{
+}
+
+Hermes::Algebra::SparsityPattern::~SparsityPattern()
+{
+  free();
+}
+
+void Hermes::Algebra::SparsityPattern::free()
+{
+  delete [] dofs;
+  dofs = NULL;
+  delete [] blocks;
+  blocks = NULL;
+  delete [] Ap;
+  Ap = NULL;
+  delete [] Ai;
+  Ai = NULL;
+  nnz = 0;
+}
+
+void Hermes::Algebra::SparsityPattern::begin(unsigned int size, int num_threads)
+{
+  if(num_threads < 1)
+    throw Exceptions::ValueException("num_threads", num_threads, 1);
+
+  free();
+  this->size = size;
+  this->num_threads = num_threads;
+  dofs = new Hermes::vector<int>[num_threads];
+  blocks = new Hermes::vector<Block>[num_threads];
+}
+
+void Hermes::Algebra::SparsityPattern::add_block(int thread_number, int n_rows, const int* rows, int n_cols, const int* cols)
+{
+  Hermes::vector<int>& thread_dofs = dofs[thread_number];
+  Block block;
+
+  block.rows_offset = thread_dofs.size();
+  for (int i = 0; i < n_rows; i++)
+    if(rows[i] >= 0)
+      thread_dofs.push_back(rows[i]);
+  block.n_rows = thread_dofs.size() - block.rows_offset;
+
+  // Diagonal blocks share the index list.
+  if(cols == rows && n_cols == n_rows)
+  {
+    block.cols_offset = block.rows_offset;
+    block.n_cols = block.n_rows;
+  }
+  else
+  {
+    block.cols_offset = thread_dofs.size();
+    for (int j = 0; j < n_cols; j++)
+      if(cols[j] >= 0)
+        thread_dofs.push_back(cols[j]);
+    block.n_cols = thread_dofs.size() - block.cols_offset;
+  }
+
+  if(block.n_rows > 0 && block.n_cols > 0)
+    blocks[thread_number].push_back(block);
+}
+
+void Hermes::Algebra::SparsityPattern::finish()
+{
+  if(dofs == NULL)
+    throw Exceptions::Exception("SparsityPattern::begin() has to be called before SparsityPattern::finish().");
+
+  // Entries in the column (unique after sorting), size + 1 so that this can be turned into Ap in place.
+  Ap = new int[size + 1];
+  memset(Ap, 0, (size + 1) * sizeof(int));
+
+  // Every thread processes a contiguous range of columns, reading the blocks of all the threads.
+  // Thus no two threads ever write to the same column and the result does not depend on the number of threads.
+  int** column_buffers = new int*[num_threads];
+  int** column_starts = new int*[num_threads];
+  unsigned int columns_per_thread = (size + num_threads - 1) / num_threads;
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    for (int range_i = omp_get_thread_num(); range_i < num_threads; range_i += omp_get_num_threads())
+    {
+      unsigned int first_col = std::min(size, range_i * columns_per_thread);
+      unsigned int last_col = std::min(size, first_col + columns_per_thread);
+      unsigned int range_size = last_col - first_col;
+
+      // Upper bounds of the column lengths (including duplicities).
+      int* starts = new int[range_size + 1];
+      memset(starts, 0, (range_size + 1) * sizeof(int));
+      for (int thread_i = 0; thread_i < num_threads; thread_i++)
+        for (unsigned int block_i = 0; block_i < blocks[thread_i].size(); block_i++)
+        {
+          const Block& block = blocks[thread_i][block_i];
+          const int* cols = &dofs[thread_i][block.cols_offset];
+          for (int j = 0; j < block.n_cols; j++)
+            if(cols[j] >= (int)first_col && cols[j] < (int)last_col)
+              starts[cols[j] - first_col + 1] += block.n_rows;
+        }
+      for (unsigned int col_i = 0; col_i < range_size; col_i++)
+        starts[col_i + 1] += starts[col_i];
+
+      // Gather the row indices.
+      int* buffer = new int[starts[range_size] > 0 ? starts[range_size] : 1];
+      int* fill = new int[range_size > 0 ? range_size : 1];
+      memcpy(fill, starts, range_size * sizeof(int));
+      for (int thread_i = 0; thread_i < num_threads; thread_i++)
+        for (unsigned int block_i = 0; block_i < blocks[thread_i].size(); block_i++)
+        {
+          const Block& block = blocks[thread_i][block_i];
+          const int* rows = &dofs[thread_i][block.rows_offset];
+          const int* cols = &dofs[thread_i][block.cols_offset];
+          for (int j = 0; j < block.n_cols; j++)
+            if(cols[j] >= (int)first_col && cols[j] < (int)last_col)
+            {
+              memcpy(buffer + fill[cols[j] - first_col], rows, block.n_rows * sizeof(int));
+              fill[cols[j] - first_col] += block.n_rows;
+            }
+        }
+      delete [] fill;
+
+      // Sort the indices and remove duplicities, the unique indices stay at the beginning of each column.
+      for (unsigned int col_i = 0; col_i < range_size; col_i++)
+      {
+        int* begin = buffer + starts[col_i];
+        int* end = buffer + starts[col_i + 1];
+        qsort_int(begin, end - begin);
+        int* q = begin;
+        for (int *p = begin, last = -1; p < end; p++)
+          if(*p != last)
+            *q++ = last = *p;
+        Ap[first_col + col_i + 1] = q - begin;
+      }
+
+      column_buffers[range_i] = buffer;
+      column_starts[range_i] = starts;
+    }
+
+#pragma omp barrier
+#pragma omp single
+    {
+      for (unsigned int col = 0; col < size; col++)
+        Ap[col + 1] += Ap[col];
+      nnz = Ap[size];
+      Ai = new int[nnz > 0 ? nnz : 1];
+    }
+
+    for (int range_i = omp_get_thread_num(); range_i < num_threads; range_i += omp_get_num_threads())
+    {
+      unsigned int first_col = std::min(size, range_i * columns_per_thread);
+      unsigned int last_col = std::min(size, first_col + columns_per_thread);
+      for (unsigned int col = first_col; col < last_col; col++)
+        memcpy(Ai + Ap[col], column_buffers[range_i] + column_starts[range_i][col - first_col], (Ap[col + 1] - Ap[col]) * sizeof(int));
+      delete [] column_buffers[range_i];
+      delete [] column_starts[range_i];
+    }
+  }
+
+  delete [] column_buffers;
+  delete [] column_starts;
+
+  // The element lists are not needed anymore.
+  delete [] dofs;
+  dofs = NULL;
+  delete [] blocks;
+  blocks = NULL;
+}
+
 template<typename Scalar>
 Hermes::Algebra::SparseMatrix<Scalar>::SparseMatrix()
 {
@@ -171,6 +339,18 @@ void Hermes::Algebra::SparseMatrix<Scalar>::pre_add_ij(unsigned int row, unsigne
   pages[col]->idx[pages[col]->count++] = row;
 }
 
+template<typename Scalar>
+void Hermes::Algebra::SparseMatrix<Scalar>::alloc_from_pattern(const SparsityPattern* pattern)
+{
+  this->prealloc(pattern->get_size());
+  const int* Ap = pattern->get_Ap();
+  const int* Ai = pattern->get_Ai();
+  for (unsigned int col = 0; col < pattern->get_size(); col++)
+    for (int i = Ap[col]; i < Ap[col + 1]; i++)
+      this->pre_add_ij(Ai[i], col);
+  this->alloc();
+}
+
 template<typename Scalar>
 int Hermes::Algebra::SparseMatrix<Scalar>::sort_and_store_indices(Page *page, int *buffer, int *max)
 {
@@ -260,6 +440,15 @@ SparseMatrix<Scalar>* Hermes::Algebra::create_matrix()
       return new SuperLUMatrix<Scalar>;
 #else
       throw Hermes::Exceptions::Exception("SuperLU was not installed.");
+#endif
+      break;
+    }
+  case Hermes::SOLVER_KRYLOV:
+    {
+#ifdef WITH_UMFPACK
+      return new CSCMatrix<Scalar>;
+#else
+      throw Hermes::Exceptions::Exception("UMFPACK was not installed, KrylovSolver uses its matrix classes.");
 #endif
       break;
     }
@@ -325,6 +514,15 @@ Vector<Scalar>* Hermes::Algebra::create_vector()
       return new SuperLUVector<Scalar>;
 #else
       throw Hermes::Exceptions::Exception("SuperLU was not installed.");
+#endif
+      break;
+    }
+  case Hermes::SOLVER_KRYLOV:
+    {
+#ifdef WITH_UMFPACK
+      return new UMFPackVector<Scalar>;
+#else
+      throw Hermes::Exceptions::Exception("UMFPACK was not installed, KrylovSolver uses its matrix classes.");
 #endif
       break;
     }
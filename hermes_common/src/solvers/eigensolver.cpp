@@ -0,0 +1,408 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file eigensolver.cpp
+\brief class for solving generalized Eigenproblems.
+*/
+#include "config.h"
+#ifdef WITH_UMFPACK
+#include "eigensolver.h"
+#include "linear_matrix_solver.h"
+#include "callstack.h"
+#include <algorithm>
+
+using namespace Hermes::Algebra::DenseMatrixOperations;
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    /// Eigenvalues and eigenvectors of a dense symmetric matrix a (n x n, destroyed) by the cyclic Jacobi method.
+    /// Eigenvector i is stored in the column i of vecs.
+    static void symmetric_dense_eigen(int n, double** a, double* vals, double** vecs)
+    {
+      for(int i = 0; i < n; i++)
+        for(int j = 0; j < n; j++)
+          vecs[i][j] = (i == j) ? 1.0 : 0.0;
+
+      for(int sweep = 0; sweep < 100; sweep++)
+      {
+        double off = 0.0, total = 0.0;
+        for(int i = 0; i < n; i++)
+          for(int j = 0; j < n; j++)
+          {
+            total += a[i][j] * a[i][j];
+            if(i != j)
+              off += a[i][j] * a[i][j];
+          }
+        if(off <= 1e-30 * total)
+          break;
+
+        for(int p = 0; p < n - 1; p++)
+          for(int q = p + 1; q < n; q++)
+          {
+            if(a[p][q] == 0.0)
+              continue;
+            double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+            double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+            double c = 1.0 / std::sqrt(t * t + 1.0);
+            double s = t * c;
+
+            for(int k = 0; k < n; k++)
+            {
+              double akp = a[k][p], akq = a[k][q];
+              a[k][p] = c * akp - s * akq;
+              a[k][q] = s * akp + c * akq;
+            }
+            for(int k = 0; k < n; k++)
+            {
+              double apk = a[p][k], aqk = a[q][k];
+              a[p][k] = c * apk - s * aqk;
+              a[q][k] = s * apk + c * aqk;
+            }
+            for(int k = 0; k < n; k++)
+            {
+              double vkp = vecs[k][p], vkq = vecs[k][q];
+              vecs[k][p] = c * vkp - s * vkq;
+              vecs[k][q] = s * vkp + c * vkq;
+            }
+          }
+      }
+
+      for(int i = 0; i < n; i++)
+        vals[i] = a[i][i];
+    }
+
+    /// Orders Ritz values by the distance of the corresponding eigenvalue from the target,
+    /// i.e. by the magnitude of the Ritz value of the shift-inverted operator.
+    class RitzValueComparator
+    {
+    public:
+      RitzValueComparator(double* values) : values(values) {};
+      bool operator()(int a, int b) const { return std::abs(values[a]) > std::abs(values[b]); }
+    private:
+      double* values;
+    };
+
+    /// Orders the resulting eigenpairs by the eigenvalues.
+    class EigenvalueComparator
+    {
+    public:
+      EigenvalueComparator(double* values) : values(values) {};
+      bool operator()(int a, int b) const { return values[a] < values[b]; }
+    private:
+      double* values;
+    };
+
+    template<typename Scalar>
+    EigenSolver<Scalar>::EigenSolver(CSCMatrix<Scalar>* A, CSCMatrix<Scalar>* B) : A(A), B(B), n_eigs(0), size(0),
+      eigenvalues(NULL), eigenvectors(NULL), shifted_matrix(NULL), shifted_rhs(NULL), shifted_solver(NULL), shifted_factorized(false), work(NULL)
+    {
+      if(A == NULL)
+        throw Exceptions::NullException(1);
+      if(B == NULL)
+        throw Exceptions::NullException(2);
+    }
+
+    template<typename Scalar>
+    EigenSolver<Scalar>::~EigenSolver()
+    {
+      free();
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::free()
+    {
+      if(eigenvalues != NULL)
+        delete [] eigenvalues;
+      if(eigenvectors != NULL)
+      {
+        for(int i = 0; i < n_eigs; i++)
+          delete [] eigenvectors[i];
+        delete [] eigenvectors;
+      }
+      eigenvalues = NULL;
+      eigenvectors = NULL;
+      n_eigs = 0;
+    }
+
+    template<typename Scalar>
+    double EigenSolver<Scalar>::get_eigenvalue(int i)
+    {
+      if(i < 0 || i >= n_eigs)
+        throw Exceptions::ValueException("i", i, 0, n_eigs - 1);
+      return eigenvalues[i];
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::get_eigenvector(int i, double **vec, int *n)
+    {
+      if(i < 0 || i >= n_eigs)
+        throw Exceptions::ValueException("i", i, 0, n_eigs - 1);
+      *vec = eigenvectors[i];
+      *n = size;
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::apply_operator(Scalar* v, Scalar* w)
+    {
+      B->multiply_with_vector(v, work);
+      shifted_rhs->zero();
+      shifted_rhs->add_vector(work);
+      shifted_rhs->finish();
+
+      if(!shifted_solver->solve())
+        throw Exceptions::LinearMatrixSolverException("EigenSolver: solution of the shifted system failed.");
+      if(!shifted_factorized)
+      {
+        shifted_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+        shifted_factorized = true;
+      }
+      memcpy(w, shifted_solver->get_sln_vector(), size * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    double EigenSolver<Scalar>::orthogonalize(Scalar** v, int count, Scalar* w, Scalar* h)
+    {
+      for(int pass = 0; pass < 2; pass++)
+      {
+        B->multiply_with_vector(w, work);
+        for(int i = 0; i < count; i++)
+        {
+          Scalar h_i = 0.0;
+          for(int k = 0; k < size; k++)
+            h_i += v[i][k] * work[k];
+          h[i] += h_i;
+          for(int k = 0; k < size; k++)
+            w[k] -= h_i * v[i][k];
+        }
+      }
+
+      B->multiply_with_vector(w, work);
+      Scalar norm_squared = 0.0;
+      for(int k = 0; k < size; k++)
+        norm_squared += w[k] * work[k];
+      return std::sqrt(std::abs(norm_squared));
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::solve(int n_eigs, double target_value, double tol, int max_iter)
+    {
+      free();
+
+      size = A->get_size();
+      if((int)B->get_size() != size)
+        throw Exceptions::LengthException(2, B->get_size(), size);
+      if(n_eigs < 1)
+        throw Exceptions::ValueException("n_eigs", n_eigs, 1);
+      n_eigs = std::min(n_eigs, size);
+
+      // Dimension of the Krylov subspace, and the number of Ritz vectors kept on restarts.
+      int m = std::min(size, std::max(2 * n_eigs + 1, n_eigs + 20));
+      int kept = std::min(m - 1, n_eigs + (m - n_eigs) / 2);
+
+      // Assemble A - target_value * B.
+      shifted_matrix = create_matrix<Scalar>();
+      shifted_rhs = create_vector<Scalar>();
+      shifted_matrix->prealloc(size);
+      for(int j = 0; j < size; j++)
+      {
+        for(int k = A->get_Ap()[j]; k < A->get_Ap()[j + 1]; k++)
+          shifted_matrix->pre_add_ij(A->get_Ai()[k], j);
+        for(int k = B->get_Ap()[j]; k < B->get_Ap()[j + 1]; k++)
+          shifted_matrix->pre_add_ij(B->get_Ai()[k], j);
+      }
+      shifted_matrix->alloc();
+      for(int j = 0; j < size; j++)
+      {
+        for(int k = A->get_Ap()[j]; k < A->get_Ap()[j + 1]; k++)
+          shifted_matrix->add(A->get_Ai()[k], j, A->get_Ax()[k]);
+        for(int k = B->get_Ap()[j]; k < B->get_Ap()[j + 1]; k++)
+          shifted_matrix->add(B->get_Ai()[k], j, -target_value * B->get_Ax()[k]);
+      }
+      shifted_matrix->finish();
+      shifted_rhs->alloc(size);
+      shifted_solver = create_linear_solver<Scalar>(shifted_matrix, shifted_rhs);
+      shifted_factorized = false;
+
+      work = new Scalar[size];
+      Scalar** v = new Scalar*[m + 1];
+      for(int i = 0; i <= m; i++)
+        v[i] = new Scalar[size];
+      double** T = new_matrix<double>(m, m);
+      double** T_copy = new_matrix<double>(m, m);
+      double** Y = new_matrix<double>(m, m);
+      double* theta = new double[m];
+      Scalar* h = new Scalar[m + 1];
+      int* order = new int[m];
+
+      // Deterministic starting vector.
+      unsigned int seed = 12345;
+      for(int k = 0; k < size; k++)
+      {
+        seed = seed * 1103515245 + 12345;
+        v[0][k] = 0.5 + (double)((seed >> 16) & 0x7fff) / 32768.0;
+      }
+      memset(h, 0, (m + 1) * sizeof(Scalar));
+      double v0_norm = orthogonalize(v, 0, v[0], h);
+      for(int k = 0; k < size; k++)
+        v[0][k] /= v0_norm;
+
+      int start = 0;
+      double beta = 0.0;
+      bool converged = false;
+      for(int restart = 0; restart <= max_iter && !converged; restart++)
+      {
+        // Extend the Lanczos factorization to m vectors.
+        for(int j = start; j < m; j++)
+        {
+          apply_operator(v[j], v[j + 1]);
+          memset(h, 0, (m + 1) * sizeof(Scalar));
+          beta = orthogonalize(v, j + 1, v[j + 1], h);
+          for(int i = 0; i <= j; i++)
+            T[i][j] = T[j][i] = h[i];
+
+          if(j + 1 < m)
+          {
+            T[j + 1][j] = T[j][j + 1] = beta;
+
+            // Invariant subspace found, continue with a new random vector.
+            if(beta <= 1e-12 * std::abs(T[j][j]))
+            {
+              for(int k = 0; k < size; k++)
+              {
+                seed = seed * 1103515245 + 12345;
+                v[j + 1][k] = (double)((seed >> 16) & 0x7fff) / 32768.0 - 0.5;
+              }
+              memset(h, 0, (m + 1) * sizeof(Scalar));
+              beta = orthogonalize(v, j + 1, v[j + 1], h);
+              T[j + 1][j] = T[j][j + 1] = 0.0;
+            }
+          }
+          if(beta > 0.0)
+            for(int k = 0; k < size; k++)
+              v[j + 1][k] /= beta;
+        }
+
+        // Ritz values of the shift-inverted operator.
+        for(int i = 0; i < m; i++)
+          for(int j = 0; j < m; j++)
+            T_copy[i][j] = T[i][j];
+        symmetric_dense_eigen(m, T_copy, theta, Y);
+        for(int i = 0; i < m; i++)
+          order[i] = i;
+        std::sort(order, order + m, RitzValueComparator(theta));
+
+        // Residual of a Ritz pair is |beta * Y[m - 1][i]|.
+        converged = true;
+        for(int i = 0; i < n_eigs; i++)
+          if(std::abs(beta * Y[m - 1][order[i]]) > tol * std::abs(theta[order[i]]))
+            converged = false;
+        if(converged || m == size || restart == max_iter)
+        {
+          converged = converged || m == size;
+          break;
+        }
+
+        // Thick restart: keep the best Ritz vectors and the residual vector.
+        Scalar** v_new = new Scalar*[kept];
+        for(int i = 0; i < kept; i++)
+        {
+          v_new[i] = new Scalar[size];
+          memset(v_new[i], 0, size * sizeof(Scalar));
+          for(int j = 0; j < m; j++)
+          {
+            double y = Y[j][order[i]];
+            for(int k = 0; k < size; k++)
+              v_new[i][k] += y * v[j][k];
+          }
+        }
+        for(int i = 0; i < kept; i++)
+        {
+          memcpy(v[i], v_new[i], size * sizeof(Scalar));
+          delete [] v_new[i];
+        }
+        delete [] v_new;
+        memcpy(v[kept], v[m], size * sizeof(Scalar));
+
+        for(int i = 0; i < m; i++)
+          for(int j = 0; j < m; j++)
+            T[i][j] = 0.0;
+        for(int i = 0; i < kept; i++)
+        {
+          T[i][i] = theta[order[i]];
+          T[i][kept] = T[kept][i] = beta * Y[m - 1][order[i]];
+        }
+        start = kept;
+      }
+
+      if(!converged)
+        this->warn("EigenSolver: not all of the %d eigenpairs converged to the tolerance %g.", n_eigs, tol);
+
+      // Eigenpairs of the original problem, sorted by the eigenvalues.
+      this->n_eigs = n_eigs;
+      double* values = new double[n_eigs];
+      int* value_order = new int[n_eigs];
+      for(int i = 0; i < n_eigs; i++)
+      {
+        values[i] = target_value + 1.0 / theta[order[i]];
+        value_order[i] = i;
+      }
+      std::sort(value_order, value_order + n_eigs, EigenvalueComparator(values));
+
+      eigenvalues = new double[n_eigs];
+      eigenvectors = new Scalar*[n_eigs];
+      for(int i = 0; i < n_eigs; i++)
+      {
+        int ritz_i = order[value_order[i]];
+        eigenvalues[i] = values[value_order[i]];
+        eigenvectors[i] = new Scalar[size];
+        memset(eigenvectors[i], 0, size * sizeof(Scalar));
+        for(int j = 0; j < m; j++)
+        {
+          double y = Y[j][ritz_i];
+          for(int k = 0; k < size; k++)
+            eigenvectors[i][k] += y * v[j][k];
+        }
+      }
+
+      delete [] values;
+      delete [] value_order;
+      for(int i = 0; i <= m; i++)
+        delete [] v[i];
+      delete [] v;
+      delete [] T;
+      delete [] T_copy;
+      delete [] Y;
+      delete [] theta;
+      delete [] h;
+      delete [] order;
+      delete [] work;
+      work = NULL;
+      delete shifted_solver;
+      delete shifted_matrix;
+      delete shifted_rhs;
+      shifted_solver = NULL;
+      shifted_matrix = NULL;
+      shifted_rhs = NULL;
+    }
+
+    template class HERMES_API EigenSolver<double>;
+  }
+}
+#endif
@@ -0,0 +1,883 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file krylov_solver.cpp
+\brief KrylovSolver class, in-tree iterative solvers (CG, BiCGStab, GMRES) working on CSCMatrix.
+*/
+#include "config.h"
+#ifdef WITH_UMFPACK
+#include "krylov_solver.h"
+#include "callstack.h"
+
+/// Number of entries summed up by one thread in dot products.
+#define KRYLOV_DOT_CHUNK 4096
+
+namespace Hermes
+{
+  namespace Preconditioners
+  {
+    static inline double conj_value(double x) { return x; }
+    static inline std::complex<double> conj_value(std::complex<double> x) { return std::conj(x); }
+
+    template<typename Scalar>
+    BlockJacobiKrylovPrecond<Scalar>::BlockJacobiKrylovPrecond(int block_size) : block_size(block_size), size(0), inv_blocks(NULL)
+    {
+      if(block_size < 1)
+        throw Exceptions::ValueException("block_size", block_size, 1);
+    }
+
+    template<typename Scalar>
+    BlockJacobiKrylovPrecond<Scalar>::~BlockJacobiKrylovPrecond()
+    {
+      if(inv_blocks != NULL)
+        delete [] inv_blocks;
+    }
+
+    template<typename Scalar>
+    void BlockJacobiKrylovPrecond<Scalar>::compute(unsigned int size, int* Ap, int* Ai, Scalar* Ax)
+    {
+      if(inv_blocks != NULL)
+        delete [] inv_blocks;
+
+      this->size = size;
+      int num_blocks = (size + block_size - 1) / block_size;
+      inv_blocks = new Scalar[num_blocks * block_size * block_size];
+      bool singular = false;
+
+#pragma omp parallel for schedule(static)
+      for(int block_i = 0; block_i < num_blocks; block_i++)
+      {
+        int first = block_i * block_size;
+        int n = std::min(block_size, (int)size - first);
+        Scalar* inv = inv_blocks + block_i * block_size * block_size;
+
+        // Gather the block, and set inv to identity.
+        Scalar* a = new Scalar[n * n];
+        for(int i = 0; i < n * n; i++)
+        {
+          a[i] = 0.0;
+          inv[i] = 0.0;
+        }
+        for(int i = 0; i < n; i++)
+        {
+          inv[i * n + i] = 1.0;
+          for(int k = Ap[first + i]; k < Ap[first + i + 1]; k++)
+            if(Ai[k] >= first && Ai[k] < first + n)
+              a[i * n + Ai[k] - first] = Ax[k];
+        }
+
+        // Gauss-Jordan elimination with partial pivoting.
+        for(int col = 0; col < n; col++)
+        {
+          int pivot = col;
+          for(int i = col + 1; i < n; i++)
+            if(std::abs(a[i * n + col]) > std::abs(a[pivot * n + col]))
+              pivot = i;
+          if(a[pivot * n + col] == Scalar(0.0))
+          {
+            singular = true;
+            break;
+          }
+          if(pivot != col)
+            for(int j = 0; j < n; j++)
+            {
+              std::swap(a[pivot * n + j], a[col * n + j]);
+              std::swap(inv[pivot * n + j], inv[col * n + j]);
+            }
+
+          Scalar d = Scalar(1.0) / a[col * n + col];
+          for(int j = 0; j < n; j++)
+          {
+            a[col * n + j] *= d;
+            inv[col * n + j] *= d;
+          }
+          for(int i = 0; i < n; i++)
+          {
+            if(i == col || a[i * n + col] == Scalar(0.0))
+              continue;
+            Scalar f = a[i * n + col];
+            for(int j = 0; j < n; j++)
+            {
+              a[i * n + j] -= f * a[col * n + j];
+              inv[i * n + j] -= f * inv[col * n + j];
+            }
+          }
+        }
+        delete [] a;
+      }
+
+      if(singular)
+        throw Exceptions::Exception("Singular diagonal block in BlockJacobiKrylovPrecond::compute().");
+    }
+
+    template<typename Scalar>
+    void BlockJacobiKrylovPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      int num_blocks = (size + block_size - 1) / block_size;
+#pragma omp parallel for schedule(static)
+      for(int block_i = 0; block_i < num_blocks; block_i++)
+      {
+        int first = block_i * block_size;
+        int n = std::min(block_size, (int)size - first);
+        Scalar* inv = inv_blocks + block_i * block_size * block_size;
+        for(int i = 0; i < n; i++)
+        {
+          Scalar sum = 0.0;
+          for(int j = 0; j < n; j++)
+            sum += inv[i * n + j] * r[first + j];
+          z[first + i] = sum;
+        }
+      }
+    }
+
+    /// Finds the positions of the diagonal entries in a CSR matrix.
+    static int* find_diagonal(unsigned int size, int* Ap, int* Ai)
+    {
+      int* diag = new int[size];
+      bool missing = false;
+#pragma omp parallel for schedule(static)
+      for(int i = 0; i < (int)size; i++)
+      {
+        diag[i] = -1;
+        for(int k = Ap[i]; k < Ap[i + 1]; k++)
+          if(Ai[k] == i)
+          {
+            diag[i] = k;
+            break;
+          }
+        if(diag[i] == -1)
+          missing = true;
+      }
+      if(missing)
+      {
+        delete [] diag;
+        throw Exceptions::Exception("Missing diagonal entry in a matrix to be preconditioned.");
+      }
+      return diag;
+    }
+
+    template<typename Scalar>
+    SSORKrylovPrecond<Scalar>::SSORKrylovPrecond(double omega) : omega(omega), size(0), Ap(NULL), Ai(NULL), Ax(NULL), diag(NULL)
+    {
+      if(omega <= 0.0 || omega >= 2.0)
+        throw Exceptions::ValueException("omega", omega, 0.0, 2.0);
+    }
+
+    template<typename Scalar>
+    SSORKrylovPrecond<Scalar>::~SSORKrylovPrecond()
+    {
+      if(diag != NULL)
+        delete [] diag;
+    }
+
+    template<typename Scalar>
+    void SSORKrylovPrecond<Scalar>::compute(unsigned int size, int* Ap, int* Ai, Scalar* Ax)
+    {
+      if(diag != NULL)
+        delete [] diag;
+      diag = NULL;
+      this->size = size;
+      this->Ap = Ap;
+      this->Ai = Ai;
+      this->Ax = Ax;
+      diag = find_diagonal(size, Ap, Ai);
+    }
+
+    template<typename Scalar>
+    void SSORKrylovPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      // M = omega / (2 - omega) * (D / omega + L) * D^{-1} * (D / omega + U).
+      // Forward sweep.
+      for(int i = 0; i < (int)size; i++)
+      {
+        Scalar sum = r[i];
+        for(int k = Ap[i]; k < diag[i]; k++)
+          sum -= Ax[k] * z[Ai[k]];
+        z[i] = sum * omega / Ax[diag[i]];
+      }
+      // Diagonal scaling.
+      for(int i = 0; i < (int)size; i++)
+        z[i] *= Ax[diag[i]] * ((2.0 - omega) / omega);
+      // Backward sweep.
+      for(int i = (int)size - 1; i >= 0; i--)
+      {
+        Scalar sum = z[i];
+        for(int k = diag[i] + 1; k < Ap[i + 1]; k++)
+          sum -= Ax[k] * z[Ai[k]];
+        z[i] = sum * omega / Ax[diag[i]];
+      }
+    }
+
+    template<typename Scalar>
+    ILU0KrylovPrecond<Scalar>::ILU0KrylovPrecond() : size(0), Ap(NULL), Ai(NULL), LU(NULL), diag(NULL)
+    {
+    }
+
+    template<typename Scalar>
+    ILU0KrylovPrecond<Scalar>::~ILU0KrylovPrecond()
+    {
+      if(LU != NULL)
+        delete [] LU;
+      if(diag != NULL)
+        delete [] diag;
+    }
+
+    template<typename Scalar>
+    void ILU0KrylovPrecond<Scalar>::compute(unsigned int size, int* Ap, int* Ai, Scalar* Ax)
+    {
+      if(LU != NULL)
+        delete [] LU;
+      if(diag != NULL)
+        delete [] diag;
+      diag = NULL;
+
+      this->size = size;
+      this->Ap = Ap;
+      this->Ai = Ai;
+      LU = new Scalar[Ap[size]];
+      memcpy(LU, Ax, Ap[size] * sizeof(Scalar));
+      diag = find_diagonal(size, Ap, Ai);
+
+      // IKJ variant, position of the entries of the current row in iw.
+      int* iw = new int[size];
+      for(unsigned int i = 0; i < size; i++)
+        iw[i] = -1;
+
+      for(int i = 0; i < (int)size; i++)
+      {
+        for(int k = Ap[i]; k < Ap[i + 1]; k++)
+          iw[Ai[k]] = k;
+
+        for(int k = Ap[i]; k < diag[i]; k++)
+        {
+          int row_k = Ai[k];
+          if(LU[diag[row_k]] == Scalar(0.0))
+          {
+            delete [] iw;
+            throw Exceptions::Exception("Zero pivot in ILU0KrylovPrecond::compute().");
+          }
+          LU[k] /= LU[diag[row_k]];
+          for(int kk = diag[row_k] + 1; kk < Ap[row_k + 1]; kk++)
+            if(iw[Ai[kk]] != -1)
+              LU[iw[Ai[kk]]] -= LU[k] * LU[kk];
+        }
+
+        for(int k = Ap[i]; k < Ap[i + 1]; k++)
+          iw[Ai[k]] = -1;
+      }
+      delete [] iw;
+    }
+
+    template<typename Scalar>
+    void ILU0KrylovPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      // L has unit diagonal.
+      for(int i = 0; i < (int)size; i++)
+      {
+        Scalar sum = r[i];
+        for(int k = Ap[i]; k < diag[i]; k++)
+          sum -= LU[k] * z[Ai[k]];
+        z[i] = sum;
+      }
+      for(int i = (int)size - 1; i >= 0; i--)
+      {
+        Scalar sum = z[i];
+        for(int k = diag[i] + 1; k < Ap[i + 1]; k++)
+          sum -= LU[k] * z[Ai[k]];
+        z[i] = sum / LU[diag[i]];
+      }
+    }
+
+    template class HERMES_API KrylovPrecond<double>;
+    template class HERMES_API KrylovPrecond<std::complex<double> >;
+    template class HERMES_API BlockJacobiKrylovPrecond<double>;
+    template class HERMES_API BlockJacobiKrylovPrecond<std::complex<double> >;
+    template class HERMES_API SSORKrylovPrecond<double>;
+    template class HERMES_API SSORKrylovPrecond<std::complex<double> >;
+    template class HERMES_API ILU0KrylovPrecond<double>;
+    template class HERMES_API ILU0KrylovPrecond<std::complex<double> >;
+  }
+
+  namespace Solvers
+  {
+    template<typename Scalar>
+    KrylovSolver<Scalar>::KrylovSolver(CSCMatrix<Scalar> *m, UMFPackVector<Scalar> *rhs)
+      : IterSolver<Scalar>(), m(m), rhs(rhs), method(KRYLOV_GMRES), gmres_restart(30), block_size(4),
+      pc(NULL), own_pc(false), pc_computed(false), factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH),
+      csr_size(0), csr_Ap(NULL), csr_Ai(NULL), csr_Ax(NULL), dot_partials(NULL), num_iters(0), residual(0.0)
+    {
+    }
+
+    template<typename Scalar>
+    KrylovSolver<Scalar>::~KrylovSolver()
+    {
+      if(own_pc)
+        delete pc;
+      free_csr();
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_solver(const char *name)
+    {
+      if(name == NULL || strcasecmp(name, "gmres") == 0)
+        method = KRYLOV_GMRES;
+      else if(strcasecmp(name, "cg") == 0)
+        method = KRYLOV_CG;
+      else if(strcasecmp(name, "bicgstab") == 0)
+        method = KRYLOV_BICGSTAB;
+      else
+      {
+        this->warn("Unknown iterative method %s, using GMRES.", name);
+        method = KRYLOV_GMRES;
+      }
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_gmres_restart(int restart)
+    {
+      if(restart < 1)
+        throw Exceptions::ValueException("restart", restart, 1);
+      this->gmres_restart = restart;
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_block_size(int block_size)
+    {
+      if(block_size < 1)
+        throw Exceptions::ValueException("block_size", block_size, 1);
+      this->block_size = block_size;
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_precond(const char *name)
+    {
+      KrylovPrecond<Scalar>* new_pc = NULL;
+      if(name == NULL || strcasecmp(name, "none") == 0)
+        new_pc = NULL;
+      else if(strcasecmp(name, "jacobi") == 0)
+        new_pc = new BlockJacobiKrylovPrecond<Scalar>(1);
+      else if(strcasecmp(name, "block-jacobi") == 0)
+        new_pc = new BlockJacobiKrylovPrecond<Scalar>(block_size);
+      else if(strcasecmp(name, "ssor") == 0)
+        new_pc = new SSORKrylovPrecond<Scalar>();
+      else if(strcasecmp(name, "ilu") == 0 || strcasecmp(name, "ilu0") == 0)
+        new_pc = new ILU0KrylovPrecond<Scalar>();
+      else
+        this->warn("Unknown preconditioner %s, not preconditioning.", name);
+
+      set_precond(new_pc);
+      own_pc = (new_pc != NULL);
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_precond(KrylovPrecond<Scalar> *pc)
+    {
+      if(own_pc)
+        delete this->pc;
+      this->pc = pc;
+      this->own_pc = false;
+      this->pc_computed = false;
+      this->precond_yes = (pc != NULL);
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_precond(Precond<Scalar> *pc)
+    {
+      throw Exceptions::Exception("KrylovSolver can only be used with preconditioners derived from KrylovPrecond.");
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_factorization_scheme(FactorizationScheme reuse_scheme)
+    {
+      factorization_scheme = reuse_scheme;
+    }
+
+    template<typename Scalar>
+    int KrylovSolver<Scalar>::get_matrix_size()
+    {
+      return m->get_size();
+    }
+
+    template<typename Scalar>
+    int KrylovSolver<Scalar>::get_num_iters()
+    {
+      return num_iters;
+    }
+
+    template<typename Scalar>
+    double KrylovSolver<Scalar>::get_residual()
+    {
+      return residual;
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::free_csr()
+    {
+      if(csr_Ap != NULL)
+        delete [] csr_Ap;
+      if(csr_Ai != NULL)
+        delete [] csr_Ai;
+      if(csr_Ax != NULL)
+        delete [] csr_Ax;
+      if(dot_partials != NULL)
+        delete [] dot_partials;
+      csr_Ap = NULL;
+      csr_Ai = NULL;
+      csr_Ax = NULL;
+      dot_partials = NULL;
+      csr_size = 0;
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::setup_csr()
+    {
+      free_csr();
+
+      // The row-wise storage of A is the column-wise storage of A^T.
+      unsigned int n = m->get_size();
+      int* Ap = m->get_Ap();
+      int* Ai = m->get_Ai();
+      Scalar* Ax = m->get_Ax();
+      int nnz = Ap[n];
+
+      csr_size = n;
+      csr_Ap = new int[n + 1];
+      csr_Ai = new int[nnz];
+      csr_Ax = new Scalar[nnz];
+      memset(csr_Ap, 0, (n + 1) * sizeof(int));
+
+      for(int k = 0; k < nnz; k++)
+        csr_Ap[Ai[k] + 1]++;
+      for(unsigned int i = 0; i < n; i++)
+        csr_Ap[i + 1] += csr_Ap[i];
+
+      // Columns are processed in ascending order, so column indices are sorted within the rows.
+      int* next = new int[n];
+      memcpy(next, csr_Ap, n * sizeof(int));
+      for(unsigned int j = 0; j < n; j++)
+        for(int k = Ap[j]; k < Ap[j + 1]; k++)
+        {
+          int position = next[Ai[k]]++;
+          csr_Ai[position] = j;
+          csr_Ax[position] = Ax[k];
+        }
+      delete [] next;
+
+      dot_partials = new Scalar[(n + KRYLOV_DOT_CHUNK - 1) / KRYLOV_DOT_CHUNK + 1];
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::multiply(Scalar* x, Scalar* y)
+    {
+#pragma omp parallel for schedule(static)
+      for(int i = 0; i < (int)csr_size; i++)
+      {
+        Scalar sum = 0.0;
+        for(int k = csr_Ap[i]; k < csr_Ap[i + 1]; k++)
+          sum += csr_Ax[k] * x[csr_Ai[k]];
+        y[i] = sum;
+      }
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::precondition(Scalar* r, Scalar* z)
+    {
+      if(pc != NULL)
+        pc->apply(r, z);
+      else
+        memcpy(z, r, csr_size * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    Scalar KrylovSolver<Scalar>::dot(Scalar* x, Scalar* y)
+    {
+      int num_chunks = (csr_size + KRYLOV_DOT_CHUNK - 1) / KRYLOV_DOT_CHUNK;
+#pragma omp parallel for schedule(static)
+      for(int chunk_i = 0; chunk_i < num_chunks; chunk_i++)
+      {
+        int end = std::min((int)csr_size, (chunk_i + 1) * KRYLOV_DOT_CHUNK);
+        Scalar sum = 0.0;
+        for(int i = chunk_i * KRYLOV_DOT_CHUNK; i < end; i++)
+          sum += conj_value(x[i]) * y[i];
+        dot_partials[chunk_i] = sum;
+      }
+
+      // Fixed order of summation.
+      Scalar result = 0.0;
+      for(int chunk_i = 0; chunk_i < num_chunks; chunk_i++)
+        result += dot_partials[chunk_i];
+      return result;
+    }
+
+    template<typename Scalar>
+    double KrylovSolver<Scalar>::norm(Scalar* x)
+    {
+      return std::sqrt(std::abs(dot(x, x)));
+    }
+
+    template<typename Scalar>
+    int KrylovSolver<Scalar>::solve_cg(Scalar* b, Scalar* x, double b_norm)
+    {
+      int n = csr_size;
+      Scalar* r = new Scalar[n];
+      Scalar* z = new Scalar[n];
+      Scalar* p = new Scalar[n];
+      Scalar* q = new Scalar[n];
+
+      // x = 0.
+      memcpy(r, b, n * sizeof(Scalar));
+      precondition(r, z);
+      memcpy(p, z, n * sizeof(Scalar));
+      Scalar rz = dot(r, z);
+
+      int it = 0;
+      residual = 1.0;
+      while(it < this->max_iters && residual > this->tolerance)
+      {
+        multiply(p, q);
+        Scalar pq = dot(p, q);
+        if(pq == Scalar(0.0))
+          break;
+        Scalar alpha = rz / pq;
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+        {
+          x[i] += alpha * p[i];
+          r[i] -= alpha * q[i];
+        }
+        it++;
+        residual = norm(r) / b_norm;
+        if(residual <= this->tolerance)
+          break;
+
+        precondition(r, z);
+        Scalar rz_new = dot(r, z);
+        Scalar beta = rz_new / rz;
+        rz = rz_new;
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+          p[i] = z[i] + beta * p[i];
+      }
+
+      delete [] r;
+      delete [] z;
+      delete [] p;
+      delete [] q;
+      return it;
+    }
+
+    template<typename Scalar>
+    int KrylovSolver<Scalar>::solve_bicgstab(Scalar* b, Scalar* x, double b_norm)
+    {
+      int n = csr_size;
+      Scalar* r = new Scalar[n];
+      Scalar* r_hat = new Scalar[n];
+      Scalar* p = new Scalar[n];
+      Scalar* v = new Scalar[n];
+      Scalar* y = new Scalar[n];
+      Scalar* s = new Scalar[n];
+      Scalar* z = new Scalar[n];
+      Scalar* t = new Scalar[n];
+
+      // x = 0.
+      memcpy(r, b, n * sizeof(Scalar));
+      memcpy(r_hat, b, n * sizeof(Scalar));
+      memset(p, 0, n * sizeof(Scalar));
+      memset(v, 0, n * sizeof(Scalar));
+      Scalar rho = 1.0, alpha = 1.0, omega = 1.0;
+
+      int it = 0;
+      residual = 1.0;
+      while(it < this->max_iters && residual > this->tolerance)
+      {
+        Scalar rho_new = dot(r_hat, r);
+        if(rho_new == Scalar(0.0))
+          break;
+        Scalar beta = (rho_new / rho) * (alpha / omega);
+        rho = rho_new;
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+          p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+        precondition(p, y);
+        multiply(y, v);
+        Scalar r_hat_v = dot(r_hat, v);
+        if(r_hat_v == Scalar(0.0))
+          break;
+        alpha = rho / r_hat_v;
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+          s[i] = r[i] - alpha * v[i];
+
+        it++;
+        residual = norm(s) / b_norm;
+        if(residual <= this->tolerance)
+        {
+#pragma omp parallel for schedule(static)
+          for(int i = 0; i < n; i++)
+            x[i] += alpha * y[i];
+          break;
+        }
+
+        precondition(s, z);
+        multiply(z, t);
+        Scalar tt = dot(t, t);
+        if(tt == Scalar(0.0))
+          break;
+        omega = dot(t, s) / tt;
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+        {
+          x[i] += alpha * y[i] + omega * z[i];
+          r[i] = s[i] - omega * t[i];
+        }
+        residual = norm(r) / b_norm;
+        if(omega == Scalar(0.0))
+          break;
+      }
+
+      delete [] r;
+      delete [] r_hat;
+      delete [] p;
+      delete [] v;
+      delete [] y;
+      delete [] s;
+      delete [] z;
+      delete [] t;
+      return it;
+    }
+
+    template<typename Scalar>
+    int KrylovSolver<Scalar>::solve_gmres(Scalar* b, Scalar* x, double b_norm)
+    {
+      int n = csr_size;
+      int restart = gmres_restart;
+
+      // Krylov basis, Hessenberg matrix (column-wise), Givens rotations and the rhs of the least-squares problem.
+      Scalar** V = new Scalar*[restart + 1];
+      for(int i = 0; i <= restart; i++)
+        V[i] = new Scalar[n];
+      Scalar* H = new Scalar[(restart + 1) * restart];
+      double* cs = new double[restart];
+      Scalar* sn = new Scalar[restart];
+      Scalar* g = new Scalar[restart + 1];
+      Scalar* y = new Scalar[restart];
+      Scalar* w = new Scalar[n];
+      Scalar* z = new Scalar[n];
+
+      int it = 0;
+      residual = 1.0;
+      while(it < this->max_iters)
+      {
+        // r = b - A x.
+        multiply(x, w);
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+          w[i] = b[i] - w[i];
+        double beta = norm(w);
+        residual = beta / b_norm;
+        if(residual <= this->tolerance || beta == 0.0)
+          break;
+
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+          V[0][i] = w[i] / beta;
+        g[0] = beta;
+        for(int i = 1; i <= restart; i++)
+          g[i] = 0.0;
+
+        int j = 0;
+        while(j < restart && it < this->max_iters)
+        {
+          Scalar* h = H + j * (restart + 1);
+          precondition(V[j], z);
+          multiply(z, w);
+
+          // Modified Gram-Schmidt.
+          for(int i = 0; i <= j; i++)
+          {
+            h[i] = dot(V[i], w);
+            Scalar hi = h[i];
+            Scalar* Vi = V[i];
+#pragma omp parallel for schedule(static)
+            for(int k = 0; k < n; k++)
+              w[k] -= hi * Vi[k];
+          }
+          double h_next = norm(w);
+          h[j + 1] = h_next;
+          if(h_next != 0.0)
+          {
+            Scalar* Vj = V[j + 1];
+#pragma omp parallel for schedule(static)
+            for(int k = 0; k < n; k++)
+              Vj[k] = w[k] / h_next;
+          }
+
+          // Apply the previous rotations to the new column.
+          for(int i = 0; i < j; i++)
+          {
+            Scalar temp = cs[i] * h[i] + sn[i] * h[i + 1];
+            h[i + 1] = -conj_value(sn[i]) * h[i] + cs[i] * h[i + 1];
+            h[i] = temp;
+          }
+
+          // New rotation eliminating h[j + 1].
+          double a_abs = std::abs(h[j]);
+          if(a_abs == 0.0)
+          {
+            cs[j] = 0.0;
+            sn[j] = 1.0;
+          }
+          else
+          {
+            double nu = std::sqrt(a_abs * a_abs + std::abs(h[j + 1]) * std::abs(h[j + 1]));
+            cs[j] = a_abs / nu;
+            sn[j] = (h[j] / a_abs) * conj_value(h[j + 1]) / nu;
+          }
+          h[j] = cs[j] * h[j] + sn[j] * h[j + 1];
+          h[j + 1] = 0.0;
+          g[j + 1] = -conj_value(sn[j]) * g[j];
+          g[j] = cs[j] * g[j];
+
+          j++;
+          it++;
+          residual = std::abs(g[j]) / b_norm;
+          if(residual <= this->tolerance || h_next == 0.0)
+            break;
+        }
+
+        // Solve the upper triangular system H y = g.
+        for(int i = j - 1; i >= 0; i--)
+        {
+          Scalar sum = g[i];
+          for(int k = i + 1; k < j; k++)
+            sum -= H[k * (restart + 1) + i] * y[k];
+          y[i] = sum / H[i * (restart + 1) + i];
+        }
+
+        // x += M^{-1} V y.
+        memset(w, 0, n * sizeof(Scalar));
+        for(int i = 0; i < j; i++)
+        {
+          Scalar yi = y[i];
+          Scalar* Vi = V[i];
+#pragma omp parallel for schedule(static)
+          for(int k = 0; k < n; k++)
+            w[k] += yi * Vi[k];
+        }
+        precondition(w, z);
+#pragma omp parallel for schedule(static)
+        for(int k = 0; k < n; k++)
+          x[k] += z[k];
+
+        if(residual <= this->tolerance)
+          break;
+      }
+
+      for(int i = 0; i <= restart; i++)
+        delete [] V[i];
+      delete [] V;
+      delete [] H;
+      delete [] cs;
+      delete [] sn;
+      delete [] g;
+      delete [] y;
+      delete [] w;
+      delete [] z;
+      return it;
+    }
+
+    template<typename Scalar>
+    bool KrylovSolver<Scalar>::solve()
+    {
+      assert(m != NULL);
+      assert(rhs != NULL);
+      assert(m->get_size() == rhs->length());
+
+      this->tick();
+
+      bool reuse = (factorization_scheme == HERMES_REUSE_FACTORIZATION_COMPLETELY && csr_Ap != NULL && csr_size == m->get_size());
+      if(!reuse)
+      {
+        setup_csr();
+        pc_computed = false;
+      }
+      if(pc != NULL && !pc_computed)
+      {
+        pc->compute(csr_size, csr_Ap, csr_Ai, csr_Ax);
+        pc_computed = true;
+      }
+
+      int n = csr_size;
+      delete [] this->sln;
+      this->sln = new Scalar[n];
+      memset(this->sln, 0, n * sizeof(Scalar));
+
+      Scalar* b = rhs->get_c_array();
+      double b_norm = norm(b);
+      this->error = 0;
+      if(b_norm == 0.0)
+      {
+        num_iters = 0;
+        residual = 0.0;
+      }
+      else
+      {
+        switch(method)
+        {
+        case KRYLOV_CG:
+          num_iters = solve_cg(b, this->sln, b_norm);
+          break;
+        case KRYLOV_BICGSTAB:
+          num_iters = solve_bicgstab(b, this->sln, b_norm);
+          break;
+        case KRYLOV_GMRES:
+          num_iters = solve_gmres(b, this->sln, b_norm);
+          break;
+        }
+      }
+
+      // The recursively updated residuals may drift from the true ones (BiCGStab), check the true residual.
+      if(b_norm != 0.0)
+      {
+        Scalar* r = new Scalar[n];
+        multiply(this->sln, r);
+#pragma omp parallel for schedule(static)
+        for(int i = 0; i < n; i++)
+          r[i] = b[i] - r[i];
+        residual = norm(r) / b_norm;
+        delete [] r;
+      }
+
+      this->tick();
+      this->time = this->last();
+
+      if(residual > this->tolerance)
+      {
+        this->warn("KrylovSolver did not converge in %d iterations, relative residual: %g.", num_iters, residual);
+        this->error = -1;
+        return false;
+      }
+      return true;
+    }
+
+    template class HERMES_API KrylovSolver<double>;
+    template class HERMES_API KrylovSolver<std::complex<double> >;
+  }
+}
+#endif
@@ -27,6 +27,7 @@
 #include "mumps_solver.h"
 #include "newton_solver_nox.h"
 #include "aztecoo_solver.h"
+#include "krylov_solver.h"
 #include "api.h"
 
 using namespace Hermes::Algebra;
@@ -136,6 +137,16 @@ namespace Hermes
           else return new SuperLUSolver<Scalar>(static_cast<SuperLUMatrix<Scalar>*>(matrix), static_cast<SuperLUVector<Scalar>*>(rhs_dummy));
 #else
           throw Hermes::Exceptions::Exception("SuperLU was not installed.");
+#endif
+          break;
+        }
+      case Hermes::SOLVER_KRYLOV:
+        {
+#ifdef WITH_UMFPACK
+          if(rhs != NULL) return new KrylovSolver<Scalar>(static_cast<CSCMatrix<Scalar>*>(matrix), static_cast<UMFPackVector<Scalar>*>(rhs));
+          else return new KrylovSolver<Scalar>(static_cast<CSCMatrix<Scalar>*>(matrix), static_cast<UMFPackVector<Scalar>*>(rhs_dummy));
+#else
+          throw Hermes::Exceptions::Exception("UMFPACK was not installed, KrylovSolver uses its matrix classes.");
 #endif
           break;
         }
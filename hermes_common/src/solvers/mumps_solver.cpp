@@ -121,6 +121,31 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void MumpsMatrix<Scalar>::alloc_from_pattern(const SparsityPattern* pattern)
+    {
+      this->size = pattern->get_size();
+      nnz = pattern->get_nnz();
+
+      const int* pattern_Ap = pattern->get_Ap();
+      Ap = new unsigned int[this->size + 1];
+      for (unsigned int i = 0; i <= this->size; i++)
+        Ap[i] = pattern_Ap[i];
+      Ai = new int[nnz];
+      memcpy(Ai, pattern->get_Ai(), nnz * sizeof(int));
+
+      Ax = new typename mumps_type<Scalar>::mumps_Scalar[nnz];
+      memset(Ax, 0, sizeof(Scalar) * nnz);
+
+      irn = new int[nnz];
+      jcn = new int[nnz];
+      for (unsigned int i = 0; i < nnz; i++)
+      {
+        irn[i] = 1;
+        jcn[i] = 1;
+      }
+    }
+
     template<typename Scalar>
     void MumpsMatrix<Scalar>::free()
     {
@@ -156,6 +156,23 @@ namespace Hermes
       memset(Ax, 0, sizeof(Scalar) * nnz);
     }
 
+    template<typename Scalar>
+    void SuperLUMatrix<Scalar>::alloc_from_pattern(const SparsityPattern* pattern)
+    {
+      this->size = pattern->get_size();
+      nnz = pattern->get_nnz();
+
+      const int* pattern_Ap = pattern->get_Ap();
+      Ap = new unsigned int[this->size + 1];
+      for (unsigned int i = 0; i <= this->size; i++)
+        Ap[i] = pattern_Ap[i];
+      Ai = new int[nnz];
+      memcpy(Ai, pattern->get_Ai(), nnz * sizeof(int));
+
+      Ax = new Scalar[nnz];
+      memset(Ax, 0, sizeof(Scalar) * nnz);
+    }
+
     template<typename Scalar>
     void SuperLUMatrix<Scalar>::free()
     {
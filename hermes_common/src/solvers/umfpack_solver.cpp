@@ -66,12 +66,22 @@ namespace Hermes
       Ap = NULL;
       Ai = NULL;
       Ax = NULL;
+      thread_local_Ax = NULL;
+      thread_local_count = 0;
+      thread_local_buffers = NULL;
+      thread_local_threads = 0;
+      conflict_free_assembling = false;
     }
 
     template<typename Scalar>
     CSCMatrix<Scalar>::CSCMatrix(unsigned int size)
     {
       this->size = size;
+      thread_local_Ax = NULL;
+      thread_local_count = 0;
+      thread_local_buffers = NULL;
+      thread_local_threads = 0;
+      conflict_free_assembling = false;
       this->alloc();
     }
 
@@ -130,9 +140,25 @@ namespace Hermes
       memset(Ax, 0, sizeof(Scalar) * nnz);
     }
 
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::alloc_from_pattern(const SparsityPattern* pattern)
+    {
+      this->size = pattern->get_size();
+      nnz = pattern->get_nnz();
+
+      Ap = new int[this->size + 1];
+      memcpy(Ap, pattern->get_Ap(), (this->size + 1) * sizeof(int));
+      Ai = new int[nnz];
+      memcpy(Ai, pattern->get_Ai(), nnz * sizeof(int));
+
+      Ax = new Scalar[nnz];
+      memset(Ax, 0, sizeof(Scalar) * nnz);
+    }
+
     template<typename Scalar>
     void CSCMatrix<Scalar>::free()
     {
+      free_thread_local_values();
       nnz = 0;
       if(Ap != NULL)
       {
@@ -183,8 +209,15 @@ namespace Hermes
           throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", m, n);
         }
 
+        if(thread_local_Ax != NULL)
+          thread_local_Ax[thread_local_buffers[omp_get_thread_num()]][Ap[n] + pos] += v;
+        else if(conflict_free_assembling)
+          Ax[Ap[n] + pos] += v;
+        else
+        {
 #pragma omp atomic
-        Ax[Ap[n] + pos] += v;
+          Ax[Ap[n] + pos] += v;
+        }
       }
     }
 
@@ -202,9 +235,81 @@ namespace Hermes
           throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", m, n);
         }
 
+        if(thread_local_Ax != NULL)
+          thread_local_Ax[thread_local_buffers[omp_get_thread_num()]][Ap[n] + pos] += v;
+        else if(conflict_free_assembling)
+          Ax[Ap[n] + pos] += v;
+        else
+        {
 #pragma omp critical
-        Ax[Ap[n] + pos] += v;
+          Ax[Ap[n] + pos] += v;
+        }
+      }
+    }
+
+    template<typename Scalar>
+    bool CSCMatrix<Scalar>::begin_thread_local_assembling(int num_buffers, int num_threads)
+    {
+      free_thread_local_values();
+      if(num_buffers < 1 || Ax == NULL)
+        return false;
+
+      thread_local_count = num_buffers;
+      thread_local_Ax = new Scalar*[num_buffers];
+      for(int i = 0; i < num_buffers; i++)
+      {
+        thread_local_Ax[i] = new Scalar[nnz];
+        memset(thread_local_Ax[i], 0, sizeof(Scalar) * nnz);
       }
+      thread_local_threads = std::max(num_threads, 1);
+      thread_local_buffers = new int[thread_local_threads];
+      memset(thread_local_buffers, 0, sizeof(int) * thread_local_threads);
+      return true;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::set_thread_local_buffer(int buffer)
+    {
+      if(thread_local_Ax != NULL)
+        thread_local_buffers[omp_get_thread_num()] = buffer;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::finish()
+    {
+      if(thread_local_Ax == NULL)
+        return;
+
+      // The copies are always summed in the same order, so the result does not depend on
+      // how the threads were scheduled, only on which contributions went to which buffer.
+      int i;
+#pragma omp parallel for private(i) num_threads(thread_local_threads)
+      for(i = 0; i < (int)nnz; i++)
+        for(int thread_i = 0; thread_i < thread_local_count; thread_i++)
+          Ax[i] += thread_local_Ax[thread_i][i];
+
+      free_thread_local_values();
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::set_conflict_free_assembling(bool to_set)
+    {
+      this->conflict_free_assembling = to_set;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::free_thread_local_values()
+    {
+      if(thread_local_Ax == NULL)
+        return;
+      for(int i = 0; i < thread_local_count; i++)
+        delete [] thread_local_Ax[i];
+      delete [] thread_local_Ax;
+      thread_local_Ax = NULL;
+      thread_local_count = 0;
+      delete [] thread_local_buffers;
+      thread_local_buffers = NULL;
+      thread_local_threads = 0;
     }
 
     template<typename Scalar>
@@ -606,6 +711,11 @@ namespace Hermes
     UMFPackVector<Scalar>::UMFPackVector()
     {
       v = NULL;
+      thread_local_v = NULL;
+      thread_local_count = 0;
+      thread_local_buffers = NULL;
+      thread_local_threads = 0;
+      conflict_free_assembling = false;
       this->size = 0;
     }
 
@@ -613,6 +723,11 @@ namespace Hermes
     UMFPackVector<Scalar>::UMFPackVector(unsigned int size)
     {
       v = NULL;
+      thread_local_v = NULL;
+      thread_local_count = 0;
+      thread_local_buffers = NULL;
+      thread_local_threads = 0;
+      conflict_free_assembling = false;
       this->size = size;
       this->alloc(size);
     }
@@ -647,6 +762,7 @@ namespace Hermes
     template<typename Scalar>
     void UMFPackVector<Scalar>::free()
     {
+      free_thread_local_values();
       delete [] v;
       v = NULL;
       this->size = 0;
@@ -661,15 +777,92 @@ namespace Hermes
     template<>
     void UMFPackVector<double>::add(unsigned int idx, double y)
     {
+      if(thread_local_v != NULL)
+        thread_local_v[thread_local_buffers[omp_get_thread_num()]][idx] += y;
+      else if(conflict_free_assembling)
+        v[idx] += y;
+      else
+      {
 #pragma omp atomic
-      v[idx] += y;
+        v[idx] += y;
+      }
     }
 
     template<>
     void UMFPackVector<std::complex<double> >::add(unsigned int idx, std::complex<double> y)
     {
+      if(thread_local_v != NULL)
+        thread_local_v[thread_local_buffers[omp_get_thread_num()]][idx] += y;
+      else if(conflict_free_assembling)
+        v[idx] += y;
+      else
+      {
 #pragma omp critical(UMFPackVector_add)
-      v[idx] += y;
+        v[idx] += y;
+      }
+    }
+
+    template<typename Scalar>
+    bool UMFPackVector<Scalar>::begin_thread_local_assembling(int num_buffers, int num_threads)
+    {
+      free_thread_local_values();
+      if(num_buffers < 1 || v == NULL)
+        return false;
+
+      thread_local_count = num_buffers;
+      thread_local_v = new Scalar*[num_buffers];
+      for(int i = 0; i < num_buffers; i++)
+      {
+        thread_local_v[i] = new Scalar[this->size];
+        memset(thread_local_v[i], 0, sizeof(Scalar) * this->size);
+      }
+      thread_local_threads = std::max(num_threads, 1);
+      thread_local_buffers = new int[thread_local_threads];
+      memset(thread_local_buffers, 0, sizeof(int) * thread_local_threads);
+      return true;
+    }
+
+    template<typename Scalar>
+    void UMFPackVector<Scalar>::set_thread_local_buffer(int buffer)
+    {
+      if(thread_local_v != NULL)
+        thread_local_buffers[omp_get_thread_num()] = buffer;
+    }
+
+    template<typename Scalar>
+    void UMFPackVector<Scalar>::finish()
+    {
+      if(thread_local_v == NULL)
+        return;
+
+      int i;
+#pragma omp parallel for private(i) num_threads(thread_local_threads)
+      for(i = 0; i < (int)this->size; i++)
+        for(int thread_i = 0; thread_i < thread_local_count; thread_i++)
+          v[i] += thread_local_v[thread_i][i];
+
+      free_thread_local_values();
+    }
+
+    template<typename Scalar>
+    void UMFPackVector<Scalar>::set_conflict_free_assembling(bool to_set)
+    {
+      this->conflict_free_assembling = to_set;
+    }
+
+    template<typename Scalar>
+    void UMFPackVector<Scalar>::free_thread_local_values()
+    {
+      if(thread_local_v == NULL)
+        return;
+      for(int i = 0; i < thread_local_count; i++)
+        delete [] thread_local_v[i];
+      delete [] thread_local_v;
+      thread_local_v = NULL;
+      thread_local_count = 0;
+      delete [] thread_local_buffers;
+      thread_local_buffers = NULL;
+      thread_local_threads = 0;
     }
 
     template<typename Scalar>